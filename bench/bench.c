@@ -0,0 +1,558 @@
+#include <getopt.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <prophetic.h>
+#include <timing.h>
+
+/**
+ * INFO: Every benchmark runs a kernel or an algorithm over synthetic prices kept in memory, for each point of a grid
+ * of N, K, single or dual thresholds and keeping items or not:
+ *
+ * --------------------------------------------------
+ * the warmup trials are run and thrown away
+ * each trial is timed as a whole, and divided by the units of work it did (prices, rounds or arms)
+ * the trials stop early once they have taken longer than the budget
+ * the median, the 95th percentile and the minimum of the trials are reported
+ * --------------------------------------------------
+ *
+ * The results are printed, and saved as CSV and JSON so two commits can be compared point by point.
+ */
+
+// the most trials a benchmark is run for
+#define MAX_TRIALS 1000
+// the rounds of the window of the rolling thresholds benchmark
+#define ROLLING_BENCH_ROUNDS 100
+
+/**
+ * @typedef benchContextStruct
+ * @brief The data and the buffers of a point of the grid, shared by its benchmarks
+ *
+ */
+typedef struct benchContextStruct {
+    Bandit b;
+    const char *distribution;
+    double *data;
+    // a copy of data the benchmarks that change the prices work on
+    double *scratch;
+    double *totalOpt;
+    double *totalGain;
+    double *avgLowThreshold;
+    double *avgHighThreshold;
+    double *avgTrades;
+    // METRIC_COUNT arrays of T derived metrics, one after the other
+    double *metrics;
+    Sampler sampler;
+    Threshold *arms;
+    // the algorithmId of an algorithm benchmark
+    uint32_t alg;
+} BenchContext;
+
+/**
+ * @typedef benchStruct
+ * @brief A benchmark, whose run does the work of one trial and returns the units of work it did
+ *
+ */
+typedef struct benchStruct {
+    const char *name;
+    const char *unit;
+    uint64_t (*run)(BenchContext *context);
+    // the work that isn't timed before each trial, can be NULL
+    void (*prepare)(BenchContext *context);
+} Bench;
+
+/**
+ * @typedef benchResultStruct
+ * @brief The nanoseconds per unit of a benchmark at a point of the grid
+ *
+ */
+typedef struct benchResultStruct {
+    char name[48];
+    const char *unit;
+    const char *distribution;
+    char memory[64];
+    uint64_t N;
+    uint32_t thresholds;
+    uint8_t dualThres;
+    uint8_t keepItems;
+    uint32_t trials;
+    double median;
+    double p95;
+    double min;
+} BenchResult;
+
+void printHelp() {
+    printf("Usage:\n"
+           "    propheticBench [options]\n"
+           "    propheticBench -h      # Display this help screen.\n\n"
+           "Runs the kernels (runThreshold, runRound, findOpt, bestHand, normalizePrices,\n"
+           "initThreshold, rollingThresholds, getMetrics, fillNormal, fillExponential,\n"
+           "computePriceStats) and every algorithm on synthetic prices, for each memory\n"
+           "policy, N, K, single and dual thresholds and keeping items or not, and prints\n"
+           "the nanoseconds per unit of work.\n\n"
+           "Options:\n"
+           "    -T <integer>    Rounds of synthetic prices (default = 2000).\n"
+           "    -n <list>       Comma separated prices per round (default = 10,100).\n"
+           "    -k <list>       Comma separated numbers of thresholds (default = 10,20).\n"
+           "    -r <integer>    Trials of each benchmark (default = 5).\n"
+           "    -w <integer>    Warmup trials of each benchmark (default = 1).\n"
+           "    -b <integer>    Stop a benchmark after <integer> ms of trials, once it has\n"
+           "                    a measured one (default = 2000).\n"
+           "    -M <list>       Comma separated memory policies the prices and the results\n"
+           "                    are placed with, as in propheticBandits --memory\n"
+           "                    (default = default).\n"
+           "    -f <text>       Only run the benchmarks whose name contains <text>.\n"
+           "    -o <path>       Save the results in <path>.csv and <path>.json\n"
+           "                    (default = benchResults).\n");
+}
+
+static uint64_t benchRunThreshold(BenchContext *context) {
+    Bandit b = context->b;
+    uint8_t heldItems = 0;
+    double heldItemValue = 0;
+    double gain = 0;
+    for (uint64_t t = 0; t < b.T; t++) {
+        uint32_t trades = 0;
+        Threshold *arm = &context->arms[t % b.K];
+        gain += runThreshold(arm->low, arm->high, b, context->data, &trades, t, &heldItems, &heldItemValue);
+    }
+
+    // the gain is kept, so the calls can't be optimized away
+    context->totalGain[0] = gain;
+    return b.T * b.N;
+}
+
+static uint64_t benchRunRound(BenchContext *context) {
+    Bandit b = context->b;
+    uint8_t heldItems = 0;
+    double heldItemValue = 0;
+    for (uint64_t t = 0; t < b.T; t++) {
+        runRound(&context->arms[t % b.K], b, context->data, context->avgLowThreshold, context->avgHighThreshold,
+                 context->avgTrades, context->totalGain, t, &heldItems, &heldItemValue);
+    }
+
+    return b.T * b.N;
+}
+
+static void resetArms(BenchContext *context) {
+    initThreshold(context->arms, context->b, context->data);
+}
+
+static uint64_t benchFindOpt(BenchContext *context) {
+    Bandit b = context->b;
+    findOpt(context->data, context->totalOpt, context->avgTrades, b, nullptr);
+    return b.T * b.N;
+}
+
+static uint64_t benchBestHand(BenchContext *context) {
+    // every round plays every arm, so fewer rounds are played the more arms there are
+    Bandit b = context->b;
+    uint64_t rounds = 100000 / b.K;
+    b.T = rounds < 10 ? 10 : rounds < b.T ? rounds : b.T;
+    bestHand(context->data, context->totalOpt, context->avgLowThreshold, context->avgHighThreshold, context->avgTrades,
+             b, nullptr);
+    return b.T * b.N * b.K;
+}
+
+static void copyPrices(BenchContext *context) {
+    memcpy(context->scratch, context->data, context->b.T * context->b.N * sizeof(double));
+}
+
+static uint64_t benchNormalizePrices(BenchContext *context) {
+    Bandit b = context->b;
+    normalizePrices(-1, 2, context->scratch, b.T * b.N);
+    return b.T * b.N;
+}
+
+static uint64_t initThresholds(BenchContext *context, uint8_t dynamicThres) {
+    Bandit b = context->b;
+    b.dynamicThres = dynamicThres;
+    uint64_t calls = 1 + 1000000 / b.K;
+    for (uint64_t i = 0; i < calls; i++) {
+        initThreshold(context->arms, b, context->data);
+    }
+
+    return calls * b.K;
+}
+
+static uint64_t benchInitThreshold(BenchContext *context) {
+    return initThresholds(context, 0);
+}
+
+static uint64_t benchInitThresholdDynamic(BenchContext *context) {
+    return initThresholds(context, 1);
+}
+
+static uint64_t benchRollingThresholds(BenchContext *context) {
+    Bandit b = context->b;
+    b.dynamicThres = 1;
+    b.rollingRounds = ROLLING_BENCH_ROUNDS;
+    ThresholdWindow window;
+    if (initThresholdWindow(&window, b)) {
+        return 0;
+    }
+
+    double *threshold = malloc(b.thresholds * sizeof(double));
+    for (uint64_t t = 0; t < b.T; t++) {
+        moveThresholdWindow(&window, b, context->data, t);
+        getWindowThresholds(&window, b, threshold);
+    }
+    free(threshold);
+    freeThresholdWindow(&window);
+
+    return b.T;
+}
+
+static uint64_t benchGetMetrics(BenchContext *context) {
+    Bandit b = context->b;
+    MetricSource source = {context->totalGain, context->totalOpt, context->avgTrades};
+    double *metrics[METRIC_COUNT];
+    for (uint32_t m = 0; m < METRIC_COUNT; m++) {
+        metrics[m] = context->metrics + m * b.T;
+    }
+    getMetrics(&source, 0, b.T, metrics);
+    return b.T;
+}
+
+static uint64_t benchFillNormal(BenchContext *context) {
+    fillNormal(&context->sampler, context->scratch, context->b.T * context->b.N);
+    return context->b.T * context->b.N;
+}
+
+static uint64_t benchFillExponential(BenchContext *context) {
+    fillExponential(&context->sampler, context->scratch, context->b.T * context->b.N);
+    return context->b.T * context->b.N;
+}
+
+static uint64_t benchComputePriceStats(BenchContext *context) {
+    Bandit b = context->b;
+    PriceStats stats;
+    // on one thread, like the other kernels
+    if (computePriceStats(context->data, b.T, b.N, 1, &stats)) {
+        return 0;
+    }
+    freePriceStats(&stats);
+    return b.T * b.N;
+}
+
+static uint64_t benchAlgorithm(BenchContext *context) {
+    Bandit b = context->b;
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        b.algs[id] = id == context->alg;
+    }
+
+    // only the arrays filled while the algorithm runs, so no metric is derived
+    AlgResults results[ALG_COUNT] = {0};
+    results[context->alg] = (AlgResults) {context->totalGain, context->avgLowThreshold, context->avgHighThreshold,
+                                          context->avgTrades};
+    runAlgorithms(context->data, context->totalOpt, results, b, nullptr, nullptr);
+    return b.T;
+}
+
+static const Bench kernels[] = {
+        {"runThreshold", "price", benchRunThreshold, nullptr},
+        {"runRound", "price", benchRunRound, resetArms},
+        {"findOpt", "price", benchFindOpt, nullptr},
+        {"bestHand", "arm price", benchBestHand, nullptr},
+        {"normalizePrices", "price", benchNormalizePrices, copyPrices},
+        {"initThreshold", "arm", benchInitThreshold, nullptr},
+        {"initThresholdDynamic", "arm", benchInitThresholdDynamic, nullptr},
+        {"rollingThresholds", "round", benchRollingThresholds, nullptr},
+        {"getMetrics", "round", benchGetMetrics, nullptr},
+        {"fillNormal", "sample", benchFillNormal, nullptr},
+        {"fillExponential", "sample", benchFillExponential, nullptr},
+        {"computePriceStats", "price", benchComputePriceStats, nullptr},
+};
+
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void runBench(Bench *bench, BenchContext *context, uint32_t warmup, uint32_t maxTrials, uint64_t budget,
+                     BenchResult *result) {
+    double perUnit[MAX_TRIALS];
+    uint64_t spent = 0;
+    uint32_t trials = 0;
+
+    for (uint32_t trial = 0; trial < warmup + maxTrials; trial++) {
+        // a slow benchmark stops once it is over its budget, with at least one measured trial
+        if (spent >= budget && trials)
+            break;
+        if (bench->prepare)
+            bench->prepare(context);
+
+        uint64_t start = monotonicNs();
+        uint64_t units = bench->run(context);
+        uint64_t ns = monotonicNs() - start;
+        spent += ns;
+
+        // a warmup trial over the whole budget is kept, instead of running another
+        if (trial >= warmup || spent >= budget)
+            perUnit[trials++] = (double) ns / (double) (units ? units : 1);
+    }
+
+    qsort(perUnit, trials, sizeof(double), compareDoubles);
+    Bandit b = context->b;
+    snprintf(result->name, sizeof(result->name), "%s", bench->name);
+    result->unit = bench->unit;
+    result->distribution = context->distribution;
+    getMemoryPolicyName(&b.memory, result->memory, sizeof(result->memory));
+    result->N = b.N;
+    result->thresholds = b.thresholds;
+    result->dualThres = b.dualThres;
+    result->keepItems = b.keepItems;
+    result->trials = trials;
+    result->median = trials % 2 ? perUnit[trials / 2] : (perUnit[trials / 2 - 1] + perUnit[trials / 2]) / 2;
+    result->p95 = perUnit[(uint32_t) ceil(0.95 * trials) - 1];
+    result->min = perUnit[0];
+
+    printf("%-24s%-8s%6lu%6u%6u%6u%14.3lf%14.3lf%14.3lf  ns/%s\n", result->name, result->distribution, b.N,
+           b.thresholds, b.dualThres, b.keepItems, result->median, result->p95, result->min, result->unit);
+}
+
+// fills data with T * N prices in [0,1], independent ones or a random walk
+static void fillPrices(double *data, uint64_t size, uint8_t walk, gsl_rng *r) {
+    double price = 0;
+    for (uint64_t i = 0; i < size; i++) {
+        price = walk ? price + gsl_ran_gaussian(r, 1) : gsl_rng_uniform(r);
+        data[i] = price;
+    }
+
+    if (walk) {
+        double min, max;
+        getPriceRange(data, size, &min, &max);
+        normalizePrices(min, max, data, size);
+    }
+}
+
+static uint32_t parseList(char *text, uint64_t *values, uint32_t capacity) {
+    uint32_t count = 0;
+    for (char *value = strtok(text, ","); value && count < capacity; value = strtok(nullptr, ",")) {
+        values[count++] = strtoull(value, nullptr, 10);
+    }
+    return count;
+}
+
+static uint8_t saveResults(char *path, BenchResult *results, uint32_t count) {
+    char filePath[512];
+    snprintf(filePath, sizeof(filePath), "%s.csv", path);
+    FILE *csv = fopen(filePath, "w");
+    if (!csv) {
+        return 1;
+    }
+    fprintf(csv, "benchmark,distribution,memory,N,K,dualThres,keepItems,unit,trials,medianNs,p95Ns,minNs\n");
+    for (uint32_t i = 0; i < count; i++) {
+        BenchResult *r = &results[i];
+        fprintf(csv, "%s,%s,%s,%lu,%u,%u,%u,%s,%u,%.4lf,%.4lf,%.4lf\n", r->name, r->distribution, r->memory, r->N,
+                r->thresholds, r->dualThres, r->keepItems, r->unit, r->trials, r->median, r->p95, r->min);
+    }
+    uint8_t error = fclose(csv) != 0;
+
+    snprintf(filePath, sizeof(filePath), "%s.json", path);
+    FILE *json = fopen(filePath, "w");
+    if (!json) {
+        return 1;
+    }
+    fprintf(json, "[");
+    for (uint32_t i = 0; i < count; i++) {
+        BenchResult *r = &results[i];
+        fprintf(json,
+                "%s\n  {\"benchmark\": \"%s\", \"distribution\": \"%s\", \"memory\": \"%s\", \"N\": %lu, \"K\": %u, "
+                "\"dualThres\": %u, \"keepItems\": %u, \"unit\": \"%s\", \"trials\": %u, \"medianNs\": %.4lf, "
+                "\"p95Ns\": %.4lf, \"minNs\": %.4lf}",
+                i ? "," : "", r->name, r->distribution, r->memory, r->N, r->thresholds, r->dualThres, r->keepItems,
+                r->unit, r->trials, r->median, r->p95, r->min);
+    }
+    fprintf(json, "\n]\n");
+    error |= fclose(json) != 0;
+
+    return error;
+}
+
+int main(int argc, char **argv) {
+    uint64_t T = 2000;
+    uint64_t Ns[16] = {10, 100};
+    uint32_t NCount = 2;
+    uint64_t Ks[16] = {10, 20};
+    uint32_t KCount = 2;
+    uint32_t trials = 5;
+    uint32_t warmup = 1;
+    uint64_t budget = 2000000000;
+    char *filter = nullptr;
+    char *outPath = "benchResults";
+    MemoryPolicy policies[16] = {{0}};
+    uint32_t policyCount = 1;
+
+    int opt;
+    opterr = 0;
+
+    while ((opt = getopt(argc, argv, ":hT:n:k:r:w:b:f:o:M:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printHelp();
+                return 0;
+            case 'T':
+                T = strtoull(optarg, nullptr, 10);
+                break;
+            case 'n':
+                NCount = parseList(optarg, Ns, 16);
+                break;
+            case 'k':
+                KCount = parseList(optarg, Ks, 16);
+                break;
+            case 'r':
+                trials = atoi(optarg);
+                break;
+            case 'w':
+                warmup = atoi(optarg);
+                break;
+            case 'b':
+                budget = strtoull(optarg, nullptr, 10) * 1000000;
+                break;
+            case 'f':
+                filter = optarg;
+                break;
+            case 'o':
+                outPath = optarg;
+                break;
+            case 'M':
+                policyCount = 0;
+                for (char *policy = strtok(optarg, ","); policy && policyCount < 16; policy = strtok(nullptr, ",")) {
+                    if (parseMemoryPolicy(policy, &policies[policyCount++])) {
+                        printf("Error: Invalid memory policy %s\n", policy);
+                        return 1;
+                    }
+                }
+                break;
+            case '?':
+                fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+                break;
+            default:
+                abort();
+        }
+    }
+
+    if (trials < 1 || trials > MAX_TRIALS || T < 2) {
+        printf("Error: There have to be 1 to %u trials and at least 2 rounds\n", MAX_TRIALS);
+        return 1;
+    }
+
+    gsl_rng_env_setup();
+    gsl_rng *r = gsl_rng_alloc(gsl_rng_default);
+    // the same prices on every run, so two builds are compared on the same data
+    gsl_rng_set(r, 1);
+
+    uint32_t capacity = 64;
+    uint32_t resultCount = 0;
+    BenchResult *results = malloc(capacity * sizeof(BenchResult));
+
+    printf("%-24s%-8s%6s%6s%6s%6s%14s%14s%14s\n", "Benchmark", "Data", "N", "K", "Dual", "Keep", "Median", "p95",
+           "Min");
+
+    const char *distributions[] = {"uniform", "walk"};
+    for (uint32_t p = 0; p < policyCount; p++) {
+        char policyName[64];
+        getMemoryPolicyName(&policies[p], policyName, sizeof(policyName));
+        printf("Memory policy: %s\n", policyName);
+        // the same prices for every policy
+        gsl_rng_set(r, 1);
+
+        for (uint32_t d = 0; d < 2; d++) {
+            for (uint32_t n = 0; n < NCount; n++) {
+                uint64_t N = Ns[n];
+                if (N <= 2)
+                    continue;
+
+                double *data = allocMemory(&policies[p], T * N * sizeof(double), 0);
+                fillPrices(data, T * N, d, r);
+
+                for (uint32_t k = 0; k < KCount; k++) {
+                    for (uint8_t dual = 0; dual < 2; dual++) {
+                        for (uint8_t keep = 0; keep < 2; keep++) {
+                            Bandit b = {.T = T,
+                                        .N = N,
+                                        .K = Ks[k],
+                                        .thresholds = Ks[k],
+                                        .dualThres = dual,
+                                        .keepItems = keep,
+                                        .seed = 1,
+                                        .ucb2Alpha = DEFAULT_UCB2_ALPHA,
+                                        .eGreedyScale = DEFAULT_EGREEDY_SCALE,
+                                        .memory = policies[p]};
+                            if (dual)
+                                b.K = b.K * (b.K + 1) / 2;
+                            if ((dual && b.K <= 2) || b.K < 1 || b.K > b.T)
+                                continue;
+
+                            BenchContext context = {.b = b, .distribution = distributions[d], .data = data};
+                            // the prices and the results are placed by the policy, the rest is small
+                            MemoryPolicy *policy = &policies[p];
+                            context.scratch = allocMemory(policy, T * N * sizeof(double), 0);
+                            context.totalOpt = allocMemory(policy, T * sizeof(double), 0);
+                            context.totalGain = allocMemory(policy, T * sizeof(double), 0);
+                            context.avgLowThreshold = allocMemory(policy, T * sizeof(double), 0);
+                            context.avgHighThreshold = allocMemory(policy, T * sizeof(double), 0);
+                            context.avgTrades = allocMemory(policy, T * sizeof(double), 0);
+                            context.metrics = allocMemory(policy, METRIC_COUNT * T * sizeof(double), 0);
+                            context.arms = malloc(b.K * sizeof(Threshold));
+                            initSampler(&context.sampler, 1);
+                            initThreshold(context.arms, b, data);
+                            findOpt(data, context.totalOpt, context.avgTrades, b, nullptr);
+
+                            uint32_t kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+                            for (uint32_t i = 0; i < kernelCount + ALG_COUNT; i++) {
+                                Bench bench;
+                                if (i < kernelCount) {
+                                    bench = kernels[i];
+                                } else {
+                                    context.alg = i - kernelCount;
+                                    bench = (Bench) {algorithms[context.alg]->name, "round", benchAlgorithm, nullptr};
+                                }
+                                // dynamic thresholds need a price for each threshold in the first round
+                                if (bench.run == benchInitThresholdDynamic && N < b.thresholds)
+                                    continue;
+                                if (filter && !strstr(bench.name, filter))
+                                    continue;
+
+                                if (resultCount == capacity) {
+                                    capacity *= 2;
+                                    results = realloc(results, capacity * sizeof(BenchResult));
+                                }
+                                runBench(&bench, &context, warmup, trials, budget, &results[resultCount++]);
+                            }
+
+                            freeMemory(context.scratch);
+                            freeMemory(context.totalOpt);
+                            freeMemory(context.totalGain);
+                            freeMemory(context.avgLowThreshold);
+                            freeMemory(context.avgHighThreshold);
+                            freeMemory(context.avgTrades);
+                            freeMemory(context.metrics);
+                            free(context.arms);
+                        }
+                    }
+                }
+
+                freeMemory(data);
+            }
+        }
+    }
+
+    gsl_rng_free(r);
+
+    uint8_t error = saveResults(outPath, results, resultCount);
+    if (error) {
+        printf("Error: Couldn't save the results in %s.csv and %s.json\n", outPath, outPath);
+    } else {
+        printf("\nSaved %u results in %s.csv and %s.json\n", resultCount, outPath, outPath);
+    }
+    free(results);
+
+    return error;
+}
@@ -0,0 +1,131 @@
+#ifndef HDR_ARMSPACE_H_
+#define HDR_ARMSPACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <orderStats.h>
+#include <util.h>
+
+// returned by armSlot for arms that haven't been played
+#define ARM_UNPLAYED UINT32_MAX
+
+/**
+ * @typedef armSpaceStruct
+ * @brief The K arms of an algorithm, stored lazily
+ *
+ * The arms are never materialized. Arm th is the thth threshold, or with two thresholds the thth (low, high) pair of
+ * the triangle low <= high in row order, and its thresholds are calculated from th when they are needed. Statistics
+ * are only kept for the arms that have been played, each in its own slot, in the order they were first played. Every
+ * arm that hasn't been played shares the same default state: no reward, never chosen, and an algorithm state of all
+ * zeroes, so the algorithms can handle all of them at once.
+ *
+ */
+typedef struct armSpaceStruct {
+    uint32_t K;
+    uint32_t thresholds;
+    uint8_t dualThres;
+    // the values a threshold can take
+    double *threshold;
+    // the prices the values are the quantiles of with rolling dynamic thresholds, NULL otherwise. Set by the engine,
+    // which moves it every round
+    ThresholdWindow *window;
+
+    // the id and the statistics of each played arm, by slot
+    uint32_t playedCount;
+    uint32_t capacity;
+    uint32_t *playedId;
+    Threshold *played;
+    // armStateSize bytes of algorithm state for each played arm, by slot
+    size_t armStateSize;
+    uint8_t *armState;
+
+    // open addressing hash table from arm id to slot + 1, 0 for an empty entry
+    uint32_t *table;
+    uint32_t tableSize;
+    // every arm with a smaller id has been played
+    uint32_t firstUnplayed;
+} ArmSpace;
+
+/**
+ * @brief Initializes an arm space with b.K arms and no played arms
+ *
+ * @param space The arm space
+ * @param b A struct with various information and flags
+ * @param data The array with the prices, used for dynamic thresholds
+ * @param armStateSize The bytes of algorithm state kept for every played arm
+ */
+void initArmSpace(ArmSpace *space, Bandit b, double *data, size_t armStateSize);
+
+void freeArmSpace(ArmSpace *space);
+
+/**
+ * @brief Replaces the values a threshold can take, and the thresholds of the played arms with them, keeping their
+ * statistics and state
+ *
+ * @param threshold An array of thresholds values
+ */
+void reseedArmSpace(ArmSpace *space, double *threshold);
+
+/**
+ * @brief Writes the low and high threshold of arm th
+ */
+void getArmThresholds(ArmSpace *space, uint32_t th, double *low, double *high);
+
+/**
+ * @brief Returns the slot of arm th, or ARM_UNPLAYED if it hasn't been played
+ */
+uint32_t armSlot(ArmSpace *space, uint32_t th);
+
+/**
+ * @brief Returns the slot of arm th, giving it one with default statistics and zeroed state if it doesn't have one
+ *
+ * The slots may move in memory when a new one is added, so pointers to them are only valid until the next call.
+ */
+uint32_t playArm(ArmSpace *space, uint32_t th);
+
+/**
+ * @brief Makes room for capacity played arms, so playArm doesn't allocate until more than capacity arms are played
+ */
+void reserveArms(ArmSpace *space, uint32_t capacity);
+
+/**
+ * @brief Returns the statistics of arm th, the default ones if it hasn't been played
+ */
+Threshold getArm(ArmSpace *space, uint32_t th);
+
+/**
+ * @brief Returns the algorithm state of the arm in slot
+ */
+void *getArmState(ArmSpace *space, uint32_t slot);
+
+/**
+ * @brief Returns the slots of the played arms in the order of their ids, for the reports
+ *
+ * @returns An array of playedCount slots, which the caller frees
+ */
+uint32_t *sortPlayedArms(ArmSpace *space);
+
+/**
+ * @brief Returns the arm with the smallest id that hasn't been played, K if every arm has been
+ */
+uint32_t firstUnplayedArm(ArmSpace *space);
+
+/**
+ * @brief Writes the played arms, their statistics and their algorithm state to a checkpoint
+ *
+ * @returns 0 on success, 1 on a write error
+ */
+uint8_t writeArmSpace(ArmSpace *space, FILE *file);
+
+/**
+ * @brief Reads the arms written by writeArmSpace into an arm space initialized for the same arms
+ *
+ * The arms get back the slots they had, so algorithms can keep slots in their own state.
+ *
+ * @returns 0 on success, 1 on a read error
+ */
+uint8_t readArmSpace(ArmSpace *space, FILE *file);
+
+#endif
@@ -1,31 +1,146 @@
 #ifndef HDR_BANDITALGS_H_
 #define HDR_BANDITALGS_H_
 
+#include <stddef.h>
+#include <stdio.h>
+
+#include <armSpace.h>
+#include <reporter.h>
 #include <util.h>
 
-void findOpt(double *data, double *totalOpt, double *avgTrades, Bandit b);
+/**
+ * @typedef algorithmStruct
+ * @brief The interface every bandit algorithm implements so the engine can advance them round by round
+ *
+ * Each round the engine asks the algorithm which arm to play (select), plays it with runRound and feeds the gain
+ * back (update). The ArmSpace is owned by the engine and passed to every callback. It only holds the arms that have
+ * been played, so an algorithm should handle the unplayed ones all at once instead of visiting all K of them.
+ */
+typedef struct algorithmStruct {
+    // short name, used for the results directory
+    char *name;
+    // name used in messages and plot legends
+    char *title;
+    // gnuplot line color and point type
+    char *color;
+    uint8_t pointType;
+    // true if the algorithm only ever uses one threshold for buying and selling
+    uint8_t singleThres;
+    // true if the algorithm makes random choices, seeded from b.seed
+    uint8_t stochastic;
+    // true if the algorithm can run in a live Session: it needs no prices before the first round, and it doesn't
+    // allocate memory after init once the ArmSpace has room for every arm
+    uint8_t online;
+    // the bytes of state the algorithm keeps for each played arm, stored in the ArmSpace
+    size_t armStateSize;
 
-void bestHand(double *data, double *totalOpt, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-              Bandit b);
+    /**
+     * @brief Allocates and initializes the algorithm's state
+     *
+     * @param arms The arm space, with no arms played yet
+     * @param b A struct with various information and flags
+     * @param data The array with the prices
+     *
+     * @returns The state passed to every other callback
+     */
+    void *(*init)(ArmSpace *arms, Bandit b, double *data);
+
+    /**
+     * @brief Picks the arm to play in the current round
+     *
+     * @returns The id of the chosen arm
+     */
+    uint32_t (*select)(void *state, ArmSpace *arms, Bandit b, uint64_t round);
+
+    /**
+     * @brief Updates the algorithm's state after the chosen arm has been played, can be NULL
+     *
+     * @param th The arm returned by select, which now has a slot in the arm space
+     * @param gain The reward of the round
+     */
+    void (*update)(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round);
+
+    /**
+     * @brief Picks the arms of the next count rounds at once, from the state before any of them is played, can be
+     * NULL if the algorithm only plays round by round
+     *
+     * The engine then plays the rounds, in parallel, and calls update for each of them in order, so select and
+     * update see the same arm space as without batches, only with the rewards of the batch held back.
+     *
+     * @param round The first of the rounds
+     * @param th The arm of each round
+     */
+    void (*selectBatch)(void *state, ArmSpace *arms, Bandit b, uint64_t round, uint32_t count, uint32_t *th);
 
-void median(double *data, double *totalGain, double *avgThreshold, double *avgTrades, double *totalOpt, Bandit b);
+    /**
+     * @brief Prints the final statistics of the algorithm, after all the rounds have been played
+     *
+     * @param totalGain The array that holds the total gain up to each round
+     * @param totalOpt The array that holds the optimal gain up to each round
+     * @param out The stream the report is printed to
+     */
+    void (*report)(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out);
 
-void greedy(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-            double *totalOpt, Bandit b);
+    /**
+     * @brief Writes the algorithm's state to a checkpoint, can be NULL if the algorithm keeps no state besides the
+     * ArmSpace, which the engine saves itself
+     *
+     * @returns 0 on success, 1 on a write error
+     */
+    uint8_t (*save)(void *state, ArmSpace *arms, Bandit b, FILE *file);
 
-void epsilonGreedy(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold,
-                   double *avgTrades, double *totalOpt, Bandit b);
+    /**
+     * @brief Reads the state written by save into a state just returned by init, can be NULL only if save is
+     *
+     * @returns 0 on success, 1 on a read error
+     */
+    uint8_t (*load)(void *state, ArmSpace *arms, Bandit b, FILE *file);
 
-void succElim(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-              double *totalOpt, Bandit b);
+    /**
+     * @brief Frees the algorithm's state, can be NULL
+     */
+    void (*free)(void *state);
+} Algorithm;
 
-void ucb1(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-          double *totalOpt, Bandit b);
+/**
+ * @brief All the available algorithms, indexed by their id
+ */
+extern const Algorithm *algorithms[ALG_COUNT];
 
-void ucb2(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-          double *totalOpt, Bandit b);
+extern const Algorithm medianAlg;
+extern const Algorithm greedyAlg;
+extern const Algorithm epsilonGreedyAlg;
+extern const Algorithm succElimAlg;
+extern const Algorithm ucb1Alg;
+extern const Algorithm ucb2Alg;
+extern const Algorithm exp3Alg;
+extern const Algorithm hooAlg;
+extern const Algorithm swUcbAlg;
+extern const Algorithm dUcbAlg;
 
-void exp3(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-          double *totalOpt, Bandit b);
+/**
+ * @brief Returns the window of sliding window ucb, b.swUcbWindow or its default if it isn't set
+ */
+uint64_t getSwUcbWindow(Bandit b);
+
+/**
+ * @brief Returns the discount factor of discounted ucb, b.dUcbDiscount or its default if it isn't set
+ */
+double getDUcbDiscount(Bandit b);
+
+/**
+ * @brief Calculates the gain of a prophet that buys at every local minimum and sells at every local maximum
+ *
+ * @param reporter Where the summary of the OPT is sent, NULL for none
+ */
+void findOpt(double *data, double *totalOpt, double *avgTrades, Bandit b, Reporter *reporter);
+
+/**
+ * @brief Calculates the gain of playing the best threshold of each round, chosen after seeing the round's prices
+ *
+ * @param reporter Where the table of the thresholds is sent, NULL for none
+ */
+void bestHand(double *data, double *totalOpt, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
+              Bandit b, Reporter *reporter);
 
 #endif
@@ -0,0 +1,87 @@
+#ifndef HDR_CHECKPOINT_H_
+#define HDR_CHECKPOINT_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <reporter.h>
+#include <util.h>
+
+/**
+ * @typedef checkpointStruct
+ * @brief Where and how often a run saves its progress, so it can be resumed after it is stopped
+ *
+ * The checkpoint of a run is a directory with a file describing the run (the prices it was started on, how they were
+ * normalized and the seed), and for each algorithm a state file, rewritten at every checkpoint, and a file of result
+ * rows that only has the rounds since the previous checkpoint appended to it.
+ *
+ */
+typedef struct checkpointStruct {
+    // the directory of the checkpoint files, ending in a '/'
+    char path[256];
+    // rounds between two checkpoints, the last round is always saved
+    uint64_t interval;
+    // true to continue from the saved files instead of starting over
+    uint8_t resume;
+} Checkpoint;
+
+/**
+ * @brief Sets the checkpoint directory to the checkpoint/ directory inside a result directory, and creates it
+ *
+ * @param resultPath The directory of the run's results, ending in a '/'
+ */
+void initCheckpoint(Checkpoint *checkpoint, char *resultPath);
+
+/**
+ * @brief Saves what the run depends on besides its flags, for a resumed run to check and restore
+ *
+ * @param data The array with the prices, before they are normalized
+ * @param dataMin The price that is normalized to 0
+ * @param dataMax The price that is normalized to 1
+ *
+ * @returns 0 on success, 1 on a write error
+ */
+uint8_t saveCheckpointInfo(Checkpoint *checkpoint, Bandit b, double *data, double dataMin, double dataMax);
+
+/**
+ * @brief Checks that the saved run was started on the first rounds of data, and restores its seed and normalization
+ *
+ * The data can have more rounds than the saved run, which extends the run with them. An interval of 0 keeps the
+ * saved one.
+ *
+ * @param data The array with the prices, before they are normalized
+ * @param reporter Where the reason a saved run can't be resumed is sent
+ *
+ * @returns 0 on success, 1 if there is no saved run or it doesn't match the data
+ */
+uint8_t loadCheckpointInfo(Checkpoint *checkpoint, Bandit *b, double *data, double *dataMin, double *dataMax,
+                           Reporter *reporter);
+
+/**
+ * @brief Opens the checkpoint file <name><suffix>, with the modes of fopen
+ */
+FILE *openCheckpointFile(Checkpoint *checkpoint, const char *name, const char *suffix, const char *mode);
+
+/**
+ * @brief Flushes a file to the disk and closes it
+ *
+ * @returns 0 on success, 1 on a write error
+ */
+uint8_t closeCheckpointFile(FILE *file);
+
+/**
+ * @brief Replaces the checkpoint file <name><suffix> with <name><suffix>.tmp, so a crash while a file is written
+ * never leaves it half written
+ *
+ * @returns 0 on success, 1 on an error
+ */
+uint8_t replaceCheckpointFile(Checkpoint *checkpoint, const char *name, const char *suffix);
+
+/**
+ * @brief Truncates the checkpoint file <name><suffix> to size bytes
+ *
+ * @returns 0 on success, 1 on an error
+ */
+uint8_t truncateCheckpointFile(Checkpoint *checkpoint, const char *name, const char *suffix, uint64_t size);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef HDR_ENGINE_H_
+#define HDR_ENGINE_H_
+
+#include <stdio.h>
+
+#include <banditAlgs.h>
+#include <checkpoint.h>
+#include <reporter.h>
+#include <timing.h>
+#include <util.h>
+
+/**
+ * @typedef algResultsStruct
+ * @brief The per round arrays an algorithm fills while it runs, and the metrics derived from them afterwards
+ *
+ * Any of the derived arrays can be NULL, in which case that metric is not calculated, and so can timing, in which case
+ * the algorithm isn't timed. The metrics that are calculated are calculated together, in a single pass.
+ */
+typedef struct algResultsStruct {
+    double *totalGain;
+    double *avgLowThreshold;
+    double *avgHighThreshold;
+    double *avgTrades;
+
+    double *avgGain;
+    double *avgRegret;
+    double *compRatio;
+    double *avgTradeGain;
+
+    // the time spent playing the rounds and deriving the metrics is added to it
+    AlgTiming *timing;
+} AlgResults;
+
+/**
+ * @brief Runs all the algorithms enabled in b.algs in a single pass over the data
+ *
+ * Every algorithm is advanced round by round together with the others, so the prices of each round are read from
+ * memory once for all the algorithms, while they are still in cache. The derived metrics are calculated after the
+ * last round.
+ *
+ * @param data The array with the prices
+ * @param totalOpt The array that holds the optimal gain up to each round, used for the reports
+ * @param results The arrays each algorithm fills, indexed by algorithmId
+ * @param b A struct with various information and flags
+ * @param reporter Where the progress and the algorithms' reports are sent, NULL for neither
+ * @param checkpoint Where the algorithms save their progress, and resume it from with checkpoint->resume, NULL to
+ * never save it. Every algorithm has its own checkpoint files, and one without a valid checkpoint starts over
+ */
+void runAlgorithms(double *data, double *totalOpt, AlgResults *results, Bandit b, Reporter *reporter,
+                   Checkpoint *checkpoint);
+
+/**
+ * @brief Runs every algorithm enabled in b.algs as a separate task on a pool of worker threads
+ *
+ * Each task runs its algorithm over all the data and then calculates its derived metrics. The reports are buffered
+ * and sent to the reporter in the algorithms' order once every task has finished, so they never interleave.
+ *
+ * @param threads The number of worker threads, 0 uses one per online cpu
+ * @param reporter Where the progress and the algorithms' reports are sent, NULL for neither
+ * @param checkpoint Where the algorithms save their progress, as in runAlgorithms
+ */
+void runAlgorithmsConcurrently(double *data, double *totalOpt, AlgResults *results, Bandit b, uint32_t threads,
+                               Reporter *reporter, Checkpoint *checkpoint);
+
+#endif
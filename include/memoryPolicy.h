@@ -0,0 +1,86 @@
+#ifndef HDR_MEMORYPOLICY_H_
+#define HDR_MEMORYPOLICY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the bytes of the next round that are prefetched, a page so its translation is looked up early too
+#define PREFETCH_BYTES 4096u
+
+/**
+ * INFO: A memory policy decides how the big arrays, the prices and the results, are placed in memory:
+ *
+ * --------------------------------------------------
+ * pages: the kernel's 4KB pages, transparent huge pages asked for with madvise, or explicit huge pages from the
+ * reserved pool (MAP_HUGETLB), which fall back to transparent ones when the pool is empty
+ * placement: wherever the thread that first writes a page runs, interleaved over every NUMA node the process may use,
+ * or first written in parallel by the workers of the pool, so the pages are spread over their nodes
+ * prefetch: the engine and the OPT prefetch the prices of the next round while they play the current one
+ * --------------------------------------------------
+ *
+ * A policy is written as its parts joined by +, e.g. thp+interleave+prefetch, and "default" is the policy of
+ * nothing: 4KB pages, placed by the first write, and no prefetching. Every part is only a hint, anything the kernel
+ * or the machine doesn't offer is left out and the memory is allocated as it would be without it.
+ */
+
+enum pagePolicy { PAGES_DEFAULT, PAGES_TRANSPARENT, PAGES_EXPLICIT };
+
+enum placementPolicy { PLACE_DEFAULT, PLACE_INTERLEAVE, PLACE_WORKERS };
+
+/**
+ * @typedef memoryPolicyStruct
+ * @brief How the prices and the results are placed in memory, all zeroes being the default policy
+ *
+ */
+typedef struct memoryPolicyStruct {
+    // a pagePolicy
+    uint8_t pages;
+    // a placementPolicy
+    uint8_t placement;
+    uint8_t prefetch;
+} MemoryPolicy;
+
+/**
+ * @brief Parses a policy, its parts (default, thp, hugetlb, interleave, workers and prefetch) joined by +
+ *
+ * @return 0 on success, 1 if a part is unknown or two parts set the pages or the placement
+ */
+uint8_t parseMemoryPolicy(char *text, MemoryPolicy *policy);
+
+/**
+ * @brief Writes the policy in the form parseMemoryPolicy reads
+ */
+void getMemoryPolicyName(const MemoryPolicy *policy, char *name, size_t size);
+
+/**
+ * @brief Allocates size bytes of zeroed memory, placed by the policy
+ *
+ * @param policy The policy, NULL for the default one
+ * @param threads The workers that first write the memory with PLACE_WORKERS, 0 uses one per online cpu
+ * @return The memory, freed with freeMemory, NULL if there isn't enough
+ */
+void *allocMemory(const MemoryPolicy *policy, size_t size, uint32_t threads);
+
+/**
+ * @brief Frees memory allocated by allocMemory, does nothing if memory is NULL
+ */
+void freeMemory(void *memory);
+
+/**
+ * @brief Prefetches the start of round round of the prices, if the policy prefetches
+ *
+ * @param N The prices per round
+ */
+static inline void prefetchRound(const MemoryPolicy *policy, const double *data, uint64_t N, uint64_t round) {
+    if (!policy->prefetch) {
+        return;
+    }
+
+    const char *start = (const char *) (data + round * N);
+    uint64_t bytes = N * sizeof(double) < PREFETCH_BYTES ? N * sizeof(double) : PREFETCH_BYTES;
+    for (uint64_t offset = 0; offset < bytes; offset += 64) {
+        __builtin_prefetch(start + offset, 0, 3);
+    }
+}
+
+#endif
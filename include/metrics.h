@@ -0,0 +1,50 @@
+#ifndef HDR_METRICS_H_
+#define HDR_METRICS_H_
+
+#include <stdint.h>
+
+/**
+ * INFO: The derived metrics are functions of a single round of the results an algorithm fills while it runs, so none
+ * of them has to be kept as an array. They are either calculated for a range of rounds, any of them in the same pass,
+ * or for a single round, when only some rounds are needed, such as the rounds of a decimated results file.
+ */
+
+/**
+ * @enum metricId
+ * @brief The metrics derived from the total gain, the optimal gain and the average trades
+ *
+ */
+enum metricId { METRIC_AVG_GAIN, METRIC_REGRET, METRIC_COMP_RATIO, METRIC_AVG_TRADE_GAIN, METRIC_COUNT };
+
+// the names of the metrics' columns in the results file, indexed by metricId
+extern const char *metricNames[METRIC_COUNT];
+
+/**
+ * @typedef metricSourceStruct
+ * @brief The per round results the metrics of an algorithm are derived from
+ *
+ */
+typedef struct metricSourceStruct {
+    double *totalGain;
+    // NULL when there is no regret or competitive ratio, as for OPT itself
+    double *totalOpt;
+    double *avgTrades;
+} MetricSource;
+
+/**
+ * @brief Returns the metric at round t, counted from 0
+ */
+double getMetric(const MetricSource *source, enum metricId metric, uint64_t t);
+
+/**
+ * @brief Calculates the metrics of the rounds in [from, to) in a single pass
+ *
+ * The rounds are split in blocks small enough to stay in cache, and every metric is calculated for a block before the
+ * next one is read, so each source array is read from memory once however many metrics are asked for.
+ *
+ * @param metrics The arrays the metrics are written to, indexed by metricId and then by round, a NULL array skips its
+ * metric
+ */
+void getMetrics(const MetricSource *source, uint64_t from, uint64_t to, double **metrics);
+
+#endif
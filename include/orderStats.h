@@ -0,0 +1,122 @@
+#ifndef HDR_ORDERSTATS_H_
+#define HDR_ORDERSTATS_H_
+
+#include <stdint.h>
+
+#include <util.h>
+
+// the most prices a window can hold, so the links fit in 32 bits next to the head and the end of the list
+#define ORDER_STATS_MAX_CAPACITY (UINT32_MAX - 2u)
+
+/**
+ * INFO: The prices of a sliding window are kept in an indexable skiplist, sorted, so any order statistic of the window
+ * is found without sorting it:
+ *
+ * --------------------------------------------------
+ * every link of the list also keeps its width, the number of prices it steps over
+ * a price is inserted or removed by walking down from the top level, and only the links it passes change
+ * the price of rank r is found by walking down too, taking every link whose width still fits in r
+ * --------------------------------------------------
+ *
+ * Each costs O(log W) for a window of W prices. The window is a ring of W slots, the price that is pushed into a full
+ * window takes the slot of the oldest one, after it is removed, so the list never allocates after it is made. The
+ * height of a slot is a hash of the slot, so equal windows are always the same list. Equal prices are ordered by
+ * their slots, so every price has its own place in the list and is removed from it exactly.
+ */
+
+/**
+ * @typedef orderStatsStruct
+ * @brief An indexable skiplist over the last capacity prices pushed into it
+ *
+ */
+typedef struct orderStatsStruct {
+    uint64_t capacity;
+    // the prices pushed since the list was made or cleared, the slot of the next one is pushed % capacity
+    uint64_t pushed;
+    uint32_t levels;
+    // the price and the height of each slot
+    double *value;
+    uint8_t *height;
+    // the first link of each slot in next and width, the links of the head come after the ones of the slots
+    uint64_t *firstLink;
+    // the slot each link leads to, and the number of prices it steps over
+    uint32_t *next;
+    uint32_t *width;
+} OrderStats;
+
+/**
+ * @typedef thresholdWindowStruct
+ * @brief The prices of the last b.rollingRounds rounds, whose quantiles are the values of rolling dynamic thresholds
+ *
+ * The thresholds of round t are the quantiles of rounds t - b.rollingRounds up to t - 1. The first round has no
+ * rounds before it and, like static dynamic thresholds, takes the quantiles of its own prices.
+ *
+ */
+typedef struct thresholdWindowStruct {
+    OrderStats prices;
+    uint64_t rounds;
+    // the rounds the window holds, [firstRound, endRound)
+    uint64_t firstRound;
+    uint64_t endRound;
+} ThresholdWindow;
+
+/**
+ * @brief Makes an empty list for a window of capacity prices
+ *
+ * @return 0 on success, 1 if the window is larger than ORDER_STATS_MAX_CAPACITY or there isn't enough memory
+ */
+uint8_t initOrderStats(OrderStats *stats, uint64_t capacity);
+
+void freeOrderStats(OrderStats *stats);
+
+/**
+ * @brief Empties the window
+ */
+void clearOrderStats(OrderStats *stats);
+
+/**
+ * @brief Returns the number of prices in the window
+ */
+uint64_t getOrderStatsCount(OrderStats *stats);
+
+/**
+ * @brief Adds a price to the window, removing the oldest one if the window is full
+ */
+void pushOrderStats(OrderStats *stats, double price);
+
+/**
+ * @brief Returns the price of rank rank in the window, 0 being the smallest
+ */
+double getOrderStat(OrderStats *stats, uint64_t rank);
+
+/**
+ * @brief Returns the q quantile of the window, interpolated like gsl_stats_quantile_from_sorted_data does, 0 if the
+ * window is empty
+ */
+double getOrderStatsQuantile(OrderStats *stats, double q);
+
+/**
+ * @brief Makes an empty window of b.rollingRounds rounds of b.N prices
+ *
+ * @return 0 on success, 1 if the window is too large or there isn't enough memory
+ */
+uint8_t initThresholdWindow(ThresholdWindow *window, Bandit b);
+
+void freeThresholdWindow(ThresholdWindow *window);
+
+/**
+ * @brief Moves the window to the rounds of the thresholds of round, pushing only the rounds it doesn't hold yet
+ *
+ * @return 1 if the window changed, 0 if it already held the rounds of round
+ */
+uint8_t moveThresholdWindow(ThresholdWindow *window, Bandit b, double *data, uint64_t round);
+
+/**
+ * @brief Calculates the b.thresholds values of the thresholds, the quantiles of the window at the same levels as
+ * initThresholdValues
+ *
+ * @param threshold An array of b.thresholds values
+ */
+void getWindowThresholds(ThresholdWindow *window, Bandit b, double *threshold);
+
+#endif
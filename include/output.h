@@ -0,0 +1,48 @@
+#ifndef HDR_OUTPUT_H_
+#define HDR_OUTPUT_H_
+
+#include <stdint.h>
+
+#include <resultStore.h>
+#include <timing.h>
+#include <util.h>
+
+/**
+ * @brief Creates the result store of a run, results.bin in its result directory, with a column for every metric of
+ * each algorithm in b.algs: totalGain, avgLowThreshold, avgHighThreshold, avgTrades, avgGain, regret, compRatio and
+ * avgTradeGain
+ *
+ * @param filepath The name of the data file
+ * @param decimation Rounds per stored row, 1 to store every round
+ * @param withOpt True to also add the columns of OPT, the same metrics but regret and compRatio
+ *
+ * @returns 0 on success, 1 if the store can't be created
+ */
+uint8_t createRunStore(ResultStore *store, char *filepath, Bandit b, uint64_t decimation, uint8_t withOpt);
+
+/**
+ * @brief Saves the per round mean and variance of each algorithm's replications in <resultType>R<count>.txt, in the
+ * algorithm's directory of the run's results
+ *
+ * @param stats The stats of each algorithm, indexed by algorithmId, algorithms with a count of 0 are skipped
+ */
+void saveReplicationResults(char *filepath, Bandit b, char *resultType, RunningStats *stats);
+
+/**
+ * @brief Writes the directory the results of a run are saved in, prophetResults/<data>/<params>/, to resultPath
+ *
+ * Hyperparameters that differ from their default are added to <params>, as _a<ucb2Alpha>, _e<eGreedyScale>,
+ * _x<exp3UpperBound>, _w<swUcbWindow> and _g<dUcbDiscount>.
+ */
+void getResultPath(char *resultPath, char *filepath, Bandit b);
+
+/**
+ * @brief Saves the timings of a run as a JSON object, with the run's data file and parameters, a "phases" array and an
+ * "algorithms" array. Every timed phase has its time in ns, the rounds, prices and bytes it went through, and the
+ * nsPerPrice, roundsPerSecond and bytesPerSecond derived from them, or null where they don't apply
+ *
+ * @returns 0 on success, 1 if the file can't be written
+ */
+uint8_t saveTimings(char *path, char *filepath, Bandit b, Timings *timings);
+
+#endif
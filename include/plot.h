@@ -0,0 +1,55 @@
+#ifndef HDR_PLOT_H_
+#define HDR_PLOT_H_
+
+#include <stdint.h>
+
+#include <metrics.h>
+#include <util.h>
+
+/**
+ * INFO: Every plot function downsamples its arrays and returns, the plot itself is drawn by gnuplot on a background
+ * thread, so the arrays can be freed or reused right away. A plot that can't be drawn, because gnuplot can't be
+ * started, is skipped.
+ */
+
+/**
+ * @brief Plots the needed information per day for each algorithm using gnuplot
+ *
+ * @param ylabel The title that appears on the plot window
+ * @param b A struct with various information and flags
+ * @param opt The array that holds the information to be plotted for OPT for each round, or NULL
+ * @param results The arrays that hold the information to be plotted for each algorithm for each round, indexed by
+ * algorithmId
+ * @param bounded True when the plotted values need to be bounded in [0,1]
+ */
+void plotAlgorithms(char *ylabel, Bandit b, double *opt, double **results, uint8_t bounded);
+
+/**
+ * @brief Plots a derived metric for each algorithm, calculated from its results while they are downsampled
+ *
+ * @param opt The results of OPT, or NULL to leave it out
+ * @param sources The results of each algorithm, indexed by algorithmId
+ */
+void plotMetric(char *ylabel, Bandit b, enum metricId metric, MetricSource *opt, MetricSource *sources,
+                uint8_t bounded);
+
+void plotData(double *data, uint64_t size);
+
+void plotThresholds(Bandit b, double *optLow, double *optHigh, double **low, double **high);
+
+/**
+ * @brief Plots the mean of each algorithm's replications along with its 95% confidence band
+ *
+ * @param ylabel The title that appears on the plot window
+ * @param b A struct with various information and flags
+ * @param stats The stats of each algorithm, indexed by algorithmId, algorithms with a count of 0 are skipped
+ * @param bounded True when the plotted values need to be bounded in [0,1]
+ */
+void plotReplications(char *ylabel, Bandit b, RunningStats *stats, uint8_t bounded);
+
+/**
+ * @brief Waits until every queued plot has been handed to gnuplot, no more plots can be made after it
+ */
+void finishPlots();
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef HDR_PRICEMODEL_H_
+#define HDR_PRICEMODEL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <gsl/gsl_rng.h>
+#include <memoryPolicy.h>
+#include <sampler.h>
+
+/**
+ * INFO: The prices of a model are generated in chunks of whole rounds, each chunk from its own stream of the seed, so
+ * the prices only depend on the seed, not on how many threads generate them or in which order:
+ *
+ * --------------------------------------------------
+ * planPrices walks the drift of the parameters of a randomized model, noting where each chunk starts
+ * generateChunk fills a chunk as if the prices before it were all 0
+ * joinChunk adds what the end of the previous chunk carries into the chunk, which only the AR and MA models have
+ * carryChunkEnd turns the end of a chunk into its end after the join, so the next chunk can be joined before this one
+ * --------------------------------------------------
+ *
+ * A program writing a file generates and joins one chunk after the other, generatePrices generates every chunk in
+ * parallel and joins them afterwards, and both give the same prices.
+ */
+
+/**
+ * @typedef priceModelStruct
+ * @brief A model the prices are drawn from, with the options of priceGenerator
+ *
+ */
+typedef struct priceModelStruct {
+    // the priceGenerator option of the model, one of u, g, e, b, T, a, m, s and c
+    char kind;
+    // phi of the AR model, theta of the MA model, or the cycles of the cosine waves
+    double parameter;
+    // true when the parameters of u, g, e and b drift after every round
+    uint8_t randomize;
+    uint64_t T;
+    uint64_t N;
+    uint64_t seed;
+    // when not NULL, every sample comes from it through GSL, and the chunks have to be generated in order
+    gsl_rng *reference;
+} PriceModel;
+
+/**
+ * @typedef modelParamsStruct
+ * @brief The parameters of u, g, e and b during a round
+ *
+ */
+typedef struct modelParamsStruct {
+    double low;
+    double high;
+    double mean;
+    double sigma;
+    double prob;
+} ModelParams;
+
+/**
+ * @typedef chunkStartStruct
+ * @brief The parameters of a randomized model, and the state of their drift, at the first round of a chunk
+ *
+ */
+typedef struct chunkStartStruct {
+    ModelParams params;
+    Sampler drift;
+} ChunkStart;
+
+/**
+ * @typedef chunkEndStruct
+ * @brief What the last price of a chunk carries into the next chunk
+ *
+ */
+typedef struct chunkEndStruct {
+    // the last price, which the next price of the AR model depends on
+    double last;
+    // the noise of the last price, which the next price of the MA model depends on
+    double lastNoise;
+} ChunkEnd;
+
+/**
+ * @typedef priceChunksStruct
+ * @brief How the prices of a model are split in chunks
+ *
+ */
+typedef struct priceChunksStruct {
+    PriceModel model;
+    // the rounds of every chunk, but the last one, which can have fewer
+    uint64_t chunkRounds;
+    uint32_t chunkCount;
+    // the start of every chunk of a randomized model, NULL when the parameters don't drift
+    ChunkStart *starts;
+    // the AR price before the first one
+    double first;
+    // what the end of a chunk of chunkRounds rounds carries of the end before it, phi^(chunkRounds * N) for AR
+    double decay;
+} PriceChunks;
+
+/**
+ * @brief Parses a model spec, <kind>[r][=<parameter>],<rounds>,<prices per round>[,<seed>], where the kind and r are
+ * the options of priceGenerator, and the seed is left as it is when it is missing
+ *
+ * @return 0 if the spec is valid, 1 otherwise
+ */
+uint8_t parsePriceModel(char *spec, PriceModel *model);
+
+/**
+ * @brief Writes the name of the file priceGenerator would write the prices of the model to, without the directory and
+ * the extension
+ */
+void getPriceModelName(PriceModel *model, char *name, size_t size);
+
+/**
+ * @brief Splits the prices of a model in chunks, and walks the drift of its parameters
+ *
+ * @return 0 on success, 1 if the starts of the chunks can't be allocated
+ */
+uint8_t planPrices(PriceModel *model, PriceChunks *chunks);
+
+void freePriceChunks(PriceChunks *chunks);
+
+/**
+ * @brief The index of the first price of a chunk, and its number of prices
+ */
+void getChunkRange(PriceChunks *chunks, uint32_t c, uint64_t *start, uint64_t *size);
+
+/**
+ * @brief Fills prices with the prices of chunk c, as if the prices before the chunk were all 0
+ *
+ * @param end Set to the end of the chunk, before it is joined
+ */
+void generateChunk(PriceChunks *chunks, uint32_t c, double *prices, ChunkEnd *end);
+
+/**
+ * @brief Adds to the prices of chunk c what the end of the previous chunk carries into them
+ *
+ * @param previous The end of chunk c - 1, after carryChunkEnd
+ */
+void joinChunk(PriceChunks *chunks, uint32_t c, double *prices, ChunkEnd *previous);
+
+/**
+ * @brief Turns the end of chunk c into its end after the chunk is joined
+ *
+ * @param previous The end of chunk c - 1, after carryChunkEnd
+ */
+void carryChunkEnd(PriceChunks *chunks, uint32_t c, ChunkEnd *previous, ChunkEnd *end);
+
+/**
+ * @brief Generates every price of a model in memory, the chunks in parallel
+ *
+ * @param data Set to an array with T * N prices, round after round, which the caller frees with freeMemory
+ * @param threads The maximum number of threads, 0 uses one per online cpu
+ * @param policy How the prices are placed in memory, NULL for the default policy. With PLACE_WORKERS the chunks are
+ * left to the threads that generate them
+ * @return 0 on success, 1 if the prices can't be allocated
+ */
+uint8_t generatePrices(PriceModel *model, double **data, uint32_t threads, const MemoryPolicy *policy);
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef HDR_PRICESTATS_H_
+#define HDR_PRICESTATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the quantiles kept of every round, at q / (ROUND_QUANTILES - 1), the first is the min and the last the max
+#define ROUND_QUANTILES 5
+// the quantiles of the global sketch, at q / (GLOBAL_QUANTILES - 1)
+#define GLOBAL_QUANTILES 257
+
+/**
+ * INFO: The statistics of a price file are calculated once, in parallel, and kept in a sidecar file next to it, so the
+ * runs on the file can read them instead of sorting prices:
+ *
+ * --------------------------------------------------
+ * every round is sorted on its own, for its quantiles, its mean and the sorted first round
+ * the prices are counted in a histogram of the global range, whose buckets sketch the global quantiles
+ * the prices in the buckets of the two middle ranks are collected and sorted, for the exact median
+ * --------------------------------------------------
+ *
+ * The statistics are of the prices as they are in the file, before they are normalized. The sorted first round and
+ * the median of the normalized prices are the same as the ones calculated from the normalized prices, to the bit.
+ */
+
+/**
+ * @typedef priceStatsStruct
+ * @brief The statistics of the prices of a file, the arrays either allocated or mapped from a sidecar file
+ *
+ */
+typedef struct priceStatsStruct {
+    uint64_t T;
+    uint64_t N;
+    double min;
+    double max;
+    double mean;
+    // the two middle prices, the same one when T * N is odd, the median is their mean
+    double lowerMedian;
+    double upperMedian;
+    // sketched from a histogram, but for the first and the last which are the min and the max
+    double *globalQuantiles;
+    double *sortedFirstRound;
+    double *roundMeans;
+    // ROUND_QUANTILES per round
+    double *roundQuantiles;
+    // the sidecar file the arrays are mapped from, NULL if they are allocated
+    uint8_t *map;
+    size_t mapSize;
+} PriceStats;
+
+/**
+ * @brief Calculates the statistics of the prices, with up to threads threads
+ *
+ * @param threads The maximum number of threads, 0 uses one per online cpu
+ * @return 0 on success, 1 if there isn't enough memory
+ */
+uint8_t computePriceStats(double *data, uint64_t T, uint64_t N, uint32_t threads, PriceStats *stats);
+
+/**
+ * @brief Writes the path of the sidecar file of a price file, its path with .stats in place of .dat
+ */
+void getPriceStatsPath(char *filepath, char *statsPath, size_t size);
+
+/**
+ * @brief Saves the statistics in the sidecar file of a price file, which records the size and the modification time
+ * of the price file so a sidecar that is older than it can be told apart
+ *
+ * @return 0 on success, 1 on a write error
+ */
+uint8_t savePriceStats(PriceStats *stats, char *filepath);
+
+/**
+ * @brief Maps the sidecar file of a price file
+ *
+ * @return 0 on success, 1 if there is no sidecar, it is damaged, or it isn't of the current price file
+ */
+uint8_t loadPriceStats(PriceStats *stats, char *filepath);
+
+void freePriceStats(PriceStats *stats);
+
+/**
+ * @brief Loads a price file, calculates its statistics and saves them in its sidecar file
+ *
+ * @return 0 on success, 1 if the file can't be read or the sidecar written
+ */
+uint8_t writePriceStats(char *filepath, uint32_t threads);
+
+/**
+ * @brief The q quantile of a round, interpolated between its kept quantiles
+ */
+double getRoundQuantile(PriceStats *stats, uint64_t round, double q);
+
+/**
+ * @brief The q quantile of all the prices, interpolated in the global sketch
+ */
+double getGlobalQuantile(PriceStats *stats, double q);
+
+/**
+ * @brief Fills sorted with the first round sorted, normalized like normalizePrices does
+ */
+void getNormalizedFirstRound(PriceStats *stats, double min, double max, double *sorted);
+
+/**
+ * @brief The median of the prices, normalized like normalizePrices does
+ */
+double getNormalizedMedian(PriceStats *stats, double min, double max);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef HDR_PROPHETIC_H_
+#define HDR_PROPHETIC_H_
+
+/**
+ * INFO: The public header of libprophetic, the simulation core without the command-line programs.
+ *
+ * It covers loading, generating and normalizing prices (loadPrices, generatePrices, getPriceRange, normalizePrices) and
+ * their statistics (computePriceStats, loadPriceStats), playing thresholds on them (runRound, runThreshold) and rolling
+ * them with the prices (moveThresholdWindow), the OPT baselines (findOpt, bestHand), the algorithms and the engine that
+ * runs them (algorithms, runAlgorithms), live sessions (initSession, observe) and checkpoints. Nothing in the library
+ * prints, plots or writes files on its own: text goes to the Reporter passed in, or nowhere if it is NULL, and files
+ * are only written for a Checkpoint or price statistics (savePriceStats) the caller asks for.
+ *
+ * Link with -lprophetic -lgsl -lgslcblas -lm -pthread.
+ */
+
+#include <armSpace.h>
+#include <banditAlgs.h>
+#include <checkpoint.h>
+#include <engine.h>
+#include <memoryPolicy.h>
+#include <metrics.h>
+#include <orderStats.h>
+#include <priceModel.h>
+#include <priceStats.h>
+#include <reporter.h>
+#include <sampler.h>
+#include <timing.h>
+#include <session.h>
+#include <util.h>
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HDR_REPLICATIONS_H_
+#define HDR_REPLICATIONS_H_
+
+#include <util.h>
+
+/**
+ * @brief Runs every stochastic algorithm enabled in b.algs many times, each time with a different seed, and keeps
+ * the per round mean and variance of their regret and competitive ratio
+ *
+ * The runs are spread over a pool of worker threads. Each run is added to the stats as soon as it finishes, so the
+ * memory used grows with the number of threads and not with the number of replications.
+ *
+ * @param data The array with the prices
+ * @param totalOpt The array that holds the optimal gain up to each round
+ * @param b A struct with various information and flags
+ * @param replications How many times each algorithm is run
+ * @param threads The number of worker threads, 0 uses one per online cpu
+ * @param regret The stats of the average regret, indexed by algorithmId, initialized by this function
+ * @param compRatio The stats of the competitive ratio, indexed by algorithmId, initialized by this function
+ */
+void runReplications(double *data, double *totalOpt, Bandit b, uint32_t replications, uint32_t threads,
+                     RunningStats *regret, RunningStats *compRatio);
+
+#endif
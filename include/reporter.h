@@ -0,0 +1,32 @@
+#ifndef HDR_REPORTER_H_
+#define HDR_REPORTER_H_
+
+#include <stdio.h>
+
+/**
+ * @typedef reporterStruct
+ * @brief Where the library sends the text it would otherwise print: progress, errors and the reports of the
+ * algorithms
+ *
+ * The library never writes to stdout itself. Every function that has something to say takes a Reporter, and a NULL
+ * reporter discards the text.
+ *
+ */
+typedef struct reporterStruct {
+    // called with each piece of text, already formatted, usually one or more whole lines
+    void (*write)(void *context, const char *text);
+    // passed to every call of write
+    void *context;
+} Reporter;
+
+/**
+ * @brief Formats the text like printf and sends it to the reporter, does nothing if reporter is NULL
+ */
+void reportf(Reporter *reporter, const char *format, ...) __attribute__((format(printf, 2, 3), nonnull(2)));
+
+/**
+ * @brief A write callback that appends the text to the FILE * given as the context
+ */
+void writeToStream(void *stream, const char *text);
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef HDR_RESULTSTORE_H_
+#define HDR_RESULTSTORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <metrics.h>
+#include <util.h>
+
+// the bytes of a column's name, including the terminating '\0'
+#define RESULT_NAME_SIZE 32
+
+/**
+ * INFO: A result store is a single binary file with every per round result of a run, one column per algorithm and
+ * metric:
+ *
+ * --------------------------------------------------
+ * ResultStoreHeader
+ * ResultColumn[columnCount]
+ * the rows of each column, as doubles, starting at the column's offset
+ * --------------------------------------------------
+ *
+ * Columns are named <algorithm>/<metric>, with the algorithm's short name or opt, and every column starts on its own
+ * page so a reader can map just the columns it needs. With a decimation of d, row i holds round min((i+1)d - 1, T - 1),
+ * so the last round is always stored.
+ */
+
+/**
+ * @typedef resultStoreHeaderStruct
+ * @brief The first bytes of a result store, describing the run and the layout of the file
+ *
+ */
+typedef struct resultStoreHeaderStruct {
+    // "PBRS"
+    uint32_t magic;
+    uint32_t version;
+    uint64_t T;
+    uint64_t N;
+    uint32_t K;
+    uint32_t thresholds;
+    uint8_t dualThres;
+    uint8_t dynamicThres;
+    uint8_t keepItems;
+    uint8_t medianOpt;
+    uint8_t bestHandOpt;
+    uint8_t reserved[3];
+    // rounds per stored row, and the number of rows of every column
+    uint64_t decimation;
+    uint64_t rows;
+    uint32_t columnCount;
+    uint32_t columnSize;
+} ResultStoreHeader;
+
+/**
+ * @typedef resultColumnStruct
+ * @brief Where a column is in a result store
+ *
+ */
+typedef struct resultColumnStruct {
+    char name[RESULT_NAME_SIZE];
+    // bytes from the start of the file
+    uint64_t offset;
+} ResultColumn;
+
+/**
+ * @typedef resultStoreStruct
+ * @brief A result store mapped in memory
+ *
+ * The file is mapped shared, so whatever is written to a column goes to the file, and the kernel writes it back in the
+ * background while the run goes on. A store that couldn't be created has no mapping, in which case every result is kept
+ * in memory and nothing is saved.
+ *
+ * With decimation, every round of every column is calculated in the arena, a single mapping sized for all the columns
+ * when the store is created, and unmapped with it. The derived metrics are left out of it, saveMetrics calculates
+ * them for the stored rows alone.
+ *
+ */
+typedef struct resultStoreStruct {
+    uint8_t *map;
+    size_t size;
+    ResultStoreHeader *header;
+    ResultColumn *columns;
+    // NULL without decimation, the columns are stride doubles apart, in the order of the file's columns
+    double *arena;
+    size_t arenaSize;
+    uint64_t arenaStride;
+} ResultStore;
+
+/**
+ * @brief Creates the result store file at path and maps it, with every value 0
+ *
+ * @param decimation Rounds per stored row, 1 to store every round
+ * @param names The names of the columns, <algorithm>/<metric>
+ * @param columnCount The number of columns
+ *
+ * @returns 0 on success, 1 if the file can't be created or a name is too long, in which case the store is left
+ * unmapped
+ */
+uint8_t createResultStore(ResultStore *store, char *path, Bandit b, uint64_t decimation, char **names,
+                          uint32_t columnCount);
+
+/**
+ * @brief Maps an existing result store, read only
+ *
+ * @returns 0 on success, 1 if the file can't be opened or isn't a result store
+ */
+uint8_t openResultStore(ResultStore *store, char *path);
+
+/**
+ * @brief Returns the rows of a column, NULL if the store has no such column
+ */
+double *getResultColumn(ResultStore *store, char *alg, char *metric);
+
+/**
+ * @brief Returns an array for the size values of a result
+ *
+ * When the store keeps every round, the array is the result's column, so the result is written to the file as it is
+ * calculated. Otherwise it is the result's part of the arena, all zeroes, saved to the store by releaseResult. A result
+ * that has no column is a new array of zeroes.
+ */
+double *allocResult(ResultStore *store, char *alg, char *metric, uint64_t size);
+
+/**
+ * @brief Saves a result returned by allocResult to its column, and frees it if it isn't the column itself or in the
+ * arena. Does nothing if values is NULL
+ */
+void releaseResult(ResultStore *store, char *alg, char *metric, double *values);
+
+/**
+ * @brief Calculates the derived metrics of an algorithm that have a column, straight into the file, for the stored
+ * rounds only. Does nothing if the store has no mapping
+ *
+ * @param alg The name the algorithm's columns start with, "opt" for OPT
+ * @param source The results the metrics are derived from, which have to hold every round
+ */
+void saveMetrics(ResultStore *store, char *alg, const MetricSource *source);
+
+/**
+ * @brief Unmaps the store and its arena, any rows still in memory are written to the file by the kernel
+ */
+void closeResultStore(ResultStore *store);
+
+/**
+ * @brief Writes a result store at path with the columns of every store of sources, each column from the first store
+ * that has it
+ *
+ * The stores have to be of the same run, with the same rounds, prices, thresholds, flags and decimation, only their
+ * columns may differ, like the stores of runs of different algorithms on the same data.
+ *
+ * @param sourceCount The number of sources
+ *
+ * @returns 0 on success, 1 if a source can't be read, the sources are of different runs or path can't be written
+ */
+uint8_t mergeResultStores(char *path, char **sources, uint32_t sourceCount);
+
+/**
+ * @brief Writes every column of the result store at path as a text file, <algorithm>/<metric>.txt in the store's
+ * directory, with a "<round> <value>" line for each row
+ *
+ * @returns 0 on success, 1 if the store can't be read or a file can't be written
+ */
+uint8_t exportResultStore(char *path);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef HDR_SAMPLER_H_
+#define HDR_SAMPLER_H_
+
+#include <stdint.h>
+
+#include <gsl/gsl_rng.h>
+
+// the generators advanced together, their number is the width of the vectors the compiler can use
+#define SAMPLER_LANES 8
+
+/**
+ * INFO: A sampler fills whole arrays with samples, instead of returning one sample per call:
+ *
+ * --------------------------------------------------
+ * the random bits of a block are drawn from SAMPLER_LANES xoshiro256++ generators, one step of all of them at a time
+ * every bits become a sample through the fast path of a ziggurat, which needs no branch but the test of the layer
+ * the few samples the fast path rejects are redrawn one at a time, from a generator of their own
+ * --------------------------------------------------
+ *
+ * The ziggurats have 256 layers, so about 99% of the normals and 98.9% of the exponentials take the fast path.
+ *
+ * A sampler made with initReferenceSampler takes every sample from GSL instead, one call per sample. It is slower,
+ * but it is the reference the distributions of the sampler can be checked against.
+ */
+
+/**
+ * @typedef samplerStruct
+ * @brief The state of a sampler
+ *
+ */
+typedef struct samplerStruct {
+    // the 4 words of the state of each lane, a word of every lane next to each other so the lanes are stepped together
+    uint64_t state[4][SAMPLER_LANES];
+    // the generator of the samples that are redrawn, and of single samples
+    uint64_t single[4];
+    // when not NULL, every sample comes from it through GSL
+    gsl_rng *reference;
+} Sampler;
+
+/**
+ * @brief Seeds the lanes and the single generator of the sampler, from a seed expanded with splitmix64
+ */
+void initSampler(Sampler *sampler, uint64_t seed);
+
+/**
+ * @brief Seeds the sampler with one of many independent streams of a seed, so work split in parts can give each part
+ * its own sampler and still depend only on the seed
+ */
+void initSamplerStream(Sampler *sampler, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Makes a sampler that takes its samples from GSL, through rng, which the sampler doesn't free
+ */
+void initReferenceSampler(Sampler *sampler, gsl_rng *rng);
+
+/**
+ * @brief Fills values with uniform samples in [0,1)
+ */
+void fillUniform(Sampler *sampler, double *values, uint64_t size);
+
+/**
+ * @brief Fills values with samples of the standard normal distribution
+ */
+void fillNormal(Sampler *sampler, double *values, uint64_t size);
+
+/**
+ * @brief Fills values with samples of the exponential distribution with mean 1
+ */
+void fillExponential(Sampler *sampler, double *values, uint64_t size);
+
+double sampleUniform(Sampler *sampler);
+
+double sampleNormal(Sampler *sampler);
+
+double sampleExponential(Sampler *sampler);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef HDR_SESSION_H_
+#define HDR_SESSION_H_
+
+#include <stdint.h>
+
+#include <armSpace.h>
+#include <banditAlgs.h>
+#include <reporter.h>
+#include <util.h>
+
+/**
+ * @typedef sessionStruct
+ * @brief One algorithm trading a live feed of prices, given one at a time
+ *
+ * Every b.N prices make a round, like a round of the data of an offline run. The arm of a round is chosen before its
+ * first price and the reward of the round is fed back to the algorithm after its last one, so a price in the middle of
+ * a round costs a normalization and two comparisons. The price that ends a round also pays for the algorithm's update
+ * and select, O(played arms) for the UCB algorithms. Room for every arm is reserved when the session starts, so
+ * nothing is allocated while prices are observed.
+ *
+ */
+typedef struct sessionStruct {
+    const Algorithm *alg;
+    void *state;
+    ArmSpace arms;
+    Bandit b;
+    // the prices are normalized to [0,1] with these bounds, like the data of an offline run
+    double priceMin;
+    double priceMax;
+    // the current round, and the index of the next price in it
+    uint64_t round;
+    uint64_t price;
+    // the arm of the current round and its thresholds
+    uint32_t th;
+    double low;
+    double high;
+    double roundGain;
+    double totalGain;
+    uint8_t heldItems;
+    double heldItemValue;
+} Session;
+
+/**
+ * @brief Starts a session of an algorithm and chooses the arm of its first round
+ *
+ * @param id The algorithmId of the algorithm, which has to be online
+ * @param b A struct with various information and flags, b.T is the horizon the algorithm plans for and, with
+ * b.keepItems, the round that ends with the held item sold
+ * @param priceMin The price that is normalized to 0
+ * @param priceMax The price that is normalized to 1
+ * @param reporter Where the reason a session can't be started is sent
+ *
+ * @returns 0 on success, 1 if the algorithm or the flags can't be used on a live feed
+ */
+uint8_t initSession(Session *session, uint32_t id, Bandit b, double priceMin, double priceMax, Reporter *reporter);
+
+/**
+ * @brief Trades the next price of the feed with the threshold of the current round
+ *
+ * @returns The tradeAction taken. On the last price of a round it is returned after the algorithm has been updated and
+ * has chosen the arm of the next round
+ */
+uint8_t observe(Session *session, double price);
+
+void freeSession(Session *session);
+
+#endif
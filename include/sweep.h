@@ -0,0 +1,59 @@
+#ifndef HDR_SWEEP_H_
+#define HDR_SWEEP_H_
+
+#include <stdint.h>
+
+#include <util.h>
+
+/**
+ * @typedef sweepStruct
+ * @brief The values each swept parameter takes. A parameter with no values keeps the one set on the command line
+ *
+ */
+typedef struct sweepStruct {
+    // numbers of thresholds, like -t
+    uint32_t *K;
+    uint32_t KCount;
+    double *ucb2Alpha;
+    uint32_t ucb2AlphaCount;
+    double *eGreedyScale;
+    uint32_t eGreedyScaleCount;
+    double *exp3UpperBound;
+    uint32_t exp3UpperBoundCount;
+    uint64_t *swUcbWindow;
+    uint32_t swUcbWindowCount;
+    double *dUcbDiscount;
+    uint32_t dUcbDiscountCount;
+} Sweep;
+
+/**
+ * @brief Adds the values of a parameter, given as <name>=<value>,<value>,..., to the sweep
+ *
+ * The names are K, ucb2Alpha, eGreedyScale, exp3UpperBound, swUcbWindow and dUcbDiscount. Giving the same parameter
+ * again adds to its values.
+ *
+ * @returns 0 on success, 1 if the parameter or one of its values is invalid
+ */
+uint8_t addSweepParam(Sweep *sweep, char *param);
+
+void freeSweep(Sweep *sweep);
+
+/**
+ * @brief Runs the algorithms enabled in b.algs once for every combination of the sweep's values, and saves the results
+ * of each combination in the result store of its own result directory
+ *
+ * The data is loaded once and everything that doesn't depend on K, the OPT and the statistics in
+ * b.sortedFirstRound and b.dataMedian unless they are already set, is calculated once and shared by all the
+ * combinations. The combinations are spread over a pool of worker threads, the most expensive first, and their
+ * reports are printed in order at the end followed by a summary of the final results.
+ *
+ * @param data The array with the normalized prices
+ * @param filepath The name of the data file, used for the result directories
+ * @param b A struct with various information and flags, b.thresholds is used when no K is swept
+ * @param sweep The values of the swept parameters
+ * @param threads The number of worker threads, 0 uses one per online cpu
+ * @param decimation Rounds per row of the result stores, 1 to store every round
+ */
+void runSweep(double *data, char *filepath, Bandit b, Sweep *sweep, uint32_t threads, uint64_t decimation);
+
+#endif
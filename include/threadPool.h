@@ -0,0 +1,19 @@
+#ifndef HDR_THREADPOOL_H_
+#define HDR_THREADPOOL_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Runs taskCount independent tasks on a pool of worker threads
+ *
+ * The workers claim the tasks in order, one at a time, so a worker that finishes early keeps picking up the
+ * remaining tasks. Returns after every task has finished.
+ *
+ * @param taskCount The number of tasks
+ * @param threads The maximum number of worker threads, 0 uses one per online cpu
+ * @param task The function that runs the ith task
+ * @param arg Passed to every call of task
+ */
+void runTasks(uint32_t taskCount, uint32_t threads, void (*task)(void *arg, uint32_t i), void *arg);
+
+#endif
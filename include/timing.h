@@ -0,0 +1,175 @@
+#ifndef HDR_TIMING_H_
+#define HDR_TIMING_H_
+
+#include <stdint.h>
+
+#include <reporter.h>
+#include <util.h>
+
+// the most phases a run is split into, besides its algorithms
+#define TIMING_PHASES 16
+
+/**
+ * INFO: Timings are only taken when a Timings struct is passed in. Every function here does nothing with a NULL one,
+ * and the engine only reads the clock for the algorithms whose results have a timing, so a run that isn't timed only
+ * pays for a check of a pointer.
+ *
+ * With profiling, the hardware counters of the thread are read along with the clock, through perf_event_open. A
+ * counter the kernel or the cpu doesn't offer is left out, and without any of them only the time is taken. Only user
+ * space events are counted, so the reads themselves add little besides their time.
+ */
+
+/**
+ * @enum counterId
+ * @brief The hardware events counted while profiling
+ *
+ */
+enum counterId { COUNTER_CYCLES, COUNTER_INSTRUCTIONS, COUNTER_BRANCH_MISSES, COUNTER_LLC_MISSES, COUNTER_COUNT };
+
+// the names of the counters, indexed by counterId
+extern const char *counterNames[COUNTER_COUNT];
+
+/**
+ * @typedef countersStruct
+ * @brief The open hardware counters of a thread
+ *
+ */
+typedef struct countersStruct {
+    // -1 for a counter that couldn't be opened
+    int fds[COUNTER_COUNT];
+    // the counter every other one is read with in a single call, -1 when they are read one at a time
+    int leader;
+} Counters;
+
+/**
+ * @typedef phaseMarkStruct
+ * @brief The clock and the counters when a phase started
+ *
+ */
+typedef struct phaseMarkStruct {
+    uint64_t ns;
+    uint64_t counts[COUNTER_COUNT];
+} PhaseMark;
+
+/**
+ * @typedef phaseTimeStruct
+ * @brief The time spent in a phase and the work done in it, from which its throughput is derived
+ *
+ */
+typedef struct phaseTimeStruct {
+    const char *name;
+    uint64_t ns;
+    uint64_t rounds;
+    uint64_t prices;
+    uint64_t bytes;
+    // indexed by counterId, only set while profiling
+    uint64_t counts[COUNTER_COUNT];
+} PhaseTime;
+
+/**
+ * @typedef algTimingStruct
+ * @brief The time an algorithm spent playing its rounds, and deriving its metrics afterwards
+ *
+ */
+typedef struct algTimingStruct {
+    PhaseTime run;
+    PhaseTime derive;
+    // true to also count the hardware events of the algorithm, on the thread it runs on
+    uint8_t profile;
+} AlgTiming;
+
+/**
+ * @typedef timingsStruct
+ * @brief The timed phases of a run, in the order they first ended, and the timing of each algorithm
+ *
+ */
+typedef struct timingsStruct {
+    PhaseTime phases[TIMING_PHASES];
+    uint32_t phaseCount;
+    // indexed by algorithmId, only the algorithms that ran have any rounds
+    AlgTiming algs[ALG_COUNT];
+    // the counters of the thread that started profiling and of every thread it starts afterwards
+    uint8_t profiling;
+    Counters counters;
+} Timings;
+
+/**
+ * @brief Returns the time of the monotonic clock in nanoseconds
+ */
+uint64_t monotonicNs();
+
+/**
+ * @brief Opens the hardware counters of the calling thread
+ *
+ * @param inherit True to also count the threads it starts afterwards, whose counts are added once they exit. The
+ * counters are then read one at a time, otherwise with a single call
+ *
+ * @returns 0 if at least one counter was opened, 1 if none could be
+ */
+uint8_t openCounters(Counters *counters, uint8_t inherit);
+
+/**
+ * @brief Reads the counters into counts, indexed by counterId, a counter that isn't open reads as 0
+ */
+void readCounters(Counters *counters, uint64_t *counts);
+
+void closeCounters(Counters *counters);
+
+/**
+ * @brief Sets mark to the current clock, and counters if they are not NULL
+ */
+void markPhase(Counters *counters, PhaseMark *mark);
+
+/**
+ * @brief Adds the time and the counts since mark to phase, and moves mark to now
+ *
+ * @param counters The counters mark was taken with, or NULL
+ */
+void chargePhase(PhaseTime *phase, Counters *counters, PhaseMark *mark);
+
+/**
+ * @brief Opens the counters of the run, which every phase started afterwards is profiled with, and has every
+ * algorithm profiled on its own thread
+ *
+ * @param reporter Where the counters that can't be opened are sent
+ *
+ * @returns 0 if at least one counter was opened, 1 if none could be, in which case only the time is taken
+ */
+uint8_t startProfiling(Timings *timings, Reporter *reporter);
+
+void stopProfiling(Timings *timings);
+
+/**
+ * @brief Returns the mark a phase starts at, zeroed without timings
+ */
+PhaseMark startPhase(Timings *timings);
+
+/**
+ * @brief Adds the time and the counts since start and the work done to the phase called name, which is added to the
+ * timings the first time it ends, so a phase can be split in parts
+ *
+ * @param name The name of the phase, which has to outlive the timings
+ * @param start What startPhase returned when the phase started
+ */
+void endPhase(Timings *timings, const char *name, PhaseMark start, uint64_t rounds, uint64_t prices, uint64_t bytes);
+
+/**
+ * @brief Adds the time and the counts since mark to phase, which can be any phase of the timings, such as the metrics
+ * of an algorithm, and moves mark to now
+ */
+void chargeTiming(Timings *timings, PhaseTime *phase, PhaseMark *mark);
+
+/**
+ * @brief Ends the phase called name, without counting any work, and starts the next one at the same time
+ *
+ * @param start What startPhase returned when the phase started, set to the start of the next phase
+ */
+void switchPhase(Timings *timings, const char *name, PhaseMark *start);
+
+/**
+ * @brief Sends a table of the phases and the algorithms, with their time and throughput, to the reporter, followed by
+ * their hardware counts if they were profiled
+ */
+void reportTimings(Timings *timings, Reporter *reporter);
+
+#endif
@@ -3,6 +3,29 @@
 
 #include <stdint.h>
 
+#include <memoryPolicy.h>
+
+/**
+ * @brief The ids of the available algorithms, also their index in the algorithm registry
+ */
+enum algorithmId {
+    ALG_MEDIAN,
+    ALG_GREEDY,
+    ALG_EGREEDY,
+    ALG_SUCCELIM,
+    ALG_UCB1,
+    ALG_UCB2,
+    ALG_EXP3,
+    ALG_HOO,
+    ALG_SWUCB,
+    ALG_DUCB,
+    ALG_COUNT
+};
+
+// the default values of the algorithms' hyperparameters
+#define DEFAULT_UCB2_ALPHA 0.001
+#define DEFAULT_EGREEDY_SCALE 1.0
+
 /**
  * @typedef banditStruct
  * @brief A struct that holds flags and information about the data
@@ -18,13 +41,34 @@ typedef struct banditStruct {
     uint8_t bestHandOpt;
     uint8_t keepItems;
     uint8_t dynamicThres;
-    uint8_t median;
-    uint8_t greedy;
-    uint8_t eGreedy;
-    uint8_t succElim;
-    uint8_t ucb1;
-    uint8_t ucb2;
-    uint8_t exp3;
+    // with dynamic thresholds, the rounds before each round whose quantiles are its thresholds. 0 keeps the quantiles
+    // of the first round for every round
+    uint64_t rollingRounds;
+    // how the prices and the results are placed in memory, and if the round loops prefetch the next round
+    MemoryPolicy memory;
+    // the rounds whose arms are picked together, from the state before any of them is played, and whose rewards are
+    // only fed back once all of them are. 0 or 1 feeds back every round
+    uint64_t batch;
+    // the threads that play the rounds of a batch, 0 for the calling thread alone
+    uint32_t batchThreads;
+    // seed of the random number generators of the stochastic algorithms
+    uint64_t seed;
+    // true for each algorithm that is to be run, indexed by algorithmId
+    uint8_t algs[ALG_COUNT];
+    // the a of ucb2's tau(r) = ceil((1 + a)^r)
+    double ucb2Alpha;
+    // the c of epsilon greedy's e_t = (c * K * log(t) / t)^(1 / 3)
+    double eGreedyScale;
+    // the g of exp3's gamma, 0 uses the number of rounds
+    double exp3UpperBound;
+    // the number of rounds sliding window ucb remembers, 0 uses 2 * sqrt(T * log(T))
+    uint64_t swUcbWindow;
+    // the factor discounted ucb multiplies the past rewards by each round, 0 uses 1 - 1 / (4 * sqrt(T))
+    double dUcbDiscount;
+    // statistics of the data that don't depend on K, so runs with different K can share them. NULL if they haven't
+    // been calculated, in which case every run calculates its own
+    double *sortedFirstRound;
+    double *dataMedian;
 } Bandit;
 
 /**
@@ -44,6 +88,36 @@ typedef struct thresholdStruct {
     double avgReward;
 } Threshold;
 
+/**
+ * @typedef runningStatsStruct
+ * @brief The per round mean and variance of a result over many runs, updated one run at a time with Welford's
+ * algorithm
+ *
+ */
+typedef struct runningStatsStruct {
+    // how many runs have been added, 0 if the stats are unused
+    uint64_t count;
+    double *mean;
+    // sum of squared differences from the mean
+    double *m2;
+} RunningStats;
+
+/**
+ * @brief Calculates the b.thresholds values a threshold can take, evenly spaced in [0,1] or, with dynamic
+ * thresholds, the quantiles of the first round
+ *
+ * @param threshold An array of b.thresholds values
+ */
+void initThresholdValues(double *threshold, Bandit b, double *data);
+
+/**
+ * @brief Sets the low and high threshold of every threshold struct from the values a threshold can take, in the
+ * order of initThreshold, leaving their statistics as they are
+ *
+ * @param threshold An array of b.thresholds values
+ */
+void seedThresholds(Threshold *thres, Bandit b, double *threshold);
+
 /**
  * @brief Initializes the array of threshold structs' values to 0
  *
@@ -53,11 +127,21 @@ typedef struct thresholdStruct {
 void initThreshold(Threshold *thres, Bandit b, double *data);
 
 /**
- * @brief Updates the threhold array's values for the specific threshold that
- * has been chosen
+ * @brief Copies the prices of the first round to sorted, in ascending order
  *
- * @param thres Threshold array
- * @param th The chosen threshold
+ * @param sorted An array of b.N values
+ */
+void sortFirstRound(Bandit b, double *data, double *sorted);
+
+/**
+ * @brief Returns the median of all the prices
+ */
+double getDataMedian(Bandit b, double *data);
+
+/**
+ * @brief Plays a threshold for a round and updates its statistics
+ *
+ * @param arm The chosen threshold
  * @param data The array with the prices
  * @param avgHighThreshold The array that holds the average chosen upper threshold of each round
  * @param avgLowThreshold The array that holds the average chosen lower threshold of each round
@@ -69,13 +153,56 @@ void initThreshold(Threshold *thres, Bandit b, double *data);
  *
  * @returns The reward of the round
  */
-double runRound(Threshold *thres, uint32_t th, Bandit b, double *data, double *avgLowThreshold,
-                double *avgHighThreshold, double *avgTrades, double *totalGain, uint64_t round, uint8_t *heldItems,
-                double *heldItemValue);
+double runRound(Threshold *arm, Bandit b, double *data, double *avgLowThreshold, double *avgHighThreshold,
+                double *avgTrades, double *totalGain, uint64_t round, uint8_t *heldItems, double *heldItemValue);
 
 double runThreshold(double low, double high, Bandit b, double *data, uint32_t *trades, uint64_t round,
                     uint8_t *heldItems, double *heldItemValue);
 
+/**
+ * @brief Adds a round played with runThreshold to the results and to the statistics of the threshold, the second half
+ * of runRound
+ *
+ * @param gain The reward of the round
+ * @param trades The items sold in the round
+ */
+void recordRound(Threshold *arm, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
+                 double *totalGain, uint64_t round, double gain, uint32_t trades);
+
+/**
+ * @brief What is done with a single price
+ */
+enum tradeAction { TRADE_HOLD, TRADE_BUY, TRADE_SELL };
+
+/**
+ * @brief Trades a single price: the held item is sold if the price is over the high threshold or it is the last price
+ * it can be sold at, otherwise an item is bought if none is held and the price is at most the low threshold
+ *
+ * @param lastPrice True if the item has to be sold at this price
+ * @param gain Increased by the profit of the item if it is sold
+ *
+ * @returns The tradeAction taken
+ */
+static inline uint8_t tradePrice(double price, double low, double high, uint8_t lastPrice, uint8_t *heldItems,
+                                 double *heldItemValue, double *gain) {
+    if ((lastPrice || price > high) && *heldItems == 1) {
+        *gain += price - *heldItemValue;
+        *heldItems = 0;
+        return TRADE_SELL;
+    } else if (!lastPrice && price <= low && *heldItems == 0) {
+        *heldItemValue = price;
+        *heldItems = 1;
+        return TRADE_BUY;
+    }
+
+    return TRADE_HOLD;
+}
+
+/**
+ * @brief Adds the reward of a round to the statistics of the threshold that was played
+ */
+void addReward(Threshold *arm, double gain);
+
 /**
  * @brief Normalizes a 2D array represented in 1D in [0,1]
  *
@@ -87,54 +214,48 @@ double runThreshold(double low, double high, Bandit b, double *data, uint32_t *t
 void normalizePrices(double min, double max, double *data, uint64_t size);
 
 /**
- * @brief Calculates the average regret pre round for a specific algorithm
+ * @brief Reads a .dat file of prices, two 64bit integers for the number of rounds T and the prices per round N,
+ * followed by the T * N prices as doubles
+ *
+ * @param data Set to an array with the prices allocated by allocMemory, which the caller frees with freeMemory, NULL
+ * on an error
+ * @param policy How the prices are placed in memory, NULL for the default policy
+ * @param threads The workers that first write the prices with PLACE_WORKERS, 0 uses one per online cpu
  *
- * @param totalRounds The total number of rounds
- * @param algAvgRegret The array that saves the average regret
- * @param totalOpt The array with the optimal gain an algorithm can achieve by
- * each round
- * @param algGain The array with the gain an algorithm has achieved by each
- * round
+ * @returns 0 on success, 1 if the file can't be opened or is shorter than its header says
  */
-void getAvgRegret(uint64_t totalRounds, double *algAvgRegret, double *totalOpt, double *algGain);
-
-void getAvgGain(uint64_t size, double *avgGain, double *totalGain);
+uint8_t loadPrices(char *filepath, double **data, uint64_t *totalRounds, uint64_t *pricesPerRound,
+                   const MemoryPolicy *policy, uint32_t threads);
 
-void getCompRatio(uint64_t totalRounds, double *algCompRatio, double *totalOpt, double *algGain);
-
-void getAvgTradeGain(uint64_t totalRounds, double *algGain, double *algAvgTrades, double *algAvgTradeGain);
+/**
+ * @brief Finds the bounds the prices are normalized with: the smallest and the largest price, widened to include
+ * [0,1] so prices already in it are left as they are
+ *
+ * @param size The number of prices
+ */
+void getPriceRange(double *data, uint64_t size, double *min, double *max);
 
 /**
- * @brief Plots the needed information per day for each algorithm using gnuplot
+ * @brief Allocates the arrays of a RunningStats struct, with every value set to 0
  *
- * @param ylabel The title that appears on the plot window
- * @param b A struct with various information and flags
- * @param opt, median, greedy, eGreedy, succElim, ucb1, ucb2, exp3 The array that holds the
- * information to be plotted for each algorithm for each round
- * @param bounded True when the plotted values need to be bounded in [0,1]
+ * @param stats The struct to initialize
+ * @param size The number of values kept, usually the number of rounds
  */
-void plotAlgorithms(char *ylabel, Bandit b, double *opt, double *median, double *greedy, double *eGreedy,
-                    double *succElim, double *ucb1, double *ucb2, double *exp3, uint8_t bounded);
+void initRunningStats(RunningStats *stats, uint64_t size);
 
-void plotData(double *data, uint64_t size);
+void freeRunningStats(RunningStats *stats);
 
-void plotThresholds(Bandit b, double *optLow, double *optHigh, double *median, double *greedyLow, double *greedyHigh,
-                    double *eGreedyLow, double *eGreedyHigh, double *succElimLow, double *succElimHigh, double *ucb1Low,
-                    double *ucb1High, double *ucb2Low, double *ucb2High, double *exp3Low, double *exp3High);
+/**
+ * @brief Returns the sample variance of the ith value
+ */
+double getVariance(RunningStats *stats, uint64_t i);
 
 /**
- * @brief Saves the plotted regret and competitive ratio in a file. Used to compare results between different number of
- * thresholds
+ * @brief Adds the runs of other to stats, as if each of them had been added to it
  *
- * @param filepath The name of the data file
- * @param b A struct with various information and flags
- * @param avgRegret The array that holds the average regret for each round
- * @param compRatio The array that holds the competitive ratio for each round
+ * @param size The number of values of both, usually the number of rounds
  */
-void saveResults(char *filepath, Bandit b, char *resultType, double *median, double *greedy,
-                 double *eGreedy, double *succElim, double *ucb1, double *ucb2, double *exp3);
-
-void saveAlgResults(char *resultPath, Bandit b, char *algName, char *resultType, double *result);
+void mergeRunningStats(RunningStats *stats, RunningStats *other, uint64_t size);
 
 void mkdir_p(char *path);
 
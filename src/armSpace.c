@@ -0,0 +1,220 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <armSpace.h>
+#include <util.h>
+
+static uint32_t hashArm(ArmSpace *space, uint32_t th) {
+    // fibonacci hashing, the table size is a power of 2
+    return (th * 2654435761u) & (space->tableSize - 1);
+}
+
+static void insertSlot(ArmSpace *space, uint32_t th, uint32_t slot) {
+    uint32_t i = hashArm(space, th);
+    while (space->table[i]) {
+        i = (i + 1) & (space->tableSize - 1);
+    }
+    space->table[i] = slot + 1;
+}
+
+void initArmSpace(ArmSpace *space, Bandit b, double *data, size_t armStateSize) {
+    space->K = b.K;
+    space->thresholds = b.thresholds;
+    space->dualThres = b.dualThres;
+    space->threshold = malloc(b.thresholds * sizeof(double));
+    initThresholdValues(space->threshold, b, data);
+    space->window = nullptr;
+
+    space->playedCount = 0;
+    space->capacity = 16;
+    space->playedId = malloc(space->capacity * sizeof(uint32_t));
+    space->played = malloc(space->capacity * sizeof(Threshold));
+    space->armStateSize = armStateSize;
+    space->armState = malloc(space->capacity * armStateSize);
+
+    space->tableSize = 2 * space->capacity;
+    space->table = calloc(space->tableSize, sizeof(uint32_t));
+    space->firstUnplayed = 0;
+}
+
+void freeArmSpace(ArmSpace *space) {
+    free(space->threshold);
+    free(space->playedId);
+    free(space->played);
+    free(space->armState);
+    free(space->table);
+}
+
+void reseedArmSpace(ArmSpace *space, double *threshold) {
+    memcpy(space->threshold, threshold, space->thresholds * sizeof(double));
+    for (uint32_t slot = 0; slot < space->playedCount; slot++) {
+        getArmThresholds(space, space->playedId[slot], &space->played[slot].low, &space->played[slot].high);
+    }
+}
+
+void getArmThresholds(ArmSpace *space, uint32_t th, double *low, double *high) {
+    if (!space->dualThres) {
+        *low = space->threshold[th];
+        *high = space->threshold[th];
+        return;
+    }
+
+    /* INFO: Row l of the triangle holds the pairs (l, l), (l, l + 1), ..., (l, thresholds - 1) and starts at
+     * start(l) = l * (2 * thresholds - l + 1) / 2. The row of th is the largest l with start(l) <= th, which is the
+     * smaller root of the quadratic, rounded down. The loops fix any rounding error of the square root.
+     */
+    uint64_t n = space->thresholds;
+    double root = 2.0 * n + 1;
+    uint64_t l = (uint64_t) ((root - sqrt(root * root - 8.0 * th)) / 2);
+    while (l > 0 && l * (2 * n - l + 1) / 2 > th) {
+        l--;
+    }
+    while ((l + 1) * (2 * n - l) / 2 <= th) {
+        l++;
+    }
+    uint64_t h = l + th - l * (2 * n - l + 1) / 2;
+
+    *low = space->threshold[l];
+    *high = space->threshold[h];
+}
+
+uint32_t armSlot(ArmSpace *space, uint32_t th) {
+    uint32_t i = hashArm(space, th);
+    while (space->table[i]) {
+        uint32_t slot = space->table[i] - 1;
+        if (space->playedId[slot] == th) {
+            return slot;
+        }
+        i = (i + 1) & (space->tableSize - 1);
+    }
+
+    return ARM_UNPLAYED;
+}
+
+void reserveArms(ArmSpace *space, uint32_t capacity) {
+    if (capacity <= space->capacity) {
+        return;
+    }
+
+    space->capacity = capacity;
+    space->playedId = realloc(space->playedId, space->capacity * sizeof(uint32_t));
+    space->played = realloc(space->played, space->capacity * sizeof(Threshold));
+    space->armState = realloc(space->armState, space->capacity * space->armStateSize);
+
+    // keep the table at most half full, its size has to be a power of 2
+    uint32_t tableSize = space->tableSize;
+    while (tableSize < 2 * (uint64_t) space->capacity) {
+        tableSize *= 2;
+    }
+    if (tableSize != space->tableSize) {
+        free(space->table);
+        space->tableSize = tableSize;
+        space->table = calloc(space->tableSize, sizeof(uint32_t));
+        for (uint32_t i = 0; i < space->playedCount; i++) {
+            insertSlot(space, space->playedId[i], i);
+        }
+    }
+}
+
+uint32_t playArm(ArmSpace *space, uint32_t th) {
+    uint32_t slot = armSlot(space, th);
+    if (slot != ARM_UNPLAYED) {
+        return slot;
+    }
+
+    if (space->playedCount == space->capacity) {
+        reserveArms(space, 2 * space->capacity);
+    }
+
+    slot = space->playedCount++;
+    space->playedId[slot] = th;
+    space->played[slot] = (Threshold) {0};
+    getArmThresholds(space, th, &space->played[slot].low, &space->played[slot].high);
+    if (space->armStateSize) {
+        memset(getArmState(space, slot), 0, space->armStateSize);
+    }
+    insertSlot(space, th, slot);
+
+    return slot;
+}
+
+Threshold getArm(ArmSpace *space, uint32_t th) {
+    Threshold arm = {0};
+
+    uint32_t slot = armSlot(space, th);
+    if (slot != ARM_UNPLAYED) {
+        return space->played[slot];
+    }
+
+    getArmThresholds(space, th, &arm.low, &arm.high);
+    return arm;
+}
+
+void *getArmState(ArmSpace *space, uint32_t slot) {
+    return space->armState + slot * space->armStateSize;
+}
+
+static int compareIdSlot(const void *a, const void *b) {
+    uint64_t idSlotA = *(const uint64_t *) a;
+    uint64_t idSlotB = *(const uint64_t *) b;
+    return (idSlotA > idSlotB) - (idSlotA < idSlotB);
+}
+
+uint32_t *sortPlayedArms(ArmSpace *space) {
+    // the id is in the upper half, so sorting the pairs as integers sorts them by id
+    uint64_t *idSlot = malloc(space->playedCount * sizeof(uint64_t));
+    for (uint32_t slot = 0; slot < space->playedCount; slot++) {
+        idSlot[slot] = (uint64_t) space->playedId[slot] << 32 | slot;
+    }
+    qsort(idSlot, space->playedCount, sizeof(uint64_t), compareIdSlot);
+
+    uint32_t *slots = malloc(space->playedCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < space->playedCount; i++) {
+        slots[i] = (uint32_t) idSlot[i];
+    }
+    free(idSlot);
+
+    return slots;
+}
+
+uint32_t firstUnplayedArm(ArmSpace *space) {
+    while (space->firstUnplayed < space->K && armSlot(space, space->firstUnplayed) != ARM_UNPLAYED) {
+        space->firstUnplayed++;
+    }
+
+    return space->firstUnplayed;
+}
+
+uint8_t writeArmSpace(ArmSpace *space, FILE *file) {
+    uint8_t error = fwrite(&space->playedCount, sizeof(uint32_t), 1, file) != 1;
+    error |= fwrite(space->playedId, sizeof(uint32_t), space->playedCount, file) != space->playedCount;
+    error |= fwrite(space->played, sizeof(Threshold), space->playedCount, file) != space->playedCount;
+    if (space->armStateSize)
+        error |= fwrite(space->armState, space->armStateSize, space->playedCount, file) != space->playedCount;
+
+    return error;
+}
+
+uint8_t readArmSpace(ArmSpace *space, FILE *file) {
+    uint32_t playedCount;
+    if (fread(&playedCount, sizeof(uint32_t), 1, file) != 1 || playedCount > space->K) {
+        return 1;
+    }
+
+    // the arms are played in the order of their slots, so they end up in the same ones
+    for (uint32_t i = 0; i < playedCount; i++) {
+        uint32_t th;
+        if (fread(&th, sizeof(uint32_t), 1, file) != 1 || th >= space->K || playArm(space, th) != i) {
+            return 1;
+        }
+    }
+
+    uint8_t error = fread(space->played, sizeof(Threshold), playedCount, file) != playedCount;
+    if (space->armStateSize)
+        error |= fread(space->armState, space->armStateSize, playedCount, file) != playedCount;
+
+    return error;
+}
@@ -0,0 +1,199 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <banditAlgs.h>
+#include <util.h>
+
+/**
+ * INFO: The discounted ucb (D-UCB) algorithm in short:
+ *
+ * --------------------------------------------------
+ * try each arm once
+ * for each round t
+ *   pick arm which maximizes UCB_t, with the reward of round s weighted by g^(t - s)
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * UCB_t_a  = m_t_a + r_t_a
+ * m_t_a = X_t_a / n_t_a
+ * r_t_a = sqrt(2 * log(n_t) / n_t_a)
+ * X_t_a = sum of g^(t - s) * reward of round s, over the rounds s < t where arm a was chosen
+ * n_t_a = sum of g^(t - s), over the rounds s < t where arm a was chosen
+ * n_t = sum of n_t_a over all the arms
+ * g = the discount factor, b.dUcbDiscount, or 1 - 1 / (4 * sqrt(T)) if it isn't set
+ *
+ * the old rounds fade away instead of leaving a window all at once, so the algorithm follows prices whose
+ * distribution drifts. Instead of multiplying the sums of every arm by g each round, they are all kept divided by a
+ * common scale g^t and only the arm that is played is updated, so each round costs O(1). When the scale gets too small
+ * it is folded into the sums, which happens once every few hundred rounds at worst
+ */
+
+// the scale is folded into the sums before it gets close to underflowing
+#define DUCB_MIN_SCALE 1e-100
+
+typedef struct dUcbStateStruct {
+    double discount;
+    // every discounted sum is the stored value times scale
+    double scale;
+    // n_t / scale
+    double totalChosen;
+    double norm;
+} DUcbState;
+
+typedef struct dUcbArmStruct {
+    // X_t_a / scale and n_t_a / scale
+    double rewardSum;
+    double timesChosen;
+    double upperConfBound;
+} DUcbArm;
+
+double getDUcbDiscount(Bandit b) {
+    if (b.dUcbDiscount) {
+        return b.dUcbDiscount;
+    }
+    return 1 - 1 / (4 * sqrt((double) b.T));
+}
+
+static void *dUcbInit(ArmSpace *arms, Bandit b, double *data) {
+    DUcbState *s = malloc(sizeof(DUcbState));
+
+    s->discount = getDUcbDiscount(b);
+    s->scale = 1;
+    s->totalChosen = 0;
+    s->norm = -INFINITY;
+
+    return s;
+}
+
+static uint32_t dUcbSelect(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    DUcbState *s = state;
+
+    uint32_t unplayed = firstUnplayedArm(arms);
+    if (unplayed < b.K) {
+        return unplayed;
+    }
+
+    double maxUCB = -INFINITY;
+    uint32_t chosenTh = 0;
+    double logTotal = log(s->totalChosen * s->scale);
+
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        DUcbArm *a = getArmState(arms, slot);
+        double timesChosen = a->timesChosen * s->scale;
+        if (timesChosen > 0) {
+            // the scale cancels out in the average
+            double average = fmax(a->rewardSum / a->timesChosen / s->norm, 0);
+            double confRadius = sqrt(2 * logTotal / timesChosen);
+            a->upperConfBound = average + confRadius;
+        } else {
+            // with a small discount the count of an arm that hasn't been played for long underflows, and the arm is
+            // as unknown as an unplayed one
+            a->upperConfBound = INFINITY;
+        }
+
+        if (a->upperConfBound > maxUCB) {
+            maxUCB = a->upperConfBound;
+            chosenTh = arms->playedId[slot];
+        }
+    }
+
+    return chosenTh;
+}
+
+static void dUcbUpdate(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    DUcbState *s = state;
+
+    if (s->norm < gain) {
+        s->norm = gain;
+    }
+
+    // discounting every past round once more is the same as shrinking the scale
+    s->scale *= s->discount;
+    if (s->scale < DUCB_MIN_SCALE) {
+        for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+            DUcbArm *a = getArmState(arms, slot);
+            a->rewardSum *= s->scale;
+            a->timesChosen *= s->scale;
+        }
+        s->totalChosen *= s->scale;
+        s->scale = 1;
+    }
+
+    // the current round has weight 1
+    DUcbArm *a = getArmState(arms, armSlot(arms, th));
+    a->rewardSum += gain / s->scale;
+    a->timesChosen += 1 / s->scale;
+    s->totalChosen += 1 / s->scale;
+}
+
+static void dUcbReport(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    DUcbState *s = state;
+
+    fprintf(out, "\n");
+    fprintf(out, "--------------------------------------D-UCB--------------------------"
+            "-----------\n");
+    fprintf(out, "Discount: %lf\n", s->discount);
+    uint32_t *slots = sortPlayedArms(arms);
+    if (!b.dualThres) {
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\tDiscounted\tUCB\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            DUcbArm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.4lf\t%-.5lf\n", arm->low, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward, a->timesChosen * s->scale, a->upperConfBound);
+        }
+    } else {
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\tDiscounted\tUCB\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            DUcbArm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.4lf\t%-.5lf\n", arm->low, arm->high,
+                    arm->rewardSum, arm->timesChosen, arm->avgReward, a->timesChosen * s->scale, a->upperConfBound);
+        }
+    }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
+
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
+}
+
+static uint8_t dUcbSave(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fwrite(state, sizeof(DUcbState), 1, file) != 1;
+}
+
+static uint8_t dUcbLoad(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fread(state, sizeof(DUcbState), 1, file) != 1;
+}
+
+const Algorithm dUcbAlg = {
+        .name = "ducb",
+        .title = "D-UCB",
+        .color = "dark-green",
+        .pointType = 10,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 1,
+        .armStateSize = sizeof(DUcbArm),
+        .init = dUcbInit,
+        .select = dUcbSelect,
+        .update = dUcbUpdate,
+        .report = dUcbReport,
+        .save = dUcbSave,
+        .load = dUcbLoad,
+        .free = free,
+};
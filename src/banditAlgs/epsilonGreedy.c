@@ -1,115 +1,193 @@
 #include <gsl/gsl_rng.h>
 #include <math.h>
-#include <time.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 #include <banditAlgs.h>
 #include <util.h>
 
-void epsilonGreedy(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold,
-                   double *avgTrades, double *totalOpt, Bandit b) {
-    /**
-     * INFO: The epsilon greedy algorithm in short:
-     *
-     * --------------------------------------------------
-     * for each round t:
-     *   toss coin with success prob of e_t;
-     *   if success then
-     *     explore: pick arm uniformly at random
-     *   else
-     *     exploit: pick arm with highest average reward
-     * --------------------------------------------------
-     *
-     * in this program, arm = threshold
-     *
-     * e_t  = (K * log(t) / t)^(1 / 3)
-     * achieves a good regret bound,
-     * where K is the number of arms/thresholds
-     */
-
-    const gsl_rng_type *T;
+/**
+ * INFO: The epsilon greedy algorithm in short:
+ *
+ * --------------------------------------------------
+ * for each round t:
+ *   toss coin with success prob of e_t;
+ *   if success then
+ *     explore: pick arm uniformly at random
+ *   else
+ *     exploit: pick arm with highest average reward
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * e_t  = (c * K * log(t) / t)^(1 / 3)
+ * achieves a good regret bound,
+ * where K is the number of arms/thresholds
+ * and c is a scale, b.eGreedyScale
+ */
+
+typedef struct epsilonGreedyStateStruct {
     gsl_rng *r;
-    gsl_rng_env_setup();
-    T = gsl_rng_default;
-    r = gsl_rng_alloc(T);
-    gsl_rng_set(r, time(nullptr));
+    uint64_t explore;
+    uint64_t exploit;
+    double exploreProb;
+} EpsilonGreedyState;
 
-    Threshold *thres = malloc(b.K * sizeof(Threshold));
-    initThreshold(thres, b, data);
+static void *epsilonGreedyInit(ArmSpace *arms, Bandit b, double *data) {
+    EpsilonGreedyState *s = malloc(sizeof(EpsilonGreedyState));
 
-    uint64_t explore = 0;
-    uint64_t exploit = 0;
-    totalGain[0] = 0;
-    uint8_t heldItems = 0;
-    double heldItemValue = 0;
-    double exploreProb = 1;
+    // gsl_rng_env_setup() has already been called once by main
+    s->r = gsl_rng_alloc(gsl_rng_default);
+    gsl_rng_set(s->r, b.seed);
 
-    for (uint64_t t = 0; t < b.T; t++) {
-        // exploreProb = cbrt(b.K * log(pow(2.0, ceil(log2((double) t + 1.0)))) / (double) (t + 1));
-        exploreProb = cbrt(b.K * log((double) t + 1) / (double) (t + 1));
-        // exploreProb = cbrt(b.K * log(b.T) / (double) (t + 1));
+    s->explore = 0;
+    s->exploit = 0;
+    s->exploreProb = 1;
 
-        // this will be 0 in the first round, and will always explore
+    return s;
+}
 
-        uint32_t chosenTh;
-        if (gsl_rng_uniform(r) < exploreProb) {
-            chosenTh = gsl_rng_uniform_int(r, b.K);
-            explore++;
+// the arm with the highest average reward
+static uint32_t bestArm(ArmSpace *arms, Bandit b) {
+    uint32_t chosenTh = 0;
+    double max = -INFINITY;
 
-        } else {
-            chosenTh = 0;
-            double max = thres[0].avgReward;
-
-            for (uint32_t th = 0; th < b.K; th++) {
-                if (thres[th].avgReward > max) {
-                    max = thres[th].avgReward;
-                    chosenTh = th;
-                }
-            }
-            exploit++;
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        if (arms->played[slot].avgReward > max) {
+            max = arms->played[slot].avgReward;
+            chosenTh = arms->playedId[slot];
         }
+    }
+
+    // every unplayed arm has an average reward of 0
+    if (arms->playedCount < b.K && max < 0) {
+        chosenTh = firstUnplayedArm(arms);
+    }
+
+    return chosenTh;
+}
+
+static uint32_t epsilonGreedySelect(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    EpsilonGreedyState *s = state;
+
+    // s->exploreProb = cbrt(b.K * log(pow(2.0, ceil(log2((double) round + 1.0)))) / (double) (round + 1));
+    s->exploreProb = cbrt(b.eGreedyScale * b.K * log((double) round + 1) / (double) (round + 1));
+    // s->exploreProb = cbrt(b.K * log(b.T) / (double) (round + 1));
+
+    // this will be 0 in the first round, and will always explore
 
-        runRound(thres, chosenTh, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t, &heldItems,
-                 &heldItemValue);
+    uint32_t chosenTh;
+    if (gsl_rng_uniform(s->r) < s->exploreProb) {
+        chosenTh = gsl_rng_uniform_int(s->r, b.K);
+        s->explore++;
+
+    } else {
+        chosenTh = bestArm(arms, b);
+        s->exploit++;
     }
 
-    if (b.dynamicThres) {
-        for (uint64_t t = 0; t < b.T; t++) {
-            totalGain[t] -= totalGain[0];
+    return chosenTh;
+}
+
+static void epsilonGreedySelectBatch(void *state, ArmSpace *arms, Bandit b, uint64_t round, uint32_t count,
+                                     uint32_t *th) {
+    EpsilonGreedyState *s = state;
+
+    // the averages don't change before the batch is fed back, so the best arm is found once, and each round only
+    // tosses its own coin
+    uint32_t best = bestArm(arms, b);
+    for (uint32_t i = 0; i < count; i++) {
+        s->exploreProb = cbrt(b.eGreedyScale * b.K * log((double) (round + i) + 1) / (double) (round + i + 1));
+        if (gsl_rng_uniform(s->r) < s->exploreProb) {
+            th[i] = gsl_rng_uniform_int(s->r, b.K);
+            s->explore++;
+        } else {
+            th[i] = best;
+            s->exploit++;
         }
     }
+}
 
-    printf("\n");
-    printf("---------------------------------EPSILON-GREEDY----------------------"
-           "-----------\n");
+static void epsilonGreedyReport(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt,
+                                FILE *out) {
+    EpsilonGreedyState *s = state;
+
+    fprintf(out, "\n");
+    fprintf(out, "---------------------------------EPSILON-GREEDY----------------------"
+            "-----------\n");
+    uint32_t *slots = sortPlayedArms(arms);
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].rewardSum, thres[th].timesChosen,
-                   thres[th].avgReward);
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", arm->low, arm->rewardSum, arm->timesChosen,
+                    arm->avgReward);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].high,
-                   thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward);
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", arm->low, arm->high, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward);
         }
     }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
 
-    printf("---------------------------------------------------------------------"
-           "-----------\n");
-    printf("Final Exploration Chance: %lf%%\n", 100 * exploreProb);
-    printf("Explored: %lu\n", explore);
-    printf("Exploited: %lu\n", exploit);
-    printf("Total Gain: %lf\n", totalGain[b.T - 1]);
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
-    printf("Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
-    printf("Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
-    printf("---------------------------------------------------------------------"
-           "-----------\n\n");
-
-    gsl_rng_free(r);
-    free(thres);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "Final Exploration Chance: %lf%%\n", 100 * s->exploreProb);
+    fprintf(out, "Explored: %lu\n", s->explore);
+    fprintf(out, "Exploited: %lu\n", s->exploit);
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
 }
+
+static uint8_t epsilonGreedySave(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    EpsilonGreedyState *s = state;
+    // the generator's pointer is written too, but it is never read back
+    uint8_t error = fwrite(s, sizeof(EpsilonGreedyState), 1, file) != 1;
+    return error || gsl_rng_fwrite(file, s->r) != 0;
+}
+
+static uint8_t epsilonGreedyLoad(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    EpsilonGreedyState *s = state;
+    gsl_rng *r = s->r;
+    uint8_t error = fread(s, sizeof(EpsilonGreedyState), 1, file) != 1;
+    s->r = r;
+    return error || gsl_rng_fread(file, s->r) != 0;
+}
+
+static void epsilonGreedyFree(void *state) {
+    EpsilonGreedyState *s = state;
+    gsl_rng_free(s->r);
+    free(s);
+}
+
+const Algorithm epsilonGreedyAlg = {
+        .name = "eGreedy",
+        .title = "Epsilon-Greedy",
+        .color = "red",
+        .pointType = 2,
+        .singleThres = 0,
+        .stochastic = 1,
+        .online = 1,
+        .init = epsilonGreedyInit,
+        .select = epsilonGreedySelect,
+        .update = nullptr,
+        .selectBatch = epsilonGreedySelectBatch,
+        .report = epsilonGreedyReport,
+        .save = epsilonGreedySave,
+        .load = epsilonGreedyLoad,
+        .free = epsilonGreedyFree,
+};
@@ -1,185 +1,278 @@
 #include <gsl/gsl_rng.h>
 #include <math.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 
 #include <banditAlgs.h>
 #include <util.h>
 
-void exp3(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-          double *totalOpt, Bandit b) {
-    /**
-     * INFO: The exp3 algorithm in short:
-     *
-     * --------------------------------------------------
-     * initialize w_i_1 = 1 for each threshold i
-     * for each round t:
-     *   p_i_t = (1-gamma) * (w_i_t / sum(i, K, w_i_t)) + gamma / K
-     *   draw arm a according to the propabilities p_i_t
-     *   recieve reward x_a_t in [0,1]
-     *   for each arm k:
-     *     x'_k_t = x_k_t / p_k_t   , if k = a
-     *              0               , otherwise
-     *     w_k_(t+1) = w_k_t * exp(gamma * x'_k_t / K)
-     * --------------------------------------------------
-     *
-     * in this program, arm = threshold
-     *
-     * gamma is the exploration chance
-     * K is the number of thresholds
-     *
-     * gamma = min{1, sqrt((K * log(K)) / ((e - 1) * g))}
-     * e = euler's constant
-     * g = the upper bound
-     *
-     * g is equal to the number of rounds, if it is known.
-     * exp3.1 provides a solution in the case where we don't know
-     * the number of rounds, but for now we will use g = t instead.
-     *
-     */
-
-    const gsl_rng_type *T;
-    gsl_rng *r;
-    gsl_rng_env_setup();
-    T = gsl_rng_default;
-    r = gsl_rng_alloc(T);
-    gsl_rng_set(r, time(nullptr));
-
-    Threshold *thres = malloc(b.K * sizeof(Threshold));
-    initThreshold(thres, b, data);
+/**
+ * INFO: The exp3 algorithm in short:
+ *
+ * --------------------------------------------------
+ * initialize w_i_1 = 1 for each threshold i
+ * for each round t:
+ *   p_i_t = (1-gamma) * (w_i_t / sum(i, K, w_i_t)) + gamma / K
+ *   draw arm a according to the propabilities p_i_t
+ *   recieve reward x_a_t in [0,1]
+ *   for each arm k:
+ *     x'_k_t = x_k_t / p_k_t   , if k = a
+ *              0               , otherwise
+ *     w_k_(t+1) = w_k_t * exp(gamma * x'_k_t / K)
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * gamma is the exploration chance
+ * K is the number of thresholds
+ *
+ * gamma = min{1, sqrt((K * log(K)) / ((e - 1) * g))}
+ * e = euler's constant
+ * g = the upper bound
+ *
+ * g is equal to the number of rounds, if it is known,
+ * unless b.exp3UpperBound sets it.
+ * exp3.1 provides a solution in the case where we don't know
+ * the number of rounds, but for now we will use g = t instead.
+ *
+ */
 
-    totalGain[0] = 0;
-    uint8_t heldItems = 0;
-    double heldItemValue = 0;
+typedef struct exp3StateStruct {
+    gsl_rng *r;
+    long double norm;
+    long double weightSum;
+    long double gamma;
+    // the probability of the threshold picked in the current round
+    long double thresholdProb;
+    // with batches, the probability of the threshold picked in each round of the batch starting at batchRound
+    long double *batchProb;
+    uint64_t batchRound;
+    uint64_t batchCount;
+} Exp3State;
 
+typedef struct exp3ArmStruct {
     // threshold weights must be long double to prevent errors with very large
     // datasets probably doesn't work on windows but oh well
-    long double *thresholdWeight = malloc(b.K * sizeof(long double));
-    for (uint32_t th = 0; th < b.K; th++) {
-        thresholdWeight[th] = 1;
-    }
+    // the weight of an unplayed arm is 1, it is only stored once the arm is played
+    long double weight;
+} Exp3Arm;
 
-    // long double *estimTotalGain = malloc(b.K * sizeof(long double));
-    // long double maxEstim = 0;
-    // for (uint32_t th = 0; th < b.K; th++) {
-    //     estimTotalGain[th] = 0;
-    // }
+static void *exp3Init(ArmSpace *arms, Bandit b, double *data) {
+    Exp3State *s = malloc(sizeof(Exp3State));
 
-    long double norm = 1;
+    // gsl_rng_env_setup() has already been called once by main
+    s->r = gsl_rng_alloc(gsl_rng_default);
+    gsl_rng_set(s->r, b.seed);
 
-    long double weightSum = 0;
-    long double gamma = 1;
-    // int rho = 0;
-    for (uint64_t t = 0; t < b.T; t++) {
-        // upper bound is variable for easier future changes
+    s->norm = 1;
+    s->weightSum = 0;
+    s->gamma = 1;
+    s->thresholdProb = 0;
+    s->batchProb = b.batch > 1 ? malloc(b.batch * sizeof(long double)) : nullptr;
+    s->batchRound = 0;
+    s->batchCount = 0;
 
-        double upperBound = (double) b.T;
-        // double upperBound = (b.K * log(b.K) / (M_E - 1)) * pow(4, rho);
-        // double upperBound = pow(2.0, ceil(log2((double) t + 1.0)));
-        // double upperBound = t + 1;
+    return s;
+}
 
-        gamma = sqrt(b.K * log(b.K) / ((M_E - 1) * upperBound));
-        gamma = fminl(gamma, 1);
+// sets gamma and the sum of the weights, which the probabilities of the arms are calculated from
+static void startDraws(Exp3State *s, ArmSpace *arms, Bandit b) {
 
-        // if (maxEstim > upperBound - b.K / gamma) {
-        // rho++;
-        // gamma /= 2;
-        // }
+    // upper bound is variable for easier future changes
 
-        weightSum = 0;
-        for (uint32_t th = 0; th < b.K; th++) {
-            weightSum += thresholdWeight[th];
-        }
+    double upperBound = b.exp3UpperBound ? b.exp3UpperBound : (double) b.T;
+    // double upperBound = pow(2.0, ceil(log2((double) round + 1.0)));
+    // double upperBound = round + 1;
 
-        // pick threshold according to probabilities (no need to calculate them all)
-        // initialize chosenTh as the last threshold incase something goes wrong
-        uint32_t chosenTh = b.K - 1;
-        long double randomNumber = gsl_rng_uniform(r);
-        long double thresholdProb = 0;
-        for (uint32_t th = 0; th < b.K; th++) {
-            thresholdProb = (1 - gamma) * (thresholdWeight[th] / weightSum) + gamma / b.K;
-            if (randomNumber < thresholdProb) {
-                chosenTh = th;
-                break;
-            }
-            randomNumber -= thresholdProb;
-        }
+    s->gamma = sqrt(b.K * log(b.K) / ((M_E - 1) * upperBound));
+    s->gamma = fminl(s->gamma, 1);
 
-        // weight only changes for the chosen threshold
-        long double gain = runRound(thres, chosenTh, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain,
-                                    t, &heldItems, &heldItemValue);
+    // every unplayed arm has a weight of 1
+    uint32_t unplayed = b.K - arms->playedCount;
+    s->weightSum = unplayed;
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        Exp3Arm *a = getArmState(arms, slot);
+        s->weightSum += a->weight;
+    }
+}
 
-        long double estimatedReward = fmaxl(gain, 0) / (norm * thresholdProb);
-        thresholdWeight[chosenTh] *= expl(gamma * estimatedReward / b.K);
+// picks a threshold with the gamma and the weight sum of startDraws and keeps its probability in thresholdProb
+static uint32_t drawArm(Exp3State *s, ArmSpace *arms, Bandit b) {
+    uint32_t unplayed = b.K - arms->playedCount;
 
-        if (t > 0) {
-            if (norm < gain) {
-                long double oldMaxOpt = norm;
-                norm = gain;
-                for (uint32_t th = 0; th < b.K; th++) {
-                    thresholdWeight[th] = powl(thresholdWeight[th], oldMaxOpt / norm);
-                }
-            }
+    // pick threshold according to probabilities (no need to calculate them all)
+    // the played arms are tried first, whatever probability is left belongs to the unplayed arms
+    long double randomNumber = gsl_rng_uniform(s->r);
+    s->thresholdProb = 0;
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        Exp3Arm *a = getArmState(arms, slot);
+        s->thresholdProb = (1 - s->gamma) * (a->weight / s->weightSum) + s->gamma / b.K;
+        if (randomNumber < s->thresholdProb) {
+            return arms->playedId[slot];
         }
+        randomNumber -= s->thresholdProb;
+    }
+
+    // fall back to the last played threshold incase something goes wrong
+    if (!unplayed) {
+        return arms->playedId[arms->playedCount - 1];
+    }
 
-        // maxEstim = totalOpt[t];
+    // the unplayed arms are equally likely, so pick one uniformly. The draws that hit a played arm are retried, which
+    // takes K / unplayed draws on average, but this is only reached with probability about unplayed / K
+    uint32_t chosenTh;
+    do {
+        chosenTh = gsl_rng_uniform_int(s->r, b.K);
+    } while (armSlot(arms, chosenTh) != ARM_UNPLAYED);
+    s->thresholdProb = (1 - s->gamma) * (1 / s->weightSum) + s->gamma / b.K;
+
+    return chosenTh;
+}
+
+static uint32_t exp3Select(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    Exp3State *s = state;
+    s->batchCount = 0;
+    startDraws(s, arms, b);
+    return drawArm(s, arms, b);
+}
 
-        // estimTotalGain[chosenTh] += estimatedReward;
-        // if (maxEstim < estimTotalGain[chosenTh]) {
-        // maxEstim = estimTotalGain[chosenTh];
-        // }
+static void exp3SelectBatch(void *state, ArmSpace *arms, Bandit b, uint64_t round, uint32_t count, uint32_t *th) {
+    Exp3State *s = state;
+
+    // every round of the batch is drawn from the same weights, so the sum is only calculated once
+    startDraws(s, arms, b);
+    for (uint32_t i = 0; i < count; i++) {
+        th[i] = drawArm(s, arms, b);
+        s->batchProb[i] = s->thresholdProb;
+    }
+    s->batchRound = round;
+    s->batchCount = count;
+}
+
+static void exp3Update(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    Exp3State *s = state;
+
+    uint32_t slot = armSlot(arms, th);
+    Exp3Arm *chosen = getArmState(arms, slot);
+    if (arms->played[slot].timesChosen == 1) {
+        chosen->weight = 1;
     }
 
-    if (b.dynamicThres) {
-        for (uint64_t t = 0; t < b.T; t++) {
-            totalGain[t] -= totalGain[0];
+    // weight only changes for the chosen threshold
+    // a round of a batch was drawn with the probabilities of the batch's start
+    long double thresholdProb = s->thresholdProb;
+    if (round >= s->batchRound && round - s->batchRound < s->batchCount) {
+        thresholdProb = s->batchProb[round - s->batchRound];
+    }
+    long double estimatedReward = fmaxl(gain, 0) / (s->norm * thresholdProb);
+    chosen->weight *= expl(s->gamma * estimatedReward / b.K);
+
+    if (round > 0) {
+        if (s->norm < gain) {
+            long double oldMaxOpt = s->norm;
+            s->norm = gain;
+            // a weight of 1 stays 1, so the unplayed arms don't change
+            for (uint32_t i = 0; i < arms->playedCount; i++) {
+                Exp3Arm *a = getArmState(arms, i);
+                a->weight = powl(a->weight, oldMaxOpt / s->norm);
+            }
         }
     }
+}
 
+static void exp3Report(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    Exp3State *s = state;
 
-    printf("\n");
-    // printf("%d\n", rho);
-    printf("---------------------------------------------EXP3--------------------"
-           "-----------------------\n");
+    fprintf(out, "\n");
+    fprintf(out, "---------------------------------------------EXP3--------------------"
+            "-----------------------\n");
+    uint32_t *slots = sortPlayedArms(arms);
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage "
-               "Reward\tFinal Weight\tProbability\n");
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage "
+                "Reward\tFinal Weight\tProbability\n");
 
-        for (int32_t th = 0; th < b.K; th++) {
-            long double thresholdProb = (1 - gamma) * (thresholdWeight[th] / weightSum) + gamma / b.K;
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            Exp3Arm *a = getArmState(arms, slots[i]);
+            long double thresholdProb = (1 - s->gamma) * (a->weight / s->weightSum) + s->gamma / b.K;
 
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-6LE\t%-.6Lf%%\n", thres[th].low, thres[th].rewardSum,
-                   thres[th].timesChosen, thres[th].avgReward, thresholdWeight[th], 100 * thresholdProb);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-6LE\t%-.6Lf%%\n", arm->low, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward, a->weight, 100 * thresholdProb);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage "
-               "Reward\tFinal Weight\tProbability\n");
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage "
+                "Reward\tFinal Weight\tProbability\n");
 
-        for (int32_t th = 0; th < b.K; th++) {
-            long double thresholdProb = (1 - gamma) * (thresholdWeight[th] / weightSum) + gamma / b.K;
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            Exp3Arm *a = getArmState(arms, slots[i]);
+            long double thresholdProb = (1 - s->gamma) * (a->weight / s->weightSum) + s->gamma / b.K;
 
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-6LE\t%-.6Lf%%\n", thres[th].low, thres[th].high,
-                   thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward, thresholdWeight[th],
-                   100 * thresholdProb);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-6LE\t%-.6Lf%%\n", arm->low, arm->high,
+                    arm->rewardSum, arm->timesChosen, arm->avgReward, a->weight, 100 * thresholdProb);
         }
     }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
+
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------------------\n");
+    fprintf(out, "Final Gamma (Exploration Chance): %Lf%%\n", 100 * s->gamma);
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------------------\n\n");
+}
+
+static uint8_t exp3Save(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    Exp3State *s = state;
+    // the generator's pointer is written too, but it is never read back
+    uint8_t error = fwrite(s, sizeof(Exp3State), 1, file) != 1;
+    return error || gsl_rng_fwrite(file, s->r) != 0;
+}
+
+static uint8_t exp3Load(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    Exp3State *s = state;
+    gsl_rng *r = s->r;
+    long double *batchProb = s->batchProb;
+    uint8_t error = fread(s, sizeof(Exp3State), 1, file) != 1;
+    s->r = r;
+    // checkpoints are only taken between batches
+    s->batchProb = batchProb;
+    s->batchCount = 0;
+    return error || gsl_rng_fread(file, s->r) != 0;
+}
 
-    printf("---------------------------------------------------------------------"
-           "-----------------------\n");
-    printf("Final Gamma (Exploration Chance): %Lf%%\n", 100 * gamma);
-    printf("Total Gain: %lf\n", totalGain[b.T - 1]);
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
-    printf("Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
-    printf("Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
-    printf("---------------------------------------------------------------------"
-           "-----------------------\n\n");
-
-    gsl_rng_free(r);
-    free(thresholdWeight);
-    // free(estimTotalGain);
-    free(thres);
+static void exp3Free(void *state) {
+    Exp3State *s = state;
+    gsl_rng_free(s->r);
+    free(s->batchProb);
+    free(s);
 }
+
+const Algorithm exp3Alg = {
+        .name = "exp3",
+        .title = "EXP3",
+        .color = "green",
+        .pointType = 6,
+        .singleThres = 0,
+        .stochastic = 1,
+        .online = 1,
+        .armStateSize = sizeof(Exp3Arm),
+        .init = exp3Init,
+        .select = exp3Select,
+        .update = exp3Update,
+        .selectBatch = exp3SelectBatch,
+        .report = exp3Report,
+        .save = exp3Save,
+        .load = exp3Load,
+        .free = exp3Free,
+};
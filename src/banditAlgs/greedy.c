@@ -6,79 +6,111 @@
 #include <banditAlgs.h>
 #include <util.h>
 
-void greedy(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades, double *totalOpt, Bandit b) {
-    /**
-     * INFO: The greedy algorithm in short:
-     *
-     * --------------------------------------------------
-     * try each arm once
-     * for each round t
-     *   pick the arm with the highest average reward
-     * --------------------------------------------------
-     *
-     * in this program, arm = threshold
-     *
-     */
+/**
+ * INFO: The greedy algorithm in short:
+ *
+ * --------------------------------------------------
+ * try each arm once
+ * for each round t
+ *   pick the arm with the highest average reward
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ */
 
-    Threshold *thres = malloc(b.K * sizeof(Threshold));
-    initThreshold(thres, b, data);
+typedef struct greedyStateStruct {
+    uint32_t chosenTh;
+} GreedyState;
 
-    uint32_t chosenTh = 0;
-    totalGain[0] = 0;
-    uint8_t heldItems = 0;
-    double heldItemValue = 0;
+static void *greedyInit(ArmSpace *arms, Bandit b, double *data) {
+    GreedyState *s = malloc(sizeof(GreedyState));
+    s->chosenTh = 0;
+    return s;
+}
 
-    for (uint32_t t = 0; t < b.K; t++) {
-        runRound(thres, t, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t, &heldItems, &heldItemValue);
-    }
-    double max = -INFINITY;
-    chosenTh = 0;
+static uint32_t greedySelect(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    GreedyState *s = state;
 
-    for (uint32_t th = 0; th < b.K; th++) {
-        if (thres[th].avgReward > max) {
-            max = thres[th].avgReward;
-            chosenTh = th;
-        }
+    if (round < b.K) {
+        return round;
     }
 
-    for (uint64_t t = b.K; t < b.T; t++) {
-        runRound(thres, chosenTh, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t, &heldItems, &heldItemValue);
-    }
+    // every arm has been tried once, the choice is final
+    if (round == b.K) {
+        double max = -INFINITY;
+        s->chosenTh = 0;
 
-    if (b.dynamicThres) {
-        for (uint64_t t = 0; t < b.T; t++) {
-            totalGain[t] -= totalGain[0];
+        for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+            if (arms->played[slot].avgReward > max) {
+                max = arms->played[slot].avgReward;
+                s->chosenTh = arms->playedId[slot];
+            }
         }
     }
 
-    printf("\n");
-    printf("-------------------------------------Greedy--------------------------"
-           "-----------\n");
+    return s->chosenTh;
+}
+
+static void greedyReport(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    fprintf(out, "\n");
+    fprintf(out, "-------------------------------------Greedy--------------------------"
+            "-----------\n");
+    uint32_t *slots = sortPlayedArms(arms);
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].rewardSum, thres[th].timesChosen,
-                   thres[th].avgReward);
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", arm->low, arm->rewardSum, arm->timesChosen,
+                    arm->avgReward);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].high,
-                   thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward);
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", arm->low, arm->high, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward);
         }
     }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
 
-    printf("---------------------------------------------------------------------"
-           "-----------\n");
-    printf("Total Gain: %lf\n", totalGain[b.T - 1]);
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
-    printf("Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
-    printf("Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
-    printf("---------------------------------------------------------------------"
-           "-----------\n\n");
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
+}
 
-    free(thres);
+static uint8_t greedySave(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fwrite(state, sizeof(GreedyState), 1, file) != 1;
 }
+
+static uint8_t greedyLoad(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fread(state, sizeof(GreedyState), 1, file) != 1;
+}
+
+const Algorithm greedyAlg = {
+        .name = "greedy",
+        .title = "Greedy",
+        .color = "orange",
+        .pointType = 1,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 1,
+        .init = greedyInit,
+        .select = greedySelect,
+        .update = nullptr,
+        .report = greedyReport,
+        .save = greedySave,
+        .load = greedyLoad,
+        .free = free,
+};
@@ -0,0 +1,330 @@
+#include <gsl/gsl_statistics_double.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <banditAlgs.h>
+#include <util.h>
+
+/**
+ * INFO: The HOO (hierarchical optimistic optimization) algorithm in short:
+ *
+ * --------------------------------------------------
+ * the tree starts with the root, which covers the whole arm space
+ * for each round t:
+ *   starting from the root, follow the child with the highest B value
+ *   until reaching a child that isn't in the tree yet
+ *   add that child to the tree and play the center of its cell
+ *   update the statistics of every node on the path
+ *   recalculate the B values of the path from the bottom up
+ * --------------------------------------------------
+ *
+ * in this program, the arm is any threshold in [0,1], or with two thresholds any (low, high) pair with low <= high,
+ * instead of one of the K fixed thresholds
+ *
+ * B_h_i = min(U_h_i, max(B_(h+1)_(2i), B_(h+1)_(2i+1)))
+ * U_h_i = m_h_i + sqrt(2 * log(t) / n_h_i) + v * p^h
+ * m_h_i = average reward of the node
+ * n_h_i = number of rounds the path went through the node
+ * v * p^h = the size of a cell of depth h, with v = 1 and p = 2^(-1 / dimensions)
+ * B of a node that isn't in the tree = infinity
+ *
+ * nodes are split in half, alternating between the dimensions. With two thresholds the unit square (x, y) is mapped
+ * on the triangle of pairs with low = x, high = x + y * (1 - x)
+ *
+ * only the B values of the path are recalculated each round, so every round costs O(depth) instead of O(K). The
+ * depth is capped at dimensions * log2(T), where the cells are already finer than any grid we could afford
+ */
+
+typedef struct hooNodeStruct {
+    // the cell of the node in the unit square, the second dimension is unused with one threshold
+    double min[2];
+    double max[2];
+    uint64_t timesChosen;
+    double rewardSum;
+    double bValue;
+    // index of each child in the node array, 0 if it isn't in the tree yet
+    uint32_t child[2];
+    uint32_t depth;
+} HooNode;
+
+typedef struct hooStateStruct {
+    HooNode *nodes;
+    uint32_t nodeCount;
+    uint32_t nodeCapacity;
+    uint32_t dimensions;
+    uint32_t maxDepth;
+    // v * p^h for every depth
+    double *cellSize;
+    // the nodes from the root to the one played this round
+    uint32_t *path;
+    uint32_t pathLength;
+    // quantiles of the first round that the thresholds are mapped on, nullptr unless the thresholds are dynamic
+    double *sortedFirstRound;
+    double norm;
+} HooState;
+
+static uint32_t addNode(HooState *s, uint32_t parent, uint32_t side) {
+    if (s->nodeCount == s->nodeCapacity) {
+        s->nodeCapacity *= 2;
+        s->nodes = realloc(s->nodes, s->nodeCapacity * sizeof(HooNode));
+    }
+
+    uint32_t index = s->nodeCount++;
+    HooNode *node = &s->nodes[index];
+    HooNode *p = &s->nodes[parent];
+    uint32_t dim = p->depth % s->dimensions;
+    double middle = (p->min[dim] + p->max[dim]) / 2;
+
+    *node = (HooNode) {{p->min[0], p->min[1]}, {p->max[0], p->max[1]}, 0, 0, INFINITY, {0, 0}, p->depth + 1};
+    if (side == 0) {
+        node->max[dim] = middle;
+    } else {
+        node->min[dim] = middle;
+    }
+    p->child[side] = index;
+
+    return index;
+}
+
+static double upperBound(HooState *s, HooNode *node, uint64_t round) {
+    double average = fmax(node->rewardSum / (double) node->timesChosen / s->norm, 0);
+    double confRadius = sqrt(2 * log((double) round + 1) / (double) node->timesChosen);
+    return average + confRadius + s->cellSize[node->depth];
+}
+
+static double childrenBValue(HooState *s, HooNode *node) {
+    if (node->depth == s->maxDepth) {
+        return INFINITY;
+    }
+
+    double max = -INFINITY;
+    for (uint32_t side = 0; side < 2; side++) {
+        if (!node->child[side]) {
+            return INFINITY;
+        }
+        max = fmax(max, s->nodes[node->child[side]].bValue);
+    }
+
+    return max;
+}
+
+static double mapThreshold(HooState *s, ArmSpace *arms, Bandit b, double x) {
+    // rolling thresholds are mapped on the quantiles of the window the engine moves every round
+    if (arms->window) {
+        return getOrderStatsQuantile(&arms->window->prices, x);
+    } else if (!s->sortedFirstRound) {
+        return x;
+    }
+    return gsl_stats_quantile_from_sorted_data(s->sortedFirstRound, 1, b.N, x);
+}
+
+static void *hooInit(ArmSpace *arms, Bandit b, double *data) {
+    HooState *s = malloc(sizeof(HooState));
+
+    s->dimensions = b.dualThres ? 2 : 1;
+    s->maxDepth = s->dimensions * (uint32_t) ceil(log2((double) b.T + 1));
+
+    s->cellSize = malloc((s->maxDepth + 1) * sizeof(double));
+    for (uint32_t h = 0; h <= s->maxDepth; h++) {
+        s->cellSize[h] = pow(2.0, -(double) h / s->dimensions);
+    }
+
+    s->nodeCapacity = 1024;
+    s->nodes = malloc(s->nodeCapacity * sizeof(HooNode));
+    s->nodes[0] = (HooNode) {{0, 0}, {1, 1}, 0, 0, INFINITY, {0, 0}, 0};
+    s->nodeCount = 1;
+
+    s->path = malloc((s->maxDepth + 1) * sizeof(uint32_t));
+    s->pathLength = 0;
+
+    s->sortedFirstRound = nullptr;
+    if (b.dynamicThres) {
+        s->sortedFirstRound = malloc(b.N * sizeof(double));
+        if (b.sortedFirstRound) {
+            memcpy(s->sortedFirstRound, b.sortedFirstRound, b.N * sizeof(double));
+        } else {
+            sortFirstRound(b, data, s->sortedFirstRound);
+        }
+    }
+
+    s->norm = -INFINITY;
+
+    return s;
+}
+
+static uint32_t hooSelect(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    HooState *s = state;
+
+    uint32_t index = 0;
+    s->pathLength = 0;
+    s->path[s->pathLength++] = index;
+
+    while (s->nodes[index].depth < s->maxDepth) {
+        HooNode *node = &s->nodes[index];
+        double max = -INFINITY;
+        uint32_t chosenSide = 0;
+
+        for (uint32_t side = 0; side < 2; side++) {
+            if (!node->child[side]) {
+                chosenSide = side;
+                break;
+            }
+
+            HooNode *child = &s->nodes[node->child[side]];
+            double bValue = fmin(upperBound(s, child, round), childrenBValue(s, child));
+            if (bValue > max) {
+                max = bValue;
+                chosenSide = side;
+            }
+        }
+
+        if (!node->child[chosenSide]) {
+            index = addNode(s, index, chosenSide);
+            s->path[s->pathLength++] = index;
+            break;
+        }
+
+        index = node->child[chosenSide];
+        s->path[s->pathLength++] = index;
+    }
+
+    // the engine plays the first arm, so its thresholds are overwritten with the center of the chosen cell
+    HooNode *node = &s->nodes[index];
+    uint32_t slot = playArm(arms, 0);
+    Threshold *arm = &arms->played[slot];
+    double x = (node->min[0] + node->max[0]) / 2;
+    if (!b.dualThres) {
+        arm->low = mapThreshold(s, arms, b, x);
+        arm->high = arm->low;
+    } else {
+        double y = (node->min[1] + node->max[1]) / 2;
+        arm->low = mapThreshold(s, arms, b, x);
+        arm->high = mapThreshold(s, arms, b, x + y * (1 - x));
+    }
+
+    return 0;
+}
+
+static void hooUpdate(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    HooState *s = state;
+
+    if (s->norm < gain) {
+        s->norm = gain;
+    }
+
+    for (uint32_t i = 0; i < s->pathLength; i++) {
+        HooNode *node = &s->nodes[s->path[i]];
+        node->timesChosen++;
+        node->rewardSum += gain;
+    }
+
+    // the children are updated before their parent
+    for (uint32_t i = s->pathLength; i-- > 0;) {
+        HooNode *node = &s->nodes[s->path[i]];
+        node->bValue = fmin(upperBound(s, node, round), childrenBValue(s, node));
+    }
+}
+
+static void hooReport(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    HooState *s = state;
+
+    // the most played path ends in the region the algorithm settled on
+    HooNode *node = &s->nodes[0];
+    while (node->child[0] || node->child[1]) {
+        HooNode *left = node->child[0] ? &s->nodes[node->child[0]] : nullptr;
+        HooNode *right = node->child[1] ? &s->nodes[node->child[1]] : nullptr;
+        if (!right || (left && left->timesChosen >= right->timesChosen)) {
+            node = left;
+        } else {
+            node = right;
+        }
+    }
+
+    uint32_t deepest = 0;
+    for (uint32_t i = 0; i < s->nodeCount; i++) {
+        if (s->nodes[i].depth > deepest) {
+            deepest = s->nodes[i].depth;
+        }
+    }
+
+    double x = (node->min[0] + node->max[0]) / 2;
+    double y = (node->min[1] + node->max[1]) / 2;
+
+    fprintf(out, "\n");
+    fprintf(out, "--------------------------------------HOO----------------------------"
+            "-----------\n");
+    fprintf(out, "Tree Nodes: %u\n", s->nodeCount);
+    fprintf(out, "Deepest Node: %u (max %u)\n", deepest, s->maxDepth);
+    if (!b.dualThres) {
+        fprintf(out, "Most Played Threshold: %lf\n", mapThreshold(s, arms, b, x));
+    } else {
+        fprintf(out, "Most Played Low Thres: %lf\n", mapThreshold(s, arms, b, x));
+        fprintf(out, "Most Played High Thres: %lf\n", mapThreshold(s, arms, b, x + y * (1 - x)));
+    }
+    fprintf(out, "Times Chosen: %lu\n", node->timesChosen);
+    fprintf(out, "Average Reward: %lf\n", node->rewardSum / (double) node->timesChosen);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
+}
+
+static uint8_t hooSave(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    HooState *s = state;
+    uint8_t error = fwrite(&s->nodeCount, sizeof(uint32_t), 1, file) != 1;
+    error |= fwrite(&s->norm, sizeof(double), 1, file) != 1;
+    error |= fwrite(s->nodes, sizeof(HooNode), s->nodeCount, file) != s->nodeCount;
+    return error;
+}
+
+static uint8_t hooLoad(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    HooState *s = state;
+    if (fread(&s->nodeCount, sizeof(uint32_t), 1, file) != 1 || !s->nodeCount) {
+        return 1;
+    }
+
+    // if rounds have been appended to the data the tree can now grow deeper, the nodes stay valid
+    while (s->nodeCapacity < s->nodeCount) {
+        s->nodeCapacity *= 2;
+    }
+    s->nodes = realloc(s->nodes, s->nodeCapacity * sizeof(HooNode));
+    uint8_t error = fread(&s->norm, sizeof(double), 1, file) != 1;
+    error |= fread(s->nodes, sizeof(HooNode), s->nodeCount, file) != s->nodeCount;
+    return error;
+}
+
+static void hooFree(void *state) {
+    HooState *s = state;
+    free(s->nodes);
+    free(s->cellSize);
+    free(s->path);
+    free(s->sortedFirstRound);
+    free(s);
+}
+
+const Algorithm hooAlg = {
+        .name = "hoo",
+        .title = "HOO",
+        .color = "brown",
+        .pointType = 7,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 0,
+        .init = hooInit,
+        .select = hooSelect,
+        .update = hooUpdate,
+        .report = hooReport,
+        .save = hooSave,
+        .load = hooLoad,
+        .free = hooFree,
+};
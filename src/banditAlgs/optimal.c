@@ -1,11 +1,14 @@
 #include <banditAlgs.h>
 #include <math.h>
+#include <memoryPolicy.h>
+#include <orderStats.h>
+#include <reporter.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <util.h>
 
-void findOpt(double *data, double *totalOpt, double *avgTrades, Bandit b) {
+void findOpt(double *data, double *totalOpt, double *avgTrades, Bandit b, Reporter *reporter) {
     uint8_t rightAsc;
     uint8_t leftAsc;
 
@@ -60,24 +63,39 @@ void findOpt(double *data, double *totalOpt, double *avgTrades, Bandit b) {
         avgTrades[t] = avgTrades[t] / (double) (t + 1);
     }
 
-    printf("\n");
-    printf("---------------------------------LOCAL-EXTREMA-----------------------"
-           "-----------\n");
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("---------------------------------------------------------------------"
-           "-----------\n\n");
+    reportf(reporter, "\n"
+                      "---------------------------------LOCAL-EXTREMA-----------------------"
+                      "-----------\n"
+                      "Total OPT: %lf\n"
+                      "Average OPT: %lf\n"
+                      "---------------------------------------------------------------------"
+                      "-----------\n\n",
+            totalOpt[b.T - 1], totalOpt[b.T - 1] / (double) b.T);
 }
 
 void bestHand(double *data, double *totalOpt, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-              Bandit b) {
+              Bandit b, Reporter *reporter) {
     Threshold *thres = malloc(b.K * sizeof(Threshold));
     initThreshold(thres, b, data);
 
+    // rolling dynamic thresholds are moved with the rounds, like the ones of the algorithms
+    ThresholdWindow window;
+    double *threshold = nullptr;
+    uint8_t rolling = b.dynamicThres && b.rollingRounds && !initThresholdWindow(&window, b);
+    if (rolling)
+        threshold = malloc(b.thresholds * sizeof(double));
+
     double *totalGain = malloc(b.T * sizeof(double));
     double *buffer = malloc(b.T * sizeof(double));
 
     for (uint64_t t = 0; t < b.T; t++) {
+        if (t + 1 < b.T)
+            prefetchRound(&b.memory, data, b.N, t + 1);
+        if (rolling && moveThresholdWindow(&window, b, data, t)) {
+            getWindowThresholds(&window, b, threshold);
+            seedThresholds(thres, b, threshold);
+        }
+
         double maxGain = -INFINITY;
         uint32_t chosenTh = 0;
         double gain = 0;
@@ -94,35 +112,52 @@ void bestHand(double *data, double *totalOpt, double *avgLowThreshold, double *a
             }
         }
 
-        runRound(thres, chosenTh, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalOpt, t, &heldItems, &heldItemValue);
+        runRound(&thres[chosenTh], b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalOpt, t, &heldItems,
+                 &heldItemValue);
     }
 
     free(totalGain);
     free(buffer);
+    if (rolling) {
+        freeThresholdWindow(&window);
+        free(threshold);
+    }
+
+    if (!reporter) {
+        free(thres);
+        return;
+    }
 
-    printf("\n");
-    printf("-----------------------------------BEST-HAND-------------------------"
-           "-----------\n");
+    // the table is printed to a stream, which is handed to the reporter as a whole
+    char *text;
+    size_t size;
+    FILE *out = open_memstream(&text, &size);
+    fprintf(out, "\n");
+    fprintf(out, "-----------------------------------BEST-HAND-------------------------"
+            "-----------\n");
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\n");
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\n");
         for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].rewardSum, thres[th].timesChosen,
-                   thres[th].avgReward);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].rewardSum,
+                    thres[th].timesChosen, thres[th].avgReward);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\n");
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\n");
         for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].high,
-                   thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-.6lf\n", thres[th].low, thres[th].high,
+                    thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward);
         }
     }
 
-    printf("---------------------------------------------------------------------"
-           "-----------\n");
-    printf("OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("---------------------------------------------------------------------"
-           "-----------\n\n");
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
+    fclose(out);
+    reporter->write(reporter->context, text);
 
+    free(text);
     free(thres);
 }
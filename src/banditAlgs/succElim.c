@@ -6,119 +6,205 @@
 #include <banditAlgs.h>
 #include <util.h>
 
-void succElim(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-              double *totalOpt, Bandit b) {
-    /**
-     * INFO: The Successive Elimination algorithm in short:
-     *
-     * --------------------------------------------------
-     * initialize all arms as active
-     * loop:
-     *   try each arm once
-     *   deactivate all arms that satisfy: UCB_t_a < max(LCB_t_a)
-     * --------------------------------------------------
-     *
-     * in this program, arm = threshold
-     *
-     * UCB_t_a  = m_t_a + r_t_a
-     * LCB_t_a  = m_t_a - r_t_a
-     * m_t_a = average reward of arm a in round t
-     * r_t_a = sqrt(2 * log(t) / n_t_a)
-     * n_t_a = number of rounds before t where arm a was chosen
-     */
-
-    Threshold *thres = malloc(b.K * sizeof(Threshold));
-    initThreshold(thres, b, data);
-
-    totalGain[0] = 0;
-    uint8_t heldItems = 0;
-    double heldItemValue = 0;
-
-    double *upperConfBound = malloc(b.K * sizeof(double));
-    double *lowerConfBound = malloc(b.K * sizeof(double));
-    uint8_t *thresActive = malloc(b.K * sizeof(uint8_t));
-
-    for (uint32_t th = 0; th < b.K; th++) {
-        thresActive[th] = 1;
+/**
+ * INFO: The Successive Elimination algorithm in short:
+ *
+ * --------------------------------------------------
+ * initialize all arms as active
+ * loop:
+ *   try each arm once
+ *   deactivate all arms that satisfy: UCB_t_a < max(LCB_t_a)
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * UCB_t_a  = m_t_a + r_t_a
+ * LCB_t_a  = m_t_a - r_t_a
+ * m_t_a = average reward of arm a in round t
+ * r_t_a = sqrt(2 * log(t) / n_t_a)
+ * n_t_a = number of rounds before t where arm a was chosen
+ */
+
+typedef struct succElimStateStruct {
+    // the next arm to try in the current sweep over the active arms
+    uint32_t nextTh;
+    double norm;
+} SuccElimState;
+
+typedef struct succElimArmStruct {
+    double upperConfBound;
+    double lowerConfBound;
+    // unplayed arms are all active, so the default state has to be 0
+    uint8_t eliminated;
+} SuccElimArm;
+
+static uint8_t isActive(ArmSpace *arms, uint32_t th) {
+    uint32_t slot = armSlot(arms, th);
+    if (slot == ARM_UNPLAYED) {
+        return 1;
     }
+    SuccElimArm *a = getArmState(arms, slot);
+    return !a->eliminated;
+}
 
-    double norm = -INFINITY;
-
-    uint64_t t = 0;
-    while (t < b.T) {
-        for (uint32_t th = 0; th < b.K && t < b.T; th++) {
-            if (thresActive[th]) {
-                double gain = runRound(thres, th, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t,
-                                       &heldItems, &heldItemValue);
-                if (norm < gain) {
-                    norm = gain;
-                }
-                t++;
-            }
-        }
+// the first active arm from th on, K if there is none
+static uint32_t nextActive(ArmSpace *arms, Bandit b, uint32_t th) {
+    while (th < b.K && !isActive(arms, th)) {
+        th++;
+    }
+    return th;
+}
+
+static void *succElimInit(ArmSpace *arms, Bandit b, double *data) {
+    SuccElimState *s = malloc(sizeof(SuccElimState));
+
+    s->nextTh = 0;
+    s->norm = -INFINITY;
+
+    return s;
+}
 
-        double maxLCB = -INFINITY;
-        for (uint32_t th = 0; th < b.K; th++) {
-            if (thresActive[th]) {
-                double average = fmax(thres[th].avgReward / norm, 0);
-                double confRadius = sqrt(2 * log((double) b.T) / (double) thres[th].timesChosen);
+static void eliminate(SuccElimState *s, ArmSpace *arms, Bandit b) {
+    // an unplayed arm has an infinite upper bound and never gets eliminated, so only the played ones are checked
+    double maxLCB = -INFINITY;
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        SuccElimArm *a = getArmState(arms, slot);
+        if (!a->eliminated) {
+            double average = fmax(arms->played[slot].avgReward / s->norm, 0);
+            double confRadius = sqrt(2 * log((double) b.T) / (double) arms->played[slot].timesChosen);
 
-                upperConfBound[th] = average + confRadius;
-                lowerConfBound[th] = average - confRadius;
+            a->upperConfBound = average + confRadius;
+            a->lowerConfBound = average - confRadius;
 
-                if (lowerConfBound[th] > maxLCB) {
-                    maxLCB = lowerConfBound[th];
-                }
+            if (a->lowerConfBound > maxLCB) {
+                maxLCB = a->lowerConfBound;
             }
         }
+    }
 
-        for (uint32_t th = 0; th < b.K; th++) {
-            if (upperConfBound[th] < maxLCB) {
-                thresActive[th] = 0;
-            }
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        SuccElimArm *a = getArmState(arms, slot);
+        if (a->upperConfBound < maxLCB) {
+            a->eliminated = 1;
         }
     }
+}
+
+static uint32_t succElimSelect(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    SuccElimState *s = state;
+
+    s->nextTh = nextActive(arms, b, s->nextTh);
+
+    // no arm is left active, which only happens if the bounds are NaN
+    if (s->nextTh == b.K) {
+        s->nextTh = 0;
+    }
 
-    if (b.dynamicThres) {
-        for (uint64_t t = 0; t < b.T; t++) {
-            totalGain[t] -= totalGain[0];
+    return s->nextTh;
+}
+
+static void succElimSelectBatch(void *state, ArmSpace *arms, Bandit b, uint64_t round, uint32_t count, uint32_t *th) {
+    SuccElimState *s = state;
+
+    // the batch carries on with the sweep, and starts the next one over the same active arms when it is over
+    uint32_t next = nextActive(arms, b, s->nextTh);
+    for (uint32_t i = 0; i < count; i++) {
+        if (next == b.K) {
+            next = nextActive(arms, b, 0);
+            // no arm is left active, which only happens if the bounds are NaN
+            if (next == b.K) {
+                next = 0;
+            }
         }
+        th[i] = next;
+        next = nextActive(arms, b, next + 1);
+    }
+}
+
+static void succElimUpdate(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    SuccElimState *s = state;
+
+    if (s->norm < gain) {
+        s->norm = gain;
+    }
+
+    s->nextTh = nextActive(arms, b, th + 1);
+
+    // the sweep is over, or there are no rounds left
+    if (s->nextTh == b.K || round + 1 == b.T) {
+        eliminate(s, arms, b);
+        s->nextTh = 0;
     }
+}
 
-    printf("\n");
-    printf("----------------------------------------SUCCESSIVE-ELIMINATION-------"
-           "---------------------------------\n");
+static void succElimReport(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt,
+                           FILE *out) {
+    fprintf(out, "\n");
+    fprintf(out, "----------------------------------------SUCCESSIVE-ELIMINATION-------"
+            "---------------------------------\n");
+    uint32_t *slots = sortPlayedArms(arms);
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage "
-               "Reward\tFinal UCB\tFinal LCB\tActive\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-10.5lf\t%d\n", thres[th].low, thres[th].rewardSum,
-                   thres[th].timesChosen, thres[th].avgReward, upperConfBound[th], lowerConfBound[th], thresActive[th]);
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage "
+                "Reward\tFinal UCB\tFinal LCB\tActive\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            SuccElimArm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-10.5lf\t%d\n", arm->low, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward, a->upperConfBound, a->lowerConfBound, !a->eliminated);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage "
-               "Reward\tFinal UCB\tFinal LCB\tActive\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-10.5lf\t%d\n", thres[th].low,
-                   thres[th].high, thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward, upperConfBound[th],
-                   lowerConfBound[th], thresActive[th]);
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage "
+                "Reward\tFinal UCB\tFinal LCB\tActive\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            SuccElimArm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-10.5lf\t%d\n", arm->low,
+                    arm->high, arm->rewardSum, arm->timesChosen, arm->avgReward, a->upperConfBound, a->lowerConfBound,
+                    !a->eliminated);
         }
     }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
+
+    fprintf(out, "---------------------------------------------------------------------"
+            "---------------------------------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "---------------------------------\n\n");
+}
 
-    printf("---------------------------------------------------------------------"
-           "---------------------------------\n");
-    printf("Total Gain: %lf\n", totalGain[b.T - 1]);
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
-    printf("Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
-    printf("Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
-    printf("---------------------------------------------------------------------"
-           "---------------------------------\n\n");
-
-    free(thresActive);
-    free(upperConfBound);
-    free(lowerConfBound);
-    free(thres);
+
+static uint8_t succElimSave(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fwrite(state, sizeof(SuccElimState), 1, file) != 1;
+}
+
+static uint8_t succElimLoad(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fread(state, sizeof(SuccElimState), 1, file) != 1;
 }
+
+const Algorithm succElimAlg = {
+        .name = "succElim",
+        .title = "Successive Elimination",
+        .color = "cyan",
+        .pointType = 3,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 1,
+        .armStateSize = sizeof(SuccElimArm),
+        .init = succElimInit,
+        .select = succElimSelect,
+        .update = succElimUpdate,
+        .selectBatch = succElimSelectBatch,
+        .report = succElimReport,
+        .save = succElimSave,
+        .load = succElimLoad,
+        .free = free,
+};
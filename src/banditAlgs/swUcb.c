@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <banditAlgs.h>
+#include <util.h>
+
+/**
+ * INFO: The sliding window ucb (SW-UCB) algorithm in short:
+ *
+ * --------------------------------------------------
+ * try each arm once
+ * for each round t
+ *   pick arm which maximizes UCB_t, using only the last w rounds
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * UCB_t_a  = m_t_a + r_t_a
+ * m_t_a = average reward of arm a in the rounds t - w, ..., t - 1
+ * r_t_a = sqrt(2 * log(min(t, w)) / n_t_a)
+ * n_t_a = number of rounds in t - w, ..., t - 1 where arm a was chosen
+ * w = b.swUcbWindow, or 2 * sqrt(T * log(T)) if it isn't set
+ * an arm that wasn't chosen in the window has UCB_t_a = infinity
+ *
+ * forgetting the old rounds lets the algorithm follow prices whose distribution drifts, where ucb1 keeps playing the
+ * threshold that used to be the best. The last w rounds are kept in a ring buffer, so each round only the round that
+ * leaves the window is subtracted from its arm, instead of summing the window of every arm again
+ */
+
+typedef struct swUcbStateStruct {
+    uint64_t window;
+    // the slot and the reward of each round in the window, round t is at t % window
+    uint32_t *windowSlot;
+    double *windowReward;
+    double norm;
+} SwUcbState;
+
+typedef struct swUcbArmStruct {
+    double windowRewardSum;
+    uint64_t windowChosen;
+    double upperConfBound;
+} SwUcbArm;
+
+uint64_t getSwUcbWindow(Bandit b) {
+    uint64_t window = b.swUcbWindow;
+    if (!window) {
+        window = (uint64_t) ceil(2 * sqrt((double) b.T * log((double) b.T)));
+    }
+    if (window > b.T) {
+        window = b.T;
+    }
+    if (window < 1) {
+        window = 1;
+    }
+
+    return window;
+}
+
+static void *swUcbInit(ArmSpace *arms, Bandit b, double *data) {
+    SwUcbState *s = malloc(sizeof(SwUcbState));
+
+    s->window = getSwUcbWindow(b);
+
+    s->windowSlot = malloc(s->window * sizeof(uint32_t));
+    s->windowReward = malloc(s->window * sizeof(double));
+    s->norm = -INFINITY;
+
+    return s;
+}
+
+static uint32_t swUcbSelect(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    SwUcbState *s = state;
+
+    uint32_t unplayed = firstUnplayedArm(arms);
+    if (unplayed < b.K) {
+        return unplayed;
+    }
+
+    double maxUCB = -INFINITY;
+    uint32_t chosenTh = 0;
+    double logWindow = log((double) (round < s->window ? round : s->window));
+
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        SwUcbArm *a = getArmState(arms, slot);
+        if (!a->windowChosen) {
+            // an arm that fell out of the window is played again before any other
+            a->upperConfBound = INFINITY;
+            return arms->playedId[slot];
+        }
+
+        double average = fmax(a->windowRewardSum / (double) a->windowChosen / s->norm, 0);
+        double confRadius = sqrt(2 * logWindow / (double) a->windowChosen);
+        a->upperConfBound = average + confRadius;
+
+        if (a->upperConfBound > maxUCB) {
+            maxUCB = a->upperConfBound;
+            chosenTh = arms->playedId[slot];
+        }
+    }
+
+    return chosenTh;
+}
+
+static void swUcbUpdate(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    SwUcbState *s = state;
+
+    if (s->norm < gain) {
+        s->norm = gain;
+    }
+
+    // the round that leaves the window has the same place in the ring buffer as the new one
+    uint64_t i = round % s->window;
+    if (round >= s->window) {
+        SwUcbArm *old = getArmState(arms, s->windowSlot[i]);
+        old->windowChosen--;
+        old->windowRewardSum -= s->windowReward[i];
+        // the sum would otherwise keep the rounding errors of every reward that went through the window
+        if (!old->windowChosen) {
+            old->windowRewardSum = 0;
+        }
+    }
+
+    uint32_t slot = armSlot(arms, th);
+    SwUcbArm *a = getArmState(arms, slot);
+    a->windowChosen++;
+    a->windowRewardSum += gain;
+    s->windowSlot[i] = slot;
+    s->windowReward[i] = gain;
+}
+
+static void swUcbReport(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    SwUcbState *s = state;
+
+    fprintf(out, "\n");
+    fprintf(out, "-------------------------------------SW-UCB--------------------------"
+            "-----------\n");
+    fprintf(out, "Window: %lu\n", s->window);
+    uint32_t *slots = sortPlayedArms(arms);
+    if (!b.dualThres) {
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\tIn Window\tUCB\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            SwUcbArm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-9lu\t%-.5lf\n", arm->low, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward, a->windowChosen, a->upperConfBound);
+        }
+    } else {
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\tIn Window\tUCB\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            SwUcbArm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-9lu\t%-.5lf\n", arm->low, arm->high,
+                    arm->rewardSum, arm->timesChosen, arm->avgReward, a->windowChosen, a->upperConfBound);
+        }
+    }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
+
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
+}
+
+static uint8_t swUcbSave(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    SwUcbState *s = state;
+    uint8_t error = fwrite(&s->window, sizeof(uint64_t), 1, file) != 1;
+    error |= fwrite(&s->norm, sizeof(double), 1, file) != 1;
+    error |= fwrite(s->windowSlot, sizeof(uint32_t), s->window, file) != s->window;
+    error |= fwrite(s->windowReward, sizeof(double), s->window, file) != s->window;
+    return error;
+}
+
+static uint8_t swUcbLoad(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    SwUcbState *s = state;
+    if (fread(&s->window, sizeof(uint64_t), 1, file) != 1 || !s->window) {
+        return 1;
+    }
+
+    // the default window grows with the rounds, so it is kept as it was if rounds have been appended to the data
+    s->windowSlot = realloc(s->windowSlot, s->window * sizeof(uint32_t));
+    s->windowReward = realloc(s->windowReward, s->window * sizeof(double));
+    uint8_t error = fread(&s->norm, sizeof(double), 1, file) != 1;
+    error |= fread(s->windowSlot, sizeof(uint32_t), s->window, file) != s->window;
+    error |= fread(s->windowReward, sizeof(double), s->window, file) != s->window;
+    return error;
+}
+
+static void swUcbFree(void *state) {
+    SwUcbState *s = state;
+    free(s->windowSlot);
+    free(s->windowReward);
+    free(s);
+}
+
+const Algorithm swUcbAlg = {
+        .name = "swucb",
+        .title = "SW-UCB",
+        .color = "magenta",
+        .pointType = 9,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 1,
+        .armStateSize = sizeof(SwUcbArm),
+        .init = swUcbInit,
+        .select = swUcbSelect,
+        .update = swUcbUpdate,
+        .report = swUcbReport,
+        .save = swUcbSave,
+        .load = swUcbLoad,
+        .free = swUcbFree,
+};
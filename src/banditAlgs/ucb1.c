@@ -6,103 +6,151 @@
 #include <banditAlgs.h>
 #include <util.h>
 
-void ucb1(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-          double *totalOpt, Bandit b) {
-    /**
-     * INFO: The ucb1 algorithm in short:
-     *
-     * --------------------------------------------------
-     * try each arm once
-     * for each round t
-     *   pick arm which maximizes UCB_t
-     * --------------------------------------------------
-     *
-     * in this program, arm = threshold
-     *
-     * UCB_t_a  = m_t_a + r_t_a
-     * m_t_a = average reward of arm a in round t
-     * r_t_a = sqrt(2 * log(t) / n_t_a)
-     * n_t_a = number of rounds before t where arm a was chosen
-     */
-
-    Threshold *thres = malloc(b.K * sizeof(Threshold));
-    initThreshold(thres, b, data);
-
-    totalGain[0] = 0;
-    uint8_t heldItems = 0;
-    double heldItemValue = 0;
+/**
+ * INFO: The ucb1 algorithm in short:
+ *
+ * --------------------------------------------------
+ * try each arm once
+ * for each round t
+ *   pick arm which maximizes UCB_t
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * UCB_t_a  = m_t_a + r_t_a
+ * m_t_a = average reward of arm a in round t
+ * r_t_a = sqrt(2 * log(t) / n_t_a)
+ * n_t_a = number of rounds before t where arm a was chosen
+ */
 
+typedef struct ucb1StateStruct {
+    double norm;
+} Ucb1State;
+
+typedef struct ucb1ArmStruct {
+    double upperConfBound;
+} Ucb1Arm;
+
+static void *ucb1Init(ArmSpace *arms, Bandit b, double *data) {
+    Ucb1State *s = malloc(sizeof(Ucb1State));
+    s->norm = -INFINITY;
+    return s;
+}
+
+// the arm with the largest UCB, out of the played ones
+static uint32_t bestUcb(Ucb1State *s, ArmSpace *arms, Bandit b) {
+    double maxUCB = -INFINITY;
     uint32_t chosenTh = 0;
-    double *upperConfBound = malloc(b.K * sizeof(double));
-
-    double norm = -INFINITY;
-    for (uint32_t t = 0; t < b.K; t++) {
-        double gain = runRound(thres, t, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t,
-                               &heldItems, &heldItemValue);
-        if (norm < gain) {
-            norm = gain;
+
+    // every arm has been played once, so they all have a slot
+    for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+        Threshold *arm = &arms->played[slot];
+        Ucb1Arm *a = getArmState(arms, slot);
+        double average = fmax(arm->avgReward / s->norm, 0);
+        // double confRadius = sqrt(2 * log(pow(2.0, ceil(log2((double) round + 1.0)))) / (double)
+        // arm->timesChosen); double confRadius = sqrt(2 * log(round + 1) / (double) arm->timesChosen);
+        double confRadius = sqrt(2 * log(b.T) / (double) arm->timesChosen);
+        a->upperConfBound = average + confRadius;
+
+        if (a->upperConfBound > maxUCB) {
+            maxUCB = a->upperConfBound;
+            chosenTh = arms->playedId[slot];
         }
     }
 
-    for (uint64_t t = b.K; t < b.T; t++) {
-        double maxUCB = -INFINITY;
-        chosenTh = 0;
-
-        for (uint32_t th = 0; th < b.K; th++) {
-            double average = fmax(thres[th].avgReward / norm, 0);
-            // double confRadius = sqrt(2 * log(pow(2.0, ceil(log2((double) t + 1.0)))) / (double)
-            // thres[th].timesChosen); double confRadius = sqrt(2 * log(t + 1) / (double) thres[th].timesChosen);
-            double confRadius = sqrt(2 * log(b.T) / (double) thres[th].timesChosen);
-            upperConfBound[th] = average + confRadius;
-
-            if (upperConfBound[th] > maxUCB) {
-                maxUCB = upperConfBound[th];
-                chosenTh = th;
-            }
-        }
-        double gain = runRound(thres, chosenTh, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t,
-                               &heldItems, &heldItemValue);
+    return chosenTh;
+}
 
-        if (norm < gain) {
-            norm = gain;
-        }
+static uint32_t ucb1Select(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    if (round < b.K) {
+        return round;
     }
 
-    if (b.dynamicThres) {
-        for (uint64_t t = 0; t < b.T; t++) {
-            totalGain[t] -= totalGain[0];
-        }
+    return bestUcb(state, arms, b);
+}
+
+static void ucb1SelectBatch(void *state, ArmSpace *arms, Bandit b, uint64_t round, uint32_t count, uint32_t *th) {
+    // the bounds don't change before the batch is fed back, so every round after the first K plays the same arm,
+    // unless some arm has no reward yet, in which case the batch goes on trying the arms in order
+    uint32_t best = arms->playedCount == b.K ? bestUcb(state, arms, b) : 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t t = round + i;
+        th[i] = t < b.K || arms->playedCount < b.K ? (uint32_t) (t % b.K) : best;
     }
+}
+
+static void ucb1Update(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    Ucb1State *s = state;
+
+    if (s->norm < gain) {
+        s->norm = gain;
+    }
+}
 
-    printf("\n");
-    printf("--------------------------------------UCB1---------------------------"
-           "-----------\n");
+static void ucb1Report(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    fprintf(out, "\n");
+    fprintf(out, "--------------------------------------UCB1---------------------------"
+            "-----------\n");
+    uint32_t *slots = sortPlayedArms(arms);
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-.5lf\n", thres[th].low, thres[th].rewardSum,
-                   thres[th].timesChosen, thres[th].avgReward, upperConfBound[th]);
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            Ucb1Arm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-.5lf\n", arm->low, arm->rewardSum, arm->timesChosen,
+                    arm->avgReward, a->upperConfBound);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\n");
-        for (int32_t th = 0; th < b.K; th++) {
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-.5lf\n", thres[th].low, thres[th].high,
-                   thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward, upperConfBound[th]);
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            Ucb1Arm *a = getArmState(arms, slots[i]);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-.5lf\n", arm->low, arm->high,
+                    arm->rewardSum, arm->timesChosen, arm->avgReward, a->upperConfBound);
         }
     }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
 
-    printf("---------------------------------------------------------------------"
-           "-----------\n");
-    printf("Total Gain: %lf\n", totalGain[b.T - 1]);
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
-    printf("Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
-    printf("Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
-    printf("---------------------------------------------------------------------"
-           "-----------\n\n");
-
-    free(upperConfBound);
-    free(thres);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-----------\n\n");
 }
+
+
+static uint8_t ucb1Save(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fwrite(state, sizeof(Ucb1State), 1, file) != 1;
+}
+
+static uint8_t ucb1Load(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fread(state, sizeof(Ucb1State), 1, file) != 1;
+}
+
+const Algorithm ucb1Alg = {
+        .name = "ucb1",
+        .title = "UCB1",
+        .color = "blue",
+        .pointType = 4,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 1,
+        .armStateSize = sizeof(Ucb1Arm),
+        .init = ucb1Init,
+        .select = ucb1Select,
+        .update = ucb1Update,
+        .selectBatch = ucb1SelectBatch,
+        .report = ucb1Report,
+        .save = ucb1Save,
+        .load = ucb1Load,
+        .free = free,
+};
@@ -6,137 +6,178 @@
 #include <banditAlgs.h>
 #include <util.h>
 
-void ucb2(double *data, double *totalGain, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
-          double *totalOpt, Bandit b) {
-    /**
-     * INFO: The ucb2 algorithm in short:
-     *
-     * --------------------------------------------------
-     * initialize r_j = 0 for each threshold
-     *
-     * try each arm once
-     * for each round t
-     *   pick arm which maximizes UCB_t
-     *   play arm exactly tau(r_j + 1) - tau(r_j) times
-     *   set r_j = r_j + 1
-     * --------------------------------------------------
-     *
-     * in this program, arm = threshold
-     *
-     * UCB_t_a  = m_t_a + a_t_j
-     * m_t_a = average reward of arm a in round t
-     * a_t_j = sqrt((1 + a) * log(e * t / tau(r)) / (2 * tau(r)))
-     * a = a small number, probably 1 / t
-     * tau(r) = ceil((1 + a)^r)
-     */
-
-    Threshold *thres = malloc(b.K * sizeof(Threshold));
-    initThreshold(thres, b, data);
-
-    totalGain[0] = 0;
-    uint8_t heldItems = 0;
-    double heldItemValue = 0;
-
-    uint32_t chosenTh = 0;
-    double *upperConfBound = malloc(b.K * sizeof(double));
+/**
+ * INFO: The ucb2 algorithm in short:
+ *
+ * --------------------------------------------------
+ * initialize r_j = 0 for each threshold
+ *
+ * try each arm once
+ * for each round t
+ *   pick arm which maximizes UCB_t
+ *   play arm exactly tau(r_j + 1) - tau(r_j) times
+ *   set r_j = r_j + 1
+ * --------------------------------------------------
+ *
+ * in this program, arm = threshold
+ *
+ * UCB_t_a  = m_t_a + a_t_j
+ * m_t_a = average reward of arm a in round t
+ * a_t_j = sqrt((1 + a) * log(e * t / tau(r)) / (2 * tau(r)))
+ * a = a small number, b.ucb2Alpha
+ * tau(r) = ceil((1 + a)^r)
+ */
+
+typedef struct ucb2StateStruct {
+    // the arm of the current epoch and how many more times it has to be played
+    uint32_t chosenTh;
+    uint64_t repeat;
+    double norm;
+} Ucb2State;
+
+typedef struct ucb2ArmStruct {
+    double upperConfBound;
     // r_j
-    uint32_t *epochsChosen = malloc(b.K * sizeof(double));
-
-    double norm = -INFINITY;
-    for (uint32_t t = 0; t < b.K; t++) {
-        epochsChosen[t] = 0;
-        double gain = runRound(thres, t, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t,
-                               &heldItems, &heldItemValue);
-        if (norm < gain) {
-            norm = gain;
-        }
+    uint32_t epochsChosen;
+} Ucb2Arm;
+
+static void *ucb2Init(ArmSpace *arms, Bandit b, double *data) {
+    Ucb2State *s = malloc(sizeof(Ucb2State));
+
+    s->chosenTh = 0;
+    s->repeat = 0;
+    s->norm = -INFINITY;
+
+    return s;
+}
+
+static uint32_t ucb2Select(void *state, ArmSpace *arms, Bandit b, uint64_t round) {
+    Ucb2State *s = state;
+
+    if (round < b.K) {
+        return round;
     }
 
-    uint64_t t = b.K;
-    while (t < b.T) {
-        double alpha = 0.001; //(double)1 / (t + 1);
+    // an epoch can be 0 rounds long, keep picking until one isn't
+    while (s->repeat == 0) {
+        double alpha = b.ucb2Alpha; //(double)1 / (round + 1);
         double max = -INFINITY;
-        chosenTh = 0;
+        uint32_t chosenSlot = 0;
 
-        for (uint32_t th = 0; th < b.K; th++) {
-            double tau = ceil(pow((1 + alpha), epochsChosen[th]));
-            double average = fmax(thres[th].avgReward / norm, 0);
-            double confRadius = sqrt((1 + alpha) * log(M_E * ((double) t + 1) / tau) / (2 * tau));
-            upperConfBound[th] = average + confRadius;
+        // every arm has been played once, so they all have a slot
+        for (uint32_t slot = 0; slot < arms->playedCount; slot++) {
+            Ucb2Arm *a = getArmState(arms, slot);
+            double tau = ceil(pow((1 + alpha), a->epochsChosen));
+            double average = fmax(arms->played[slot].avgReward / s->norm, 0);
+            double confRadius = sqrt((1 + alpha) * log(M_E * ((double) round + 1) / tau) / (2 * tau));
+            a->upperConfBound = average + confRadius;
 
-            if (upperConfBound[th] > max) {
-                max = upperConfBound[th];
-                chosenTh = th;
+            if (a->upperConfBound > max) {
+                max = a->upperConfBound;
+                chosenSlot = slot;
             }
         }
 
-        epochsChosen[chosenTh]++;
-        uint64_t repeat = (uint64_t) ceil(pow((1 + alpha), epochsChosen[chosenTh] + 1)) -
-                          (uint64_t) ceil(pow((1 + alpha), epochsChosen[chosenTh]));
+        Ucb2Arm *chosen = getArmState(arms, chosenSlot);
+        s->chosenTh = arms->playedId[chosenSlot];
+        chosen->epochsChosen++;
+        s->repeat = (uint64_t) ceil(pow((1 + alpha), chosen->epochsChosen + 1)) -
+                    (uint64_t) ceil(pow((1 + alpha), chosen->epochsChosen));
+    }
 
-        while (t < b.T && repeat > 0) {
-            double gain = runRound(thres, chosenTh, b, data, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, t,
-                                   &heldItems, &heldItemValue);
-            if (norm < gain) {
-                norm = gain;
-            }
-            t++;
-            repeat--;
-        }
+    return s->chosenTh;
+}
+
+static void ucb2Update(void *state, ArmSpace *arms, Bandit b, uint32_t th, double gain, uint64_t round) {
+    Ucb2State *s = state;
+
+    if (s->norm < gain) {
+        s->norm = gain;
     }
 
-    if (b.dynamicThres) {
-        for (uint64_t t = 0; t < b.T; t++) {
-            totalGain[t] -= totalGain[0];
-        }
+    if (round >= b.K) {
+        s->repeat--;
     }
+}
 
-    printf("\n");
-    printf("--------------------------------------------------------------UCB2---"
-           "-------------------------------------------------\n");
+static void ucb2Report(void *state, ArmSpace *arms, Bandit b, double *totalGain, double *totalOpt, FILE *out) {
+    fprintf(out, "\n");
+    fprintf(out, "--------------------------------------------------------------UCB2---"
+            "-------------------------------------------------\n");
+    uint32_t *slots = sortPlayedArms(arms);
     if (!b.dualThres) {
-        printf("Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\t\t"
-               "Epochs Chosen\tAverage Epoch Duration\n");
-        for (int32_t th = 0; th < b.K; th++) {
+        fprintf(out, "Threshold\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\t\t"
+                "Epochs Chosen\tAverage Epoch Duration\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            Ucb2Arm *a = getArmState(arms, slots[i]);
             double epochDuration;
-            if (!epochsChosen[th]) {
+            if (!a->epochsChosen) {
                 epochDuration = 0;
             } else {
-                epochDuration = (double) thres[th].timesChosen / epochsChosen[th];
+                epochDuration = (double) arm->timesChosen / a->epochsChosen;
             }
-            printf("%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-13u\t%-.5lf\n", thres[th].low,
-                   thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward, upperConfBound[th],
-                   epochsChosen[th], epochDuration);
+            fprintf(out, "%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-13u\t%-.5lf\n", arm->low, arm->rewardSum,
+                    arm->timesChosen, arm->avgReward, a->upperConfBound, a->epochsChosen, epochDuration);
         }
     } else {
-        printf("Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\t\t"
-               "Epochs Chosen\tAverage Epoch Duration\n");
-        for (int32_t th = 0; th < b.K; th++) {
+        fprintf(out, "Low Thres\tHigh Thres\tTotal Reward\tTimes Chosen\tAverage Reward\tUCB\t\t"
+                "Epochs Chosen\tAverage Epoch Duration\n");
+        for (uint32_t i = 0; i < arms->playedCount; i++) {
+            Threshold *arm = &arms->played[slots[i]];
+            Ucb2Arm *a = getArmState(arms, slots[i]);
             double epochDuration;
-            if (!epochsChosen[th]) {
+            if (!a->epochsChosen) {
                 epochDuration = 0;
             } else {
-                epochDuration = (double) thres[th].timesChosen / epochsChosen[th];
+                epochDuration = (double) arm->timesChosen / a->epochsChosen;
             }
-            printf("%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-13u\t%-.5lf\n", thres[th].low,
-                   thres[th].high, thres[th].rewardSum, thres[th].timesChosen, thres[th].avgReward, upperConfBound[th],
-                   epochsChosen[th], epochDuration);
+            fprintf(out, "%-7.2lf\t\t%-7.2lf\t\t%-10.2lf\t%-12lu\t%-8.6lf\t%-10.5lf\t%-13u\t%-.5lf\n", arm->low,
+                    arm->high, arm->rewardSum, arm->timesChosen, arm->avgReward, a->upperConfBound, a->epochsChosen,
+                    epochDuration);
         }
     }
+    if (arms->playedCount < b.K) {
+        fprintf(out, "(%u arms that were never played are not shown)\n", b.K - arms->playedCount);
+    }
+    free(slots);
 
-    printf("---------------------------------------------------------------------"
-           "-------------------------------------------------\n");
-    printf("Total Gain: %lf\n", totalGain[b.T - 1]);
-    printf("Total OPT: %lf\n", totalOpt[b.T - 1]);
-    printf("Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
-    printf("Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
-    printf("Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
-    printf("Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
-    printf("Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
-    printf("---------------------------------------------------------------------"
-           "-------------------------------------------------\n\n");
-
-    free(upperConfBound);
-    free(epochsChosen);
-    free(thres);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-------------------------------------------------\n");
+    fprintf(out, "Total Gain: %lf\n", totalGain[b.T - 1]);
+    fprintf(out, "Total OPT: %lf\n", totalOpt[b.T - 1]);
+    fprintf(out, "Total Regret: %lf\n", totalOpt[b.T - 1] - totalGain[b.T - 1]);
+    fprintf(out, "Average Gain: %lf\n", totalGain[b.T - 1] / (double) b.T);
+    fprintf(out, "Average OPT: %lf\n", totalOpt[b.T - 1] / (double) b.T);
+    fprintf(out, "Average Regret: %lf\n", (totalOpt[b.T - 1] - totalGain[b.T - 1]) / (double) b.T);
+    fprintf(out, "Competitive Ratio: %lf\n", totalGain[b.T - 1] / totalOpt[b.T - 1]);
+    fprintf(out, "---------------------------------------------------------------------"
+            "-------------------------------------------------\n\n");
 }
+
+
+static uint8_t ucb2Save(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fwrite(state, sizeof(Ucb2State), 1, file) != 1;
+}
+
+static uint8_t ucb2Load(void *state, ArmSpace *arms, Bandit b, FILE *file) {
+    return fread(state, sizeof(Ucb2State), 1, file) != 1;
+}
+
+const Algorithm ucb2Alg = {
+        .name = "ucb2",
+        .title = "UCB2",
+        .color = "purple",
+        .pointType = 5,
+        .singleThres = 0,
+        .stochastic = 0,
+        .online = 1,
+        .armStateSize = sizeof(Ucb2Arm),
+        .init = ucb2Init,
+        .select = ucb2Select,
+        .update = ucb2Update,
+        .report = ucb2Report,
+        .save = ucb2Save,
+        .load = ucb2Load,
+        .free = free,
+};
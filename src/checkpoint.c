@@ -0,0 +1,135 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <checkpoint.h>
+#include <reporter.h>
+#include <util.h>
+
+// the first bytes of every checkpoint info file, "PBCK"
+#define CHECKPOINT_MAGIC 0x4b434250u
+#define CHECKPOINT_VERSION 1u
+
+/**
+ * @typedef checkpointInfoStruct
+ * @brief The contents of the checkpoint info file
+ *
+ */
+typedef struct checkpointInfoStruct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t T;
+    uint64_t N;
+    // hash of the prices of the T rounds
+    uint64_t checksum;
+    double dataMin;
+    double dataMax;
+    uint64_t seed;
+    uint64_t interval;
+} CheckpointInfo;
+
+static uint64_t hashPrices(double *data, uint64_t count) {
+    // FNV-1a over the 64 bit words of the prices
+    uint64_t hash = 14695981039346656037u;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t word;
+        memcpy(&word, &data[i], sizeof(uint64_t));
+        hash = (hash ^ word) * 1099511628211u;
+    }
+
+    return hash;
+}
+
+static void getCheckpointFilePath(char *filePath, Checkpoint *checkpoint, const char *name, const char *suffix) {
+    snprintf(filePath, 512, "%s%s%s", checkpoint->path, name, suffix);
+}
+
+void initCheckpoint(Checkpoint *checkpoint, char *resultPath) {
+    snprintf(checkpoint->path, sizeof(checkpoint->path), "%scheckpoint/", resultPath);
+    mkdir_p(checkpoint->path);
+}
+
+uint8_t saveCheckpointInfo(Checkpoint *checkpoint, Bandit b, double *data, double dataMin, double dataMax) {
+    CheckpointInfo info = {CHECKPOINT_MAGIC,
+                           CHECKPOINT_VERSION,
+                           b.T,
+                           b.N,
+                           hashPrices(data, b.T * b.N),
+                           dataMin,
+                           dataMax,
+                           b.seed,
+                           checkpoint->interval};
+
+    FILE *file = openCheckpointFile(checkpoint, "run", ".tmp", "wb");
+    if (!file) {
+        return 1;
+    }
+    uint8_t error = fwrite(&info, sizeof(CheckpointInfo), 1, file) != 1;
+    error |= closeCheckpointFile(file);
+
+    return error || replaceCheckpointFile(checkpoint, "run", "");
+}
+
+uint8_t loadCheckpointInfo(Checkpoint *checkpoint, Bandit *b, double *data, double *dataMin, double *dataMax,
+                           Reporter *reporter) {
+    FILE *file = openCheckpointFile(checkpoint, "run", "", "rb");
+    if (!file) {
+        reportf(reporter, "Error: There is no checkpoint in %s\n", checkpoint->path);
+        return 1;
+    }
+
+    CheckpointInfo info;
+    uint8_t error = fread(&info, sizeof(CheckpointInfo), 1, file) != 1;
+    fclose(file);
+    if (error || info.magic != CHECKPOINT_MAGIC || info.version != CHECKPOINT_VERSION) {
+        reportf(reporter, "Error: The checkpoint in %s is not valid\n", checkpoint->path);
+        return 1;
+    }
+
+    // rounds may have been appended to the data since, but the ones that have been played can't have changed
+    if (info.N != b->N || info.T > b->T || info.checksum != hashPrices(data, info.T * info.N)) {
+        reportf(reporter, "Error: The checkpoint was made for different data\n");
+        return 1;
+    }
+
+    *dataMin = info.dataMin;
+    *dataMax = info.dataMax;
+    b->seed = info.seed;
+    if (!checkpoint->interval) {
+        checkpoint->interval = info.interval;
+    }
+
+    return 0;
+}
+
+FILE *openCheckpointFile(Checkpoint *checkpoint, const char *name, const char *suffix, const char *mode) {
+    char filePath[512];
+    getCheckpointFilePath(filePath, checkpoint, name, suffix);
+
+    return fopen(filePath, mode);
+}
+
+uint8_t closeCheckpointFile(FILE *file) {
+    uint8_t error = fflush(file) != 0;
+    error |= fsync(fileno(file)) != 0;
+    error |= fclose(file) != 0;
+
+    return error;
+}
+
+uint8_t replaceCheckpointFile(Checkpoint *checkpoint, const char *name, const char *suffix) {
+    char filePath[512];
+    char tempPath[520];
+    getCheckpointFilePath(filePath, checkpoint, name, suffix);
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", filePath);
+
+    return rename(tempPath, filePath) != 0;
+}
+
+uint8_t truncateCheckpointFile(Checkpoint *checkpoint, const char *name, const char *suffix, uint64_t size) {
+    char filePath[512];
+    getCheckpointFilePath(filePath, checkpoint, name, suffix);
+
+    return truncate(filePath, (off_t) size) != 0;
+}
@@ -0,0 +1,460 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <armSpace.h>
+#include <banditAlgs.h>
+#include <checkpoint.h>
+#include <engine.h>
+#include <memoryPolicy.h>
+#include <metrics.h>
+#include <orderStats.h>
+#include <reporter.h>
+#include <threadPool.h>
+#include <timing.h>
+#include <util.h>
+
+const Algorithm *algorithms[ALG_COUNT] = {
+        [ALG_MEDIAN] = &medianAlg,   [ALG_GREEDY] = &greedyAlg, [ALG_EGREEDY] = &epsilonGreedyAlg,
+        [ALG_SUCCELIM] = &succElimAlg, [ALG_UCB1] = &ucb1Alg,     [ALG_UCB2] = &ucb2Alg,
+        [ALG_EXP3] = &exp3Alg,       [ALG_HOO] = &hooAlg,       [ALG_SWUCB] = &swUcbAlg,
+        [ALG_DUCB] = &dUcbAlg,
+};
+
+/**
+ * @typedef algRunStruct
+ * @brief Everything the engine keeps for a single running algorithm
+ *
+ */
+typedef struct algRunStruct {
+    const Algorithm *alg;
+    void *state;
+    ArmSpace arms;
+    AlgResults results;
+    uint8_t heldItems;
+    double heldItemValue;
+    // the next round the algorithm plays
+    uint64_t round;
+    // the rounds whose results are in the checkpoint
+    uint64_t savedRounds;
+} AlgRun;
+
+// the results saved for every round: total gain, average low and high threshold and average trades
+#define CHECKPOINT_ROW_SIZE (4 * sizeof(double))
+// the prices a task of a batch plays at least, fewer aren't worth handing to another thread
+#define BATCH_TASK_PRICES 16384
+
+/**
+ * @typedef batchRoundsStruct
+ * @brief The rounds of a batch, played by the tasks of playBatch a chunk of roundsPerTask rounds each
+ *
+ */
+typedef struct batchRoundsStruct {
+    double *data;
+    Bandit b;
+    ArmSpace *arms;
+    // the first round of the batch
+    uint64_t start;
+    uint32_t count;
+    uint32_t roundsPerTask;
+    // the arm, gain and trades of every round of the batch
+    uint32_t *th;
+    double *gain;
+    uint32_t *trades;
+} BatchRounds;
+
+static void deriveResults(AlgResults *r, double *totalOpt, Bandit b) {
+    MetricSource source = {r->totalGain, totalOpt, r->avgTrades};
+    double *metrics[METRIC_COUNT] = {
+            [METRIC_AVG_GAIN] = r->avgGain,
+            [METRIC_REGRET] = r->avgRegret,
+            [METRIC_COMP_RATIO] = r->compRatio,
+            [METRIC_AVG_TRADE_GAIN] = r->avgTradeGain,
+    };
+    getMetrics(&source, 0, b.T, metrics);
+}
+
+static uint8_t saveRun(AlgRun *run, Checkpoint *checkpoint, Bandit b) {
+    // only the rounds since the last checkpoint are appended to the results
+    FILE *file = openCheckpointFile(checkpoint, run->alg->name, ".rows", "ab");
+    if (!file) {
+        return 1;
+    }
+    uint8_t error = 0;
+    for (uint64_t t = run->savedRounds; t < run->round; t++) {
+        double row[4] = {run->results.totalGain[t], run->results.avgLowThreshold[t], run->results.avgHighThreshold[t],
+                         run->results.avgTrades[t]};
+        error |= fwrite(row, CHECKPOINT_ROW_SIZE, 1, file) != 1;
+    }
+    error |= closeCheckpointFile(file);
+    if (error) {
+        return 1;
+    }
+    run->savedRounds = run->round;
+
+    // the state is written to a temporary file first, so a crash while it is written leaves the old one in place
+    file = openCheckpointFile(checkpoint, run->alg->name, ".state.tmp", "wb");
+    if (!file) {
+        return 1;
+    }
+    error = fwrite(&run->round, sizeof(uint64_t), 1, file) != 1;
+    error |= fwrite(&run->heldItems, sizeof(uint8_t), 1, file) != 1;
+    error |= fwrite(&run->heldItemValue, sizeof(double), 1, file) != 1;
+    error |= writeArmSpace(&run->arms, file);
+    if (run->alg->save)
+        error |= run->alg->save(run->state, &run->arms, b, file);
+    error |= closeCheckpointFile(file);
+
+    return error || replaceCheckpointFile(checkpoint, run->alg->name, ".state");
+}
+
+static uint8_t loadRun(AlgRun *run, Checkpoint *checkpoint, Bandit b) {
+    FILE *file = openCheckpointFile(checkpoint, run->alg->name, ".state", "rb");
+    if (!file) {
+        return 1;
+    }
+    uint8_t error = fread(&run->round, sizeof(uint64_t), 1, file) != 1;
+    error |= fread(&run->heldItems, sizeof(uint8_t), 1, file) != 1;
+    error |= fread(&run->heldItemValue, sizeof(double), 1, file) != 1;
+    error |= readArmSpace(&run->arms, file);
+    if (run->alg->load)
+        error |= run->alg->load(run->state, &run->arms, b, file);
+    fclose(file);
+    if (error || run->round > b.T) {
+        return 1;
+    }
+
+    file = openCheckpointFile(checkpoint, run->alg->name, ".rows", "rb");
+    if (!file) {
+        return 1;
+    }
+    for (uint64_t t = 0; t < run->round && !error; t++) {
+        double row[4];
+        error = fread(row, CHECKPOINT_ROW_SIZE, 1, file) != 1;
+        run->results.totalGain[t] = row[0];
+        run->results.avgLowThreshold[t] = row[1];
+        run->results.avgHighThreshold[t] = row[2];
+        run->results.avgTrades[t] = row[3];
+    }
+    fclose(file);
+    run->savedRounds = run->round;
+
+    // rows after the saved round were appended by a checkpoint that didn't finish
+    return error || truncateCheckpointFile(checkpoint, run->alg->name, ".rows", run->round * CHECKPOINT_ROW_SIZE);
+}
+
+static void startRun(AlgRun *run, Checkpoint *checkpoint, Bandit b, double *data, Reporter *reporter) {
+    run->heldItems = 0;
+    run->heldItemValue = 0;
+    run->round = 0;
+    run->savedRounds = 0;
+    initArmSpace(&run->arms, b, data, run->alg->armStateSize);
+    run->state = run->alg->init(&run->arms, b, data);
+
+    if (checkpoint) {
+        // a checkpoint of the first round replaces whatever an older run left behind
+        FILE *file = openCheckpointFile(checkpoint, run->alg->name, ".rows", "wb");
+        if (!file || closeCheckpointFile(file) || saveRun(run, checkpoint, b)) {
+            reportf(reporter, "Error: Couldn't save the checkpoint of %s\n", run->alg->title);
+        }
+    }
+}
+
+static void freeRun(AlgRun *run) {
+    if (run->alg->free)
+        run->alg->free(run->state);
+    freeArmSpace(&run->arms);
+}
+
+// selects, plays and feeds back a single round
+static void playRound(AlgRun *run, Bandit b, double *data, uint64_t t) {
+    uint32_t th = run->alg->select(run->state, &run->arms, b, t);
+    // playArm may move the slots, so it has to be called before the arm is looked up
+    uint32_t slot = playArm(&run->arms, th);
+    Threshold *arm = &run->arms.played[slot];
+    double gain = runRound(arm, b, data, run->results.avgLowThreshold, run->results.avgHighThreshold,
+                           run->results.avgTrades, run->results.totalGain, t, &run->heldItems, &run->heldItemValue);
+    if (run->alg->update)
+        run->alg->update(run->state, &run->arms, b, th, gain, t);
+}
+
+static void playBatchTask(void *arg, uint32_t i) {
+    BatchRounds *batch = arg;
+    uint32_t first = i * batch->roundsPerTask;
+    uint32_t last = first + batch->roundsPerTask < batch->count ? first + batch->roundsPerTask : batch->count;
+
+    for (uint32_t r = first; r < last; r++) {
+        double low, high;
+        getArmThresholds(batch->arms, batch->th[r], &low, &high);
+        // without keepItems every round starts and ends without an item
+        uint8_t heldItems = 0;
+        double heldItemValue = 0;
+        batch->gain[r] = runThreshold(low, high, batch->b, batch->data, &batch->trades[r], batch->start + r,
+                                      &heldItems, &heldItemValue);
+    }
+}
+
+// selects the arms of count rounds at once, plays the rounds on threads workers and then feeds them back in order
+static void playBatch(AlgRun *run, BatchRounds *batch, uint64_t start, uint32_t count, uint32_t threads) {
+    Bandit b = batch->b;
+    batch->arms = &run->arms;
+    batch->start = start;
+    batch->count = count;
+    run->alg->selectBatch(run->state, &run->arms, b, start, count, batch->th);
+
+    if (b.keepItems) {
+        // an item kept from one round is sold in a later one, so the rounds are played in order
+        for (uint32_t r = 0; r < count; r++) {
+            double low, high;
+            getArmThresholds(&run->arms, batch->th[r], &low, &high);
+            batch->gain[r] = runThreshold(low, high, b, batch->data, &batch->trades[r], start + r, &run->heldItems,
+                                          &run->heldItemValue);
+        }
+    } else {
+        runTasks((count + batch->roundsPerTask - 1) / batch->roundsPerTask, threads, playBatchTask, batch);
+    }
+
+    for (uint32_t r = 0; r < count; r++) {
+        uint32_t slot = playArm(&run->arms, batch->th[r]);
+        recordRound(&run->arms.played[slot], run->results.avgLowThreshold, run->results.avgHighThreshold,
+                    run->results.avgTrades, run->results.totalGain, start + r, batch->gain[r], batch->trades[r]);
+        if (run->alg->update)
+            run->alg->update(run->state, &run->arms, b, batch->th[r], batch->gain[r], start + r);
+    }
+}
+
+static void reportRun(AlgRun *run, double *totalOpt, Bandit b, Reporter *reporter) {
+    // the algorithms print their reports to a stream, which is handed to the reporter as a whole
+    char *text;
+    size_t size;
+    FILE *out = open_memstream(&text, &size);
+    run->alg->report(run->state, &run->arms, b, run->results.totalGain, totalOpt, out);
+    fclose(out);
+    reporter->write(reporter->context, text);
+    free(text);
+}
+
+void runAlgorithms(double *data, double *totalOpt, AlgResults *results, Bandit b, Reporter *reporter,
+                   Checkpoint *checkpoint) {
+    AlgRun runs[ALG_COUNT];
+    uint32_t runCount = 0;
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (!b.algs[id])
+            continue;
+
+        AlgRun *run = &runs[runCount++];
+        run->alg = algorithms[id];
+        run->results = results[id];
+
+        if (!checkpoint || !checkpoint->resume) {
+            reportf(reporter, "Calculating %s...\n", run->alg->title);
+            startRun(run, checkpoint, b, data, reporter);
+            continue;
+        }
+
+        initArmSpace(&run->arms, b, data, run->alg->armStateSize);
+        run->state = run->alg->init(&run->arms, b, data);
+        if (loadRun(run, checkpoint, b)) {
+            reportf(reporter, "Calculating %s, which has no valid checkpoint, from the start...\n", run->alg->title);
+            freeRun(run);
+            startRun(run, checkpoint, b, data, reporter);
+        } else {
+            reportf(reporter, "Calculating %s from round %lu...\n", run->alg->title, run->round);
+        }
+    }
+
+    uint64_t firstRound = b.T;
+    for (uint32_t i = 0; i < runCount; i++) {
+        if (runs[i].round < firstRound)
+            firstRound = runs[i].round;
+    }
+
+    // with rolling dynamic thresholds the arms of every algorithm are re-seeded from one window, moved every round
+    ThresholdWindow window;
+    double *threshold = nullptr;
+    uint8_t rolling = b.dynamicThres && b.rollingRounds;
+    if (rolling && initThresholdWindow(&window, b)) {
+        reportf(reporter, "Error: Not enough memory for a window of %lu rounds, the thresholds stay those of the "
+                          "first round\n",
+                b.rollingRounds);
+        rolling = 0;
+    }
+    if (rolling) {
+        threshold = malloc(b.thresholds * sizeof(double));
+        for (uint32_t i = 0; i < runCount; i++) {
+            runs[i].arms.window = &window;
+        }
+    }
+
+    uint8_t timed = 0;
+    uint8_t profiled = 0;
+    uint64_t startRounds[ALG_COUNT];
+    for (uint32_t i = 0; i < runCount; i++) {
+        AlgTiming *timing = runs[i].results.timing;
+        timed |= timing != nullptr;
+        profiled |= timing && timing->profile;
+        startRounds[i] = runs[i].round;
+    }
+
+    // the counters of this thread, so algorithms run concurrently only count their own events
+    Counters threadCounters;
+    Counters *counters = profiled && !openCounters(&threadCounters, 0) ? &threadCounters : nullptr;
+    // a single algorithm is timed around all its rounds, otherwise the clock and the counters are read after each
+    // algorithm plays a round, and it is charged with what passed since the previous one was done
+    uint8_t timedRounds = timed && runCount > 1;
+    PhaseMark mark;
+    if (timed)
+        markPhase(counters, &mark);
+
+    // with batches the algorithms that support them select the arms of batch rounds from the same state and get the
+    // feedback of all of them afterwards, the others still play round by round
+    uint64_t batchRounds = b.batch > 1 ? b.batch : 1;
+    BatchRounds batch = {data, b};
+    if (batchRounds > 1) {
+        batch.roundsPerTask = b.N < BATCH_TASK_PRICES ? BATCH_TASK_PRICES / b.N : 1;
+        batch.th = malloc(batchRounds * sizeof(uint32_t));
+        batch.gain = malloc(batchRounds * sizeof(double));
+        batch.trades = malloc(batchRounds * sizeof(uint32_t));
+    }
+    uint32_t batchThreads = b.batchThreads ? b.batchThreads : 1;
+
+    // round major order: every algorithm plays round t (or the batch starting at it) before any of them moves on
+    for (uint64_t t = firstRound; t < b.T; t += batchRounds) {
+        uint64_t end = t + batchRounds < b.T ? t + batchRounds : b.T;
+        // the next round is on its way to the cache while every algorithm plays this one
+        if (end < b.T)
+            prefetchRound(&b.memory, data, b.N, end);
+
+        // with batches the window only moves at the start of each one
+        if (rolling && moveThresholdWindow(&window, b, data, t)) {
+            getWindowThresholds(&window, b, threshold);
+            for (uint32_t i = 0; i < runCount; i++) {
+                if (end > runs[i].round)
+                    reseedArmSpace(&runs[i].arms, threshold);
+            }
+            // the window is shared, so it isn't charged to the algorithm that plays first
+            if (timedRounds)
+                markPhase(counters, &mark);
+        }
+
+        for (uint32_t i = 0; i < runCount; i++) {
+            AlgRun *run = &runs[i];
+            // a resumed algorithm may have been saved after the others, even in the middle of a batch
+            if (end <= run->round)
+                continue;
+
+            uint64_t start = t > run->round ? t : run->round;
+            if (batchRounds > 1 && run->alg->selectBatch) {
+                playBatch(run, &batch, start, (uint32_t) (end - start), batchThreads);
+            } else {
+                for (uint64_t round = start; round < end; round++) {
+                    playRound(run, b, data, round);
+                }
+            }
+            if (timedRounds && run->results.timing)
+                chargePhase(&run->results.timing->run, counters, &mark);
+
+            uint64_t previous = run->round;
+            run->round = end;
+            if (checkpoint && (run->round / checkpoint->interval > previous / checkpoint->interval ||
+                               run->round == b.T) &&
+                saveRun(run, checkpoint, b)) {
+                reportf(reporter, "Error: Couldn't save the checkpoint of %s\n", run->alg->title);
+            }
+        }
+    }
+
+    if (timed && !timedRounds)
+        chargePhase(&runs[0].results.timing->run, counters, &mark);
+
+    for (uint32_t i = 0; i < runCount; i++) {
+        AlgRun *run = &runs[i];
+
+        if (b.dynamicThres && !run->alg->singleThres) {
+            for (uint64_t t = 0; t < b.T; t++) {
+                run->results.totalGain[t] -= run->results.totalGain[0];
+            }
+        }
+
+        if (reporter)
+            reportRun(run, totalOpt, b, reporter);
+        freeRun(run);
+
+        AlgTiming *timing = run->results.timing;
+        if (timing)
+            markPhase(counters, &mark);
+        deriveResults(&run->results, totalOpt, b);
+        if (timing) {
+            chargePhase(&timing->derive, counters, &mark);
+            timing->derive.rounds += b.T;
+            uint64_t rounds = b.T - startRounds[i];
+            timing->run.rounds += rounds;
+            timing->run.prices += rounds * b.N;
+            timing->run.bytes += rounds * b.N * sizeof(double);
+        }
+    }
+
+    if (rolling) {
+        freeThresholdWindow(&window);
+        free(threshold);
+    }
+    if (batchRounds > 1) {
+        free(batch.th);
+        free(batch.gain);
+        free(batch.trades);
+    }
+    if (counters)
+        closeCounters(counters);
+}
+
+/**
+ * @typedef algTaskStruct
+ * @brief The arguments shared by every task of runAlgorithmsConcurrently
+ *
+ */
+typedef struct algTaskStruct {
+    double *data;
+    double *totalOpt;
+    AlgResults *results;
+    Bandit b;
+    Checkpoint *checkpoint;
+    uint32_t ids[ALG_COUNT];
+    // the buffered output of each task
+    char *report[ALG_COUNT];
+} AlgTask;
+
+static void runAlgorithmTask(void *arg, uint32_t i) {
+    AlgTask *task = arg;
+    uint32_t id = task->ids[i];
+
+    Bandit b = task->b;
+    for (uint32_t other = 0; other < ALG_COUNT; other++) {
+        b.algs[other] = other == id;
+    }
+
+    size_t reportSize;
+    FILE *out = open_memstream(&task->report[i], &reportSize);
+    Reporter buffer = {writeToStream, out};
+    runAlgorithms(task->data, task->totalOpt, task->results, b, &buffer, task->checkpoint);
+    fclose(out);
+}
+
+void runAlgorithmsConcurrently(double *data, double *totalOpt, AlgResults *results, Bandit b, uint32_t threads,
+                               Reporter *reporter, Checkpoint *checkpoint) {
+    AlgTask task = {data, totalOpt, results, b, checkpoint};
+    uint32_t taskCount = 0;
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id])
+            task.ids[taskCount++] = id;
+    }
+
+    runTasks(taskCount, threads, runAlgorithmTask, &task);
+
+    for (uint32_t i = 0; i < taskCount; i++) {
+        if (reporter)
+            reporter->write(reporter->context, task.report[i]);
+        free(task.report[i]);
+    }
+}
@@ -0,0 +1,147 @@
+#include <linux/mempolicy.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <memoryPolicy.h>
+#include <threadPool.h>
+
+// the size of a huge page, the pages of an explicit mapping and the smallest mapping given transparent huge pages
+#define HUGE_PAGE_SIZE (2u << 20)
+// the bytes in front of every allocation that keep the size of its mapping, a cache line so the memory stays aligned
+#define MEMORY_HEADER 64u
+// the bytes of memory each task of PLACE_WORKERS writes first
+#define TOUCH_CHUNK HUGE_PAGE_SIZE
+// the most NUMA nodes a policy interleaves over
+#define MAX_NODES 1024
+
+static const char *pageNames[] = {[PAGES_TRANSPARENT] = "thp", [PAGES_EXPLICIT] = "hugetlb"};
+static const char *placementNames[] = {[PLACE_INTERLEAVE] = "interleave", [PLACE_WORKERS] = "workers"};
+
+uint8_t parseMemoryPolicy(char *text, MemoryPolicy *policy) {
+    *policy = (MemoryPolicy) {0};
+    char copy[128];
+    snprintf(copy, sizeof(copy), "%s", text);
+
+    char *save;
+    for (char *part = strtok_r(copy, "+", &save); part; part = strtok_r(nullptr, "+", &save)) {
+        if (!strcmp(part, "default")) {
+            continue;
+        } else if (!strcmp(part, "prefetch")) {
+            policy->prefetch = 1;
+            continue;
+        }
+
+        uint8_t found = 0;
+        for (uint8_t p = PAGES_TRANSPARENT; p <= PAGES_EXPLICIT && !found; p++) {
+            if (!strcmp(part, pageNames[p])) {
+                if (policy->pages) {
+                    return 1;
+                }
+                policy->pages = p;
+                found = 1;
+            }
+        }
+        for (uint8_t p = PLACE_INTERLEAVE; p <= PLACE_WORKERS && !found; p++) {
+            if (!strcmp(part, placementNames[p])) {
+                if (policy->placement) {
+                    return 1;
+                }
+                policy->placement = p;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void getMemoryPolicyName(const MemoryPolicy *policy, char *name, size_t size) {
+    snprintf(name, size, "%s%s%s%s%s", policy->pages ? pageNames[policy->pages] : "",
+             policy->pages && policy->placement ? "+" : "",
+             policy->placement ? placementNames[policy->placement] : "",
+             policy->prefetch && (policy->pages || policy->placement) ? "+" : "", policy->prefetch ? "prefetch" : "");
+    if (!*name) {
+        snprintf(name, size, "default");
+    }
+}
+
+// the pages are given out round robin over the nodes the process may use, best effort like the huge pages
+static void interleaveMemory(void *memory, size_t size) {
+    unsigned long nodes[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    if (syscall(SYS_get_mempolicy, nullptr, nodes, MAX_NODES, nullptr, MPOL_F_MEMS_ALLOWED)) {
+        return;
+    }
+    syscall(SYS_mbind, memory, size, MPOL_INTERLEAVE, nodes, MAX_NODES, 0);
+}
+
+/**
+ * @typedef touchTaskStruct
+ * @brief The memory the workers write first, a chunk per task
+ *
+ */
+typedef struct touchTaskStruct {
+    uint8_t *memory;
+    size_t size;
+} TouchTask;
+
+static void touchTask(void *arg, uint32_t i) {
+    TouchTask *task = arg;
+    size_t start = (size_t) i * TOUCH_CHUNK;
+    size_t end = start + TOUCH_CHUNK < task->size ? start + TOUCH_CHUNK : task->size;
+    // a write to every page gives it memory on the node of this worker, the kernel already zeroed it
+    for (size_t offset = start; offset < end; offset += 4096) {
+        task->memory[offset] = 0;
+    }
+}
+
+void *allocMemory(const MemoryPolicy *policy, size_t size, uint32_t threads) {
+    MemoryPolicy defaultPolicy = {0};
+    if (!policy) {
+        policy = &defaultPolicy;
+    }
+
+    size_t mapSize = size + MEMORY_HEADER;
+    uint8_t *map = MAP_FAILED;
+    if (policy->pages == PAGES_EXPLICIT) {
+        size_t hugeSize = (mapSize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        map = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (map != MAP_FAILED) {
+            mapSize = hugeSize;
+        }
+    }
+    if (map == MAP_FAILED) {
+        map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            return nullptr;
+        }
+        if (policy->pages != PAGES_DEFAULT && mapSize >= HUGE_PAGE_SIZE) {
+            madvise(map, mapSize, MADV_HUGEPAGE);
+        }
+    }
+
+    // the placement has to be set before the pages are first written, which gives them their node
+    if (policy->placement == PLACE_INTERLEAVE) {
+        interleaveMemory(map, mapSize);
+    } else if (policy->placement == PLACE_WORKERS) {
+        TouchTask task = {map, mapSize};
+        runTasks((uint32_t) ((mapSize + TOUCH_CHUNK - 1) / TOUCH_CHUNK), threads, touchTask, &task);
+    }
+
+    *(size_t *) map = mapSize;
+    return map + MEMORY_HEADER;
+}
+
+void freeMemory(void *memory) {
+    if (!memory) {
+        return;
+    }
+    uint8_t *map = (uint8_t *) memory - MEMORY_HEADER;
+    munmap(map, *(size_t *) map);
+}
@@ -0,0 +1,69 @@
+#include <stdint.h>
+
+#include <metrics.h>
+
+// the rounds calculated together, the 3 sources, 4 metrics and round counts of a block take 32KB
+#define METRIC_BLOCK 512
+
+const char *metricNames[METRIC_COUNT] = {
+        [METRIC_AVG_GAIN] = "avgGain",
+        [METRIC_REGRET] = "regret",
+        [METRIC_COMP_RATIO] = "compRatio",
+        [METRIC_AVG_TRADE_GAIN] = "avgTradeGain",
+};
+
+double getMetric(const MetricSource *source, enum metricId metric, uint64_t t) {
+    double rounds = (double) (t + 1);
+    switch (metric) {
+        case METRIC_AVG_GAIN:
+            return source->totalGain[t] / rounds;
+        case METRIC_REGRET:
+            return (source->totalOpt[t] - source->totalGain[t]) / rounds;
+        case METRIC_COMP_RATIO:
+            return source->totalGain[t] / source->totalOpt[t];
+        case METRIC_AVG_TRADE_GAIN:
+            return source->avgTrades[t] != 0 ? source->totalGain[t] / (source->avgTrades[t] * rounds) : 0;
+        default:
+            return 0;
+    }
+}
+
+void getMetrics(const MetricSource *source, uint64_t from, uint64_t to, double **metrics) {
+    double *restrict gain = source->totalGain;
+    double *restrict opt = source->totalOpt;
+    double *restrict trades = source->avgTrades;
+    double *restrict avgGain = metrics[METRIC_AVG_GAIN];
+    double *restrict regret = metrics[METRIC_REGRET];
+    double *restrict compRatio = metrics[METRIC_COMP_RATIO];
+    double *restrict tradeGain = metrics[METRIC_AVG_TRADE_GAIN];
+
+    // every metric is a loop of its own over the block, so all but the branching gain per trade are vectorized
+    double rounds[METRIC_BLOCK];
+    for (uint64_t start = from; start < to; start += METRIC_BLOCK) {
+        uint64_t size = to - start < METRIC_BLOCK ? to - start : METRIC_BLOCK;
+        for (uint64_t i = 0; i < size; i++) {
+            rounds[i] = (double) (start + i + 1);
+        }
+
+        if (avgGain) {
+            for (uint64_t i = 0; i < size; i++) {
+                avgGain[start + i] = gain[start + i] / rounds[i];
+            }
+        }
+        if (regret) {
+            for (uint64_t i = 0; i < size; i++) {
+                regret[start + i] = (opt[start + i] - gain[start + i]) / rounds[i];
+            }
+        }
+        if (compRatio) {
+            for (uint64_t i = 0; i < size; i++) {
+                compRatio[start + i] = gain[start + i] / opt[start + i];
+            }
+        }
+        if (tradeGain) {
+            for (uint64_t i = 0; i < size; i++) {
+                tradeGain[start + i] = trades[start + i] != 0 ? gain[start + i] / (trades[start + i] * rounds[i]) : 0;
+            }
+        }
+    }
+}
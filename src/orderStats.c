@@ -0,0 +1,247 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <orderStats.h>
+#include <util.h>
+
+// the most levels of a list, enough for any window of ORDER_STATS_MAX_CAPACITY prices
+#define MAX_LEVELS 32
+
+static uint32_t getHead(OrderStats *stats) {
+    return (uint32_t) stats->capacity;
+}
+
+static uint32_t getEnd(OrderStats *stats) {
+    return (uint32_t) stats->capacity + 1;
+}
+
+// the heights are geometric, half of the slots have one level, a quarter two and so on
+static uint8_t slotHeight(uint64_t slot, uint32_t levels) {
+    // the finalizer of splitmix64, so neighbouring slots get unrelated heights
+    uint64_t z = slot + 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    z ^= z >> 31;
+    return 1 + __builtin_ctzll(z | 1ull << (levels - 1));
+}
+
+// equal prices are ordered by their slots, so every slot has a single place in the list
+static uint8_t isBefore(OrderStats *stats, uint32_t a, uint32_t b) {
+    return stats->value[a] < stats->value[b] || (stats->value[a] == stats->value[b] && a < b);
+}
+
+uint8_t initOrderStats(OrderStats *stats, uint64_t capacity) {
+    *stats = (OrderStats) {0};
+    if (!capacity || capacity > ORDER_STATS_MAX_CAPACITY) {
+        return 1;
+    }
+
+    stats->capacity = capacity;
+    stats->levels = 1;
+    while (stats->levels < MAX_LEVELS && (1ull << stats->levels) < capacity) {
+        stats->levels++;
+    }
+
+    stats->value = malloc(capacity * sizeof(double));
+    stats->height = malloc(capacity * sizeof(uint8_t));
+    stats->firstLink = malloc((capacity + 1) * sizeof(uint64_t));
+    if (!stats->value || !stats->height || !stats->firstLink) {
+        freeOrderStats(stats);
+        return 1;
+    }
+
+    uint64_t links = 0;
+    for (uint64_t slot = 0; slot < capacity; slot++) {
+        stats->height[slot] = slotHeight(slot, stats->levels);
+        stats->firstLink[slot] = links;
+        links += stats->height[slot];
+    }
+    stats->firstLink[capacity] = links;
+    links += stats->levels;
+
+    stats->next = malloc(links * sizeof(uint32_t));
+    stats->width = malloc(links * sizeof(uint32_t));
+    if (!stats->next || !stats->width) {
+        freeOrderStats(stats);
+        return 1;
+    }
+    clearOrderStats(stats);
+
+    return 0;
+}
+
+void freeOrderStats(OrderStats *stats) {
+    free(stats->value);
+    free(stats->height);
+    free(stats->firstLink);
+    free(stats->next);
+    free(stats->width);
+    *stats = (OrderStats) {0};
+}
+
+void clearOrderStats(OrderStats *stats) {
+    // the end of the list is one step after the last price, so the links of the head step over the empty list once
+    uint64_t head = stats->firstLink[getHead(stats)];
+    for (uint32_t l = 0; l < stats->levels; l++) {
+        stats->next[head + l] = getEnd(stats);
+        stats->width[head + l] = 1;
+    }
+    stats->pushed = 0;
+}
+
+uint64_t getOrderStatsCount(OrderStats *stats) {
+    return stats->pushed < stats->capacity ? stats->pushed : stats->capacity;
+}
+
+static void insertSlot(OrderStats *stats, uint32_t slot) {
+    uint32_t chain[MAX_LEVELS];
+    uint64_t stepsAtLevel[MAX_LEVELS];
+
+    uint32_t node = getHead(stats);
+    for (uint32_t l = stats->levels; l-- > 0;) {
+        stepsAtLevel[l] = 0;
+        uint64_t link = stats->firstLink[node] + l;
+        while (stats->next[link] != getEnd(stats) && isBefore(stats, stats->next[link], slot)) {
+            stepsAtLevel[l] += stats->width[link];
+            node = stats->next[link];
+            link = stats->firstLink[node] + l;
+        }
+        chain[l] = node;
+    }
+
+    // steps is the distance from the node before the slot on level l to the one on level 0
+    uint64_t steps = 0;
+    for (uint32_t l = 0; l < stats->height[slot]; l++) {
+        uint64_t previous = stats->firstLink[chain[l]] + l;
+        uint64_t link = stats->firstLink[slot] + l;
+        stats->next[link] = stats->next[previous];
+        stats->next[previous] = slot;
+        stats->width[link] = stats->width[previous] - steps;
+        stats->width[previous] = steps + 1;
+        steps += stepsAtLevel[l];
+    }
+    for (uint32_t l = stats->height[slot]; l < stats->levels; l++) {
+        stats->width[stats->firstLink[chain[l]] + l]++;
+    }
+}
+
+static void removeSlot(OrderStats *stats, uint32_t slot) {
+    uint32_t chain[MAX_LEVELS];
+
+    uint32_t node = getHead(stats);
+    for (uint32_t l = stats->levels; l-- > 0;) {
+        uint64_t link = stats->firstLink[node] + l;
+        while (stats->next[link] != getEnd(stats) && isBefore(stats, stats->next[link], slot)) {
+            node = stats->next[link];
+            link = stats->firstLink[node] + l;
+        }
+        chain[l] = node;
+    }
+
+    for (uint32_t l = 0; l < stats->height[slot]; l++) {
+        uint64_t previous = stats->firstLink[chain[l]] + l;
+        uint64_t link = stats->firstLink[slot] + l;
+        stats->width[previous] += stats->width[link] - 1;
+        stats->next[previous] = stats->next[link];
+    }
+    for (uint32_t l = stats->height[slot]; l < stats->levels; l++) {
+        stats->width[stats->firstLink[chain[l]] + l]--;
+    }
+}
+
+void pushOrderStats(OrderStats *stats, double price) {
+    uint32_t slot = (uint32_t) (stats->pushed % stats->capacity);
+    if (stats->pushed >= stats->capacity) {
+        removeSlot(stats, slot);
+    }
+    stats->value[slot] = price;
+    insertSlot(stats, slot);
+    stats->pushed++;
+}
+
+static uint32_t findRank(OrderStats *stats, uint64_t rank) {
+    // the head is at position 0 and the price of rank r at position r + 1
+    uint64_t position = rank + 1;
+    uint32_t node = getHead(stats);
+    for (uint32_t l = stats->levels; l-- > 0;) {
+        uint64_t link = stats->firstLink[node] + l;
+        while (stats->width[link] <= position) {
+            position -= stats->width[link];
+            node = stats->next[link];
+            link = stats->firstLink[node] + l;
+        }
+    }
+
+    return node;
+}
+
+double getOrderStat(OrderStats *stats, uint64_t rank) {
+    return stats->value[findRank(stats, rank)];
+}
+
+double getOrderStatsQuantile(OrderStats *stats, double q) {
+    uint64_t count = getOrderStatsCount(stats);
+    if (!count) {
+        return 0;
+    }
+
+    // the same steps as gsl_stats_quantile_from_sorted_data, so the quantiles are the same to the bit
+    double index = q * (double) (count - 1);
+    uint64_t lhs = (uint64_t) index;
+    double delta = index - (double) lhs;
+    uint32_t node = findRank(stats, lhs);
+    if (lhs == count - 1) {
+        return stats->value[node];
+    }
+
+    uint32_t next = stats->next[stats->firstLink[node]];
+    return (1 - delta) * stats->value[node] + delta * stats->value[next];
+}
+
+uint8_t initThresholdWindow(ThresholdWindow *window, Bandit b) {
+    window->rounds = b.rollingRounds;
+    window->firstRound = 0;
+    window->endRound = 0;
+    if (!b.N || !b.rollingRounds || b.rollingRounds > ORDER_STATS_MAX_CAPACITY / b.N) {
+        window->prices = (OrderStats) {0};
+        return 1;
+    }
+
+    return initOrderStats(&window->prices, b.rollingRounds * b.N);
+}
+
+void freeThresholdWindow(ThresholdWindow *window) {
+    freeOrderStats(&window->prices);
+}
+
+uint8_t moveThresholdWindow(ThresholdWindow *window, Bandit b, double *data, uint64_t round) {
+    // the first round takes its own prices, every other one the rounds before it
+    uint64_t endRound = round ? round : 1;
+    uint64_t firstRound = endRound > window->rounds ? endRound - window->rounds : 0;
+    if (getOrderStatsCount(&window->prices) && window->firstRound == firstRound && window->endRound == endRound) {
+        return 0;
+    }
+
+    // a window that doesn't overlap the new one is emptied, otherwise the new rounds push the old ones out
+    uint64_t start = window->endRound;
+    if (!getOrderStatsCount(&window->prices) || window->endRound < firstRound || window->endRound > endRound) {
+        clearOrderStats(&window->prices);
+        start = firstRound;
+    }
+    for (uint64_t t = start; t < endRound; t++) {
+        for (uint64_t i = 0; i < b.N; i++) {
+            pushOrderStats(&window->prices, data[t * b.N + i]);
+        }
+    }
+    window->firstRound = firstRound;
+    window->endRound = endRound;
+
+    return 1;
+}
+
+void getWindowThresholds(ThresholdWindow *window, Bandit b, double *threshold) {
+    for (uint32_t th = 0; th < b.thresholds; th++) {
+        double quantile = (th + 1.0) / (b.thresholds + 1.0);
+        threshold[th] = getOrderStatsQuantile(&window->prices, quantile);
+    }
+}
@@ -0,0 +1,228 @@
+#include <libgen.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <banditAlgs.h>
+#include <output.h>
+#include <resultStore.h>
+#include <timing.h>
+#include <util.h>
+
+void getResultPath(char *resultPath, char *filepath, Bandit b) {
+    strcpy(resultPath, "prophetResults/");
+    char temp[256];
+    strcpy(temp, filepath);
+    char *dataName = basename(temp);
+    char *dot = strrchr(dataName, '.');
+    if (dot)
+        *dot = '\0';
+
+    char params[256];
+    char hyperparam[64];
+    snprintf(params, sizeof(params), "K%u", b.thresholds);
+    if (b.dualThres)
+        strcat(params, "d");
+    if (b.dynamicThres)
+        strcat(params, "D");
+    if (b.medianOpt)
+        strcat(params, "o");
+    if (b.bestHandOpt)
+        strcat(params, "O");
+    if (b.keepItems)
+        strcat(params, "k");
+    // hyperparameters are only part of the name when they aren't the default, so older results keep their place
+    if (b.ucb2Alpha != DEFAULT_UCB2_ALPHA) {
+        snprintf(hyperparam, sizeof(hyperparam), "_a%g", b.ucb2Alpha);
+        strcat(params, hyperparam);
+    }
+    if (b.eGreedyScale != DEFAULT_EGREEDY_SCALE) {
+        snprintf(hyperparam, sizeof(hyperparam), "_e%g", b.eGreedyScale);
+        strcat(params, hyperparam);
+    }
+    if (b.exp3UpperBound) {
+        snprintf(hyperparam, sizeof(hyperparam), "_x%g", b.exp3UpperBound);
+        strcat(params, hyperparam);
+    }
+    if (b.swUcbWindow) {
+        snprintf(hyperparam, sizeof(hyperparam), "_w%lu", b.swUcbWindow);
+        strcat(params, hyperparam);
+    }
+    if (b.dUcbDiscount) {
+        snprintf(hyperparam, sizeof(hyperparam), "_g%g", b.dUcbDiscount);
+        strcat(params, hyperparam);
+    }
+    if (b.dynamicThres && b.rollingRounds) {
+        snprintf(hyperparam, sizeof(hyperparam), "_r%lu", b.rollingRounds);
+        strcat(params, hyperparam);
+    }
+    if (b.batch > 1) {
+        snprintf(hyperparam, sizeof(hyperparam), "_b%lu", b.batch);
+        strcat(params, hyperparam);
+    }
+
+    strcat(resultPath, dataName);
+    strcat(resultPath, "/");
+    strcat(resultPath, params);
+    strcat(resultPath, "/");
+}
+
+uint8_t createRunStore(ResultStore *store, char *filepath, Bandit b, uint64_t decimation, uint8_t withOpt) {
+    // OPT has no regret or competitive ratio, which are the first two
+    static char *metrics[] = {"regret",           "compRatio", "totalGain", "avgLowThreshold",
+                              "avgHighThreshold", "avgTrades", "avgGain",   "avgTradeGain"};
+    const uint32_t metricCount = sizeof(metrics) / sizeof(metrics[0]);
+
+    char names[(ALG_COUNT + 1) * (sizeof(metrics) / sizeof(metrics[0]))][RESULT_NAME_SIZE];
+    char *columns[(ALG_COUNT + 1) * (sizeof(metrics) / sizeof(metrics[0]))];
+    uint32_t columnCount = 0;
+
+    for (uint32_t m = 2; withOpt && m < metricCount; m++) {
+        snprintf(names[columnCount], RESULT_NAME_SIZE, "opt/%s", metrics[m]);
+        columns[columnCount] = names[columnCount];
+        columnCount++;
+    }
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        for (uint32_t m = 0; b.algs[id] && m < metricCount; m++) {
+            snprintf(names[columnCount], RESULT_NAME_SIZE, "%s/%s", algorithms[id]->name, metrics[m]);
+            columns[columnCount] = names[columnCount];
+            columnCount++;
+        }
+    }
+
+    char storePath[512];
+    getResultPath(storePath, filepath, b);
+    mkdir_p(storePath);
+    strcat(storePath, "results.bin");
+
+    return createResultStore(store, storePath, b, decimation, columns, columnCount);
+}
+
+void saveReplicationResults(char *filepath, Bandit b, char *resultType, RunningStats *stats) {
+    char resultPath[256];
+    getResultPath(resultPath, filepath, b);
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (!stats[id].count)
+            continue;
+
+        char algResultPath[256];
+        strcpy(algResultPath, resultPath);
+        strcat(algResultPath, algorithms[id]->name);
+
+        mkdir_p(algResultPath);
+
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "/%sR%lu.txt", resultType, stats[id].count);
+        strcat(algResultPath, fileName);
+
+        FILE *file = fopen(algResultPath, "w");
+        if (!file) {
+            printf("Error opening file");
+            return;
+        }
+
+        // round, mean, variance
+        for (uint64_t t = 0; t < b.T; t++) {
+            fprintf(file, "%lu %lf %lf\n", t, stats[id].mean[t], getVariance(&stats[id], t));
+        }
+        fclose(file);
+    }
+}
+
+static void writeJsonString(FILE *file, const char *text) {
+    fputc('"', file);
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            fprintf(file, "\\%c", *c);
+        else if ((unsigned char) *c < 0x20)
+            fprintf(file, "\\u%04x", *c);
+        else
+            fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+static void writeJsonRate(FILE *file, const char *name, uint64_t amount, uint64_t ns, double scale) {
+    if (amount && ns)
+        fprintf(file, ", \"%s\": %.6g", name, (double) amount / (double) ns * scale);
+    else
+        fprintf(file, ", \"%s\": null", name);
+}
+
+// writes the fields of a phase after the name, if it has one, and its counts if the run was profiled
+static void writeJsonPhase(FILE *file, const char *name, PhaseTime *phase, Timings *timings) {
+    fprintf(file, "{");
+    if (name) {
+        fprintf(file, "\"name\": ");
+        writeJsonString(file, name);
+        fprintf(file, ", ");
+    }
+    fprintf(file, "\"ns\": %lu, \"rounds\": %lu, \"prices\": %lu, \"bytes\": %lu", phase->ns, phase->rounds,
+            phase->prices, phase->bytes);
+    // the time per price is the inverse of a rate
+    if (phase->prices)
+        fprintf(file, ", \"nsPerPrice\": %.6g", (double) phase->ns / (double) phase->prices);
+    else
+        fprintf(file, ", \"nsPerPrice\": null");
+    writeJsonRate(file, "roundsPerSecond", phase->rounds, phase->ns, 1e9);
+    writeJsonRate(file, "bytesPerSecond", phase->bytes, phase->ns, 1e9);
+
+    if (timings->profiling) {
+        for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+            if (timings->counters.fds[c] >= 0)
+                fprintf(file, ", \"%s\": %lu", counterNames[c], phase->counts[c]);
+            else
+                fprintf(file, ", \"%s\": null", counterNames[c]);
+        }
+        uint8_t hasIpc = timings->counters.fds[COUNTER_INSTRUCTIONS] >= 0 && phase->counts[COUNTER_CYCLES];
+        writeJsonRate(file, "instructionsPerCycle", hasIpc ? phase->counts[COUNTER_INSTRUCTIONS] : 0,
+                      phase->counts[COUNTER_CYCLES], 1);
+    }
+    fprintf(file, "}");
+}
+
+uint8_t saveTimings(char *path, char *filepath, Bandit b, Timings *timings) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return 1;
+    }
+
+    fprintf(file, "{\n  \"data\": ");
+    writeJsonString(file, filepath);
+    fprintf(file, ",\n  \"T\": %lu, \"N\": %lu, \"K\": %u, \"dualThres\": %u, \"dynamicThres\": %u,", b.T, b.N, b.K,
+            b.dualThres, b.dynamicThres);
+    char memory[64];
+    getMemoryPolicyName(&b.memory, memory, sizeof(memory));
+    fprintf(file, " \"rollingRounds\": %lu, \"memory\": \"%s\",", b.dynamicThres ? b.rollingRounds : 0, memory);
+    fprintf(file, " \"keepItems\": %u, \"batch\": %lu, \"profiled\": %s,\n", b.keepItems, b.batch > 1 ? b.batch : 1,
+            timings->profiling ? "true" : "false");
+
+    fprintf(file, "  \"phases\": [");
+    for (uint32_t i = 0; i < timings->phaseCount; i++) {
+        fprintf(file, "%s\n    ", i ? "," : "");
+        writeJsonPhase(file, timings->phases[i].name, &timings->phases[i], timings);
+    }
+    fprintf(file, "\n  ],\n");
+
+    fprintf(file, "  \"algorithms\": [");
+    uint8_t first = 1;
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        AlgTiming *alg = &timings->algs[id];
+        if (!alg->run.rounds)
+            continue;
+
+        fprintf(file, "%s\n    {\"name\": ", first ? "" : ",");
+        writeJsonString(file, algorithms[id]->name);
+        fprintf(file, ", \"run\": ");
+        writeJsonPhase(file, nullptr, &alg->run, timings);
+        fprintf(file, ", \"derive\": ");
+        writeJsonPhase(file, nullptr, &alg->derive, timings);
+        fprintf(file, "}");
+        first = 0;
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    return fclose(file) != 0;
+}
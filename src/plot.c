@@ -0,0 +1,465 @@
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <banditAlgs.h>
+#include <metrics.h>
+#include <plot.h>
+#include <util.h>
+
+/**
+ * INFO: A plot is built on the calling thread and drawn on a background one:
+ *
+ * --------------------------------------------------
+ * the series are downsampled into a new Plot
+ * the Plot is queued, and the caller moves on
+ * the plotter thread pipes the queued plots to gnuplot one at a time
+ * --------------------------------------------------
+ *
+ * A series is cut into PLOT_BUCKETS buckets of consecutive rounds, and only the smallest and the largest value of
+ * each bucket are kept, in the order they appear. That is one pass over the series, and unlike keeping every nth
+ * value it never drops a spike. The points are sent to gnuplot as binary doubles instead of text.
+ *
+ * A derived metric is never an array, its values are calculated as the series is downsampled.
+ */
+
+// the buckets a series is reduced to, each giving at most 2 points
+#define PLOT_BUCKETS 2048
+
+/**
+ * @typedef plotSeriesStruct
+ * @brief A downsampled line, or band, of a plot
+ *
+ */
+typedef struct plotSeriesStruct {
+    // x and y, or x, low and high for a band, for each point
+    double *points;
+    uint64_t count;
+    uint8_t columns;
+    // the gnuplot style of the series, after its data source in the plot command
+    char *style;
+} PlotSeries;
+
+/**
+ * @typedef plotStruct
+ * @brief A plot waiting to be drawn
+ *
+ */
+typedef struct plotStruct {
+    // the gnuplot commands before the plot command
+    char *setup;
+    size_t setupSize;
+    FILE *setupStream;
+    PlotSeries series[2 * (ALG_COUNT + 1)];
+    uint32_t seriesCount;
+    struct plotStruct *next;
+} Plot;
+
+static pthread_mutex_t plotLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t plotQueued = PTHREAD_COND_INITIALIZER;
+static Plot *queueHead = nullptr;
+static Plot *queueTail = nullptr;
+static uint8_t plotterStarted = 0;
+static uint8_t plotterStopping = 0;
+static pthread_t plotter;
+
+static Plot *newPlot() {
+    Plot *plot = calloc(1, sizeof(Plot));
+    plot->setupStream = open_memstream(&plot->setup, &plot->setupSize);
+    return plot;
+}
+
+static void freePlot(Plot *plot) {
+    for (uint32_t s = 0; s < plot->seriesCount; s++) {
+        free(plot->series[s].points);
+        free(plot->series[s].style);
+    }
+    free(plot->setup);
+    free(plot);
+}
+
+static char *formatStyle(const char *format, va_list args) {
+    char *style;
+    size_t size;
+    FILE *stream = open_memstream(&style, &size);
+    vfprintf(stream, format, args);
+    fclose(stream);
+    return style;
+}
+
+static uint64_t bucketStart(uint64_t bucket, uint64_t size) {
+    return bucket * size / PLOT_BUCKETS;
+}
+
+/**
+ * @typedef seriesValuesStruct
+ * @brief The values of a line, either an array or a metric calculated on demand
+ *
+ */
+typedef struct seriesValuesStruct {
+    double *values;
+    const MetricSource *source;
+    enum metricId metric;
+} SeriesValues;
+
+static double valueAt(SeriesValues *values, uint64_t i) {
+    return values->values ? values->values[i] : getMetric(values->source, values->metric, i);
+}
+
+static void addLine(Plot *plot, SeriesValues *values, uint64_t size, const char *format, va_list args) {
+    PlotSeries *series = &plot->series[plot->seriesCount++];
+    series->columns = 2;
+    series->points = malloc(2 * (size < 2 * PLOT_BUCKETS ? size : 2 * PLOT_BUCKETS) * sizeof(double));
+    series->count = 0;
+
+    if (size <= 2 * PLOT_BUCKETS) {
+        for (uint64_t i = 0; i < size; i++) {
+            series->points[2 * i] = (double) i;
+            series->points[2 * i + 1] = valueAt(values, i);
+        }
+        series->count = size;
+    } else {
+        for (uint64_t bucket = 0; bucket < PLOT_BUCKETS; bucket++) {
+            uint64_t end = bucketStart(bucket + 1, size);
+            uint64_t min = bucketStart(bucket, size);
+            uint64_t max = min;
+            double minValue = valueAt(values, min);
+            double maxValue = minValue;
+            for (uint64_t i = min + 1; i < end; i++) {
+                double value = valueAt(values, i);
+                if (value < minValue) {
+                    min = i;
+                    minValue = value;
+                }
+                if (value > maxValue) {
+                    max = i;
+                    maxValue = value;
+                }
+            }
+
+            // in the order they appear, so the line goes through both
+            double *point = &series->points[2 * series->count];
+            point[0] = (double) (min < max ? min : max);
+            point[1] = min < max ? minValue : maxValue;
+            series->count++;
+            if (max != min) {
+                point[2] = (double) (min < max ? max : min);
+                point[3] = min < max ? maxValue : minValue;
+                series->count++;
+            }
+        }
+    }
+
+    series->style = formatStyle(format, args);
+}
+
+/**
+ * @brief Adds a line through values, with the index of each value as its x
+ */
+static void addSeries(Plot *plot, double *values, uint64_t size, const char *format, ...) {
+    SeriesValues series = {.values = values};
+    va_list args;
+    va_start(args, format);
+    addLine(plot, &series, size, format, args);
+    va_end(args);
+}
+
+/**
+ * @brief Adds a line through the metric of source, calculated for every round as it is downsampled
+ */
+static void addMetricSeries(Plot *plot, const MetricSource *source, enum metricId metric, uint64_t size,
+                            const char *format, ...) {
+    SeriesValues series = {.source = source, .metric = metric};
+    va_list args;
+    va_start(args, format);
+    addLine(plot, &series, size, format, args);
+    va_end(args);
+}
+
+/**
+ * @brief Adds a band between low and high, widened in each bucket to its lowest low and highest high
+ */
+static void addBand(Plot *plot, double *low, double *high, uint64_t size, const char *format, ...) {
+    PlotSeries *series = &plot->series[plot->seriesCount++];
+    series->columns = 3;
+    series->points = malloc(3 * (size < 2 * PLOT_BUCKETS ? size : 2 * PLOT_BUCKETS) * sizeof(double));
+    series->count = 0;
+
+    if (size <= 2 * PLOT_BUCKETS) {
+        for (uint64_t i = 0; i < size; i++) {
+            series->points[3 * i] = (double) i;
+            series->points[3 * i + 1] = low[i];
+            series->points[3 * i + 2] = high[i];
+        }
+        series->count = size;
+    } else {
+        for (uint64_t bucket = 0; bucket < PLOT_BUCKETS; bucket++) {
+            uint64_t start = bucketStart(bucket, size);
+            uint64_t end = bucketStart(bucket + 1, size);
+            double bucketLow = low[start];
+            double bucketHigh = high[start];
+            for (uint64_t i = start + 1; i < end; i++) {
+                bucketLow = fmin(bucketLow, low[i]);
+                bucketHigh = fmax(bucketHigh, high[i]);
+            }
+
+            // the band covers the whole bucket
+            double *point = &series->points[3 * series->count];
+            point[0] = (double) start;
+            point[1] = bucketLow;
+            point[2] = bucketHigh;
+            point[3] = (double) (end - 1);
+            point[4] = bucketLow;
+            point[5] = bucketHigh;
+            series->count += 2;
+        }
+    }
+
+    va_list args;
+    va_start(args, format);
+    series->style = formatStyle(format, args);
+    va_end(args);
+}
+
+static void drawPlot(Plot *plot) {
+    FILE *gnuplot = popen("gnuplot -persistent", "w");
+    if (!gnuplot) {
+        return;
+    }
+
+    fputs(plot->setup, gnuplot);
+    fprintf(gnuplot, "plot ");
+    for (uint32_t s = 0; s < plot->seriesCount; s++) {
+        PlotSeries *series = &plot->series[s];
+        fprintf(gnuplot, "'-' binary record=(%lu) format='%s' using %s %s, ", series->count,
+                series->columns == 2 ? "%float64%float64" : "%float64%float64%float64",
+                series->columns == 2 ? "1:2" : "1:2:3", series->style);
+    }
+    fprintf(gnuplot, "\n");
+
+    // binary data follows the plot command in the order of the series, without the 'e' that ends text data
+    for (uint32_t s = 0; s < plot->seriesCount; s++) {
+        PlotSeries *series = &plot->series[s];
+        fwrite(series->points, series->columns * sizeof(double), series->count, gnuplot);
+    }
+
+    fflush(gnuplot);
+    pclose(gnuplot);
+}
+
+static void *runPlotter(void *arg) {
+    // a gnuplot that fails to start closes the pipe, which should only fail the plot and not kill the program
+    sigset_t pipeSignal;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, nullptr);
+
+    pthread_mutex_lock(&plotLock);
+    while (1) {
+        while (!queueHead && !plotterStopping) {
+            pthread_cond_wait(&plotQueued, &plotLock);
+        }
+        if (!queueHead) {
+            break;
+        }
+
+        Plot *plot = queueHead;
+        queueHead = plot->next;
+        if (!queueHead)
+            queueTail = nullptr;
+
+        pthread_mutex_unlock(&plotLock);
+        drawPlot(plot);
+        freePlot(plot);
+        pthread_mutex_lock(&plotLock);
+    }
+    pthread_mutex_unlock(&plotLock);
+
+    return nullptr;
+}
+
+static void queuePlot(Plot *plot) {
+    fclose(plot->setupStream);
+
+    pthread_mutex_lock(&plotLock);
+    if (!plotterStarted) {
+        plotterStarted = !pthread_create(&plotter, nullptr, runPlotter, nullptr);
+    }
+    if (!plotterStarted) {
+        // without a thread the plot is drawn right away
+        pthread_mutex_unlock(&plotLock);
+        drawPlot(plot);
+        freePlot(plot);
+        return;
+    }
+
+    if (queueTail)
+        queueTail->next = plot;
+    else
+        queueHead = plot;
+    queueTail = plot;
+    pthread_cond_signal(&plotQueued);
+    pthread_mutex_unlock(&plotLock);
+}
+
+void finishPlots() {
+    pthread_mutex_lock(&plotLock);
+    uint8_t started = plotterStarted;
+    plotterStopping = 1;
+    pthread_cond_signal(&plotQueued);
+    pthread_mutex_unlock(&plotLock);
+
+    if (started) {
+        pthread_join(plotter, nullptr);
+    }
+}
+
+void plotData(double *data, uint64_t size) {
+    Plot *plot = newPlot();
+    FILE *setup = plot->setupStream;
+
+    fprintf(setup, "set ylabel 'Price'\n");
+    fprintf(setup, "set grid\n");
+    fprintf(setup, "set yrange [0:1]\n");
+    addSeries(plot, data, size, "with lines lc rgb 'black' lw 0.5 title 'Price'");
+
+    queuePlot(plot);
+}
+
+static Plot *newAlgorithmsPlot(char *ylabel, uint8_t bounded) {
+    Plot *plot = newPlot();
+    FILE *setup = plot->setupStream;
+
+    fprintf(setup, "set zeroaxis\n");
+    fprintf(setup, "set xlabel 'Rounds'\n");
+    fprintf(setup, "set ylabel '%s'\n", ylabel);
+    if (bounded) {
+        fprintf(setup, "set yrange [0 : 1<*]\n");
+        fprintf(setup, "set arrow from graph 0, first 1 to graph 1, first 1 nohead dt 3 lw 1 lc rgb 'black'\n");
+    }
+
+    fprintf(setup, "set grid\n");
+    fprintf(setup, "set key outside\n");
+
+    fprintf(setup, "unset key\n");
+
+    return plot;
+}
+
+static char *optTitle(Bandit b) {
+    if (!b.medianOpt && !b.bestHandOpt)
+        return "OPT";
+    else if (b.medianOpt)
+        return "Median";
+    return "Best Threshold";
+}
+
+void plotAlgorithms(char *ylabel, Bandit b, double *opt, double **results, uint8_t bounded) {
+    Plot *plot = newAlgorithmsPlot(ylabel, bounded);
+
+    if (opt != NULL) {
+        addSeries(plot, opt, b.T, "with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 title '%s'", optTitle(b));
+    }
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            addSeries(plot, results[id], b.T, "with linespoints lc rgb '%s' pt %u ps 1 pn 20 lw 1.5 title '%s'",
+                      algorithms[id]->color, algorithms[id]->pointType, algorithms[id]->title);
+        }
+    }
+
+    queuePlot(plot);
+}
+
+void plotMetric(char *ylabel, Bandit b, enum metricId metric, MetricSource *opt, MetricSource *sources,
+                uint8_t bounded) {
+    Plot *plot = newAlgorithmsPlot(ylabel, bounded);
+
+    if (opt != NULL) {
+        addMetricSeries(plot, opt, metric, b.T, "with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 title '%s'",
+                        optTitle(b));
+    }
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            addMetricSeries(plot, &sources[id], metric, b.T,
+                            "with linespoints lc rgb '%s' pt %u ps 1 pn 20 lw 1.5 title '%s'", algorithms[id]->color,
+                            algorithms[id]->pointType, algorithms[id]->title);
+        }
+    }
+
+    queuePlot(plot);
+}
+
+void plotReplications(char *ylabel, Bandit b, RunningStats *stats, uint8_t bounded) {
+    Plot *plot = newPlot();
+    FILE *setup = plot->setupStream;
+
+    fprintf(setup, "set zeroaxis\n");
+    fprintf(setup, "set xlabel 'Rounds'\n");
+    fprintf(setup, "set ylabel '%s'\n", ylabel);
+    if (bounded) {
+        fprintf(setup, "set yrange [0 : 1<*]\n");
+        fprintf(setup, "set arrow from graph 0, first 1 to graph 1, first 1 nohead dt 3 lw 1 lc rgb 'black'\n");
+    }
+
+    fprintf(setup, "set grid\n");
+    fprintf(setup, "set key outside\n");
+    fprintf(setup, "set style fill transparent solid 0.2 noborder\n");
+
+    double *low = malloc(b.T * sizeof(double));
+    double *high = malloc(b.T * sizeof(double));
+
+    // every algorithm is plotted twice, first the 95% confidence band of the mean and then the mean itself
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (stats[id].count) {
+            for (uint64_t t = 0; t < b.T; t++) {
+                double halfWidth = 1.96 * sqrt(getVariance(&stats[id], t) / (double) stats[id].count);
+                low[t] = stats[id].mean[t] - halfWidth;
+                high[t] = stats[id].mean[t] + halfWidth;
+            }
+            addBand(plot, low, high, b.T, "with filledcurves lc rgb '%s' notitle", algorithms[id]->color);
+            addSeries(plot, stats[id].mean, b.T, "with lines lc rgb '%s' lw 1.5 title '%s (mean of %lu)'",
+                      algorithms[id]->color, algorithms[id]->title, stats[id].count);
+        }
+    }
+
+    free(low);
+    free(high);
+
+    queuePlot(plot);
+}
+
+void plotThresholds(Bandit b, double *optLow, double *optHigh, double **low, double **high) {
+    Plot *plot = newPlot();
+    FILE *setup = plot->setupStream;
+
+    fprintf(setup, "set xlabel 'Rounds'\n");
+    fprintf(setup, "set ylabel 'Average Threshold'\n");
+    fprintf(setup, "set yrange [0:1]\n");
+    fprintf(setup, "set grid\n");
+    fprintf(setup, "set key outside\n");
+
+    if (b.medianOpt || b.bestHandOpt) {
+        addSeries(plot, optLow, b.T, "with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 title '%s'", optTitle(b));
+        if (b.dualThres && !b.medianOpt)
+            addSeries(plot, optHigh, b.T, "with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 notitle");
+    }
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            const Algorithm *alg = algorithms[id];
+            addSeries(plot, low[id], b.T, "with linespoints lc rgb '%s' pt %u ps 1 pn 20 lw 1.5 title '%s'",
+                      alg->color, alg->pointType, alg->title);
+            if (b.dualThres && !alg->singleThres)
+                addSeries(plot, high[id], b.T, "with linespoints lc rgb '%s' pt %u ps 1 pn 20 lw 1.5 notitle",
+                          alg->color, alg->pointType);
+        }
+    }
+
+    queuePlot(plot);
+}
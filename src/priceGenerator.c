@@ -1,6 +1,4 @@
-#include <gsl/gsl_randist.h>
 #include <gsl/gsl_rng.h>
-#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,6 +7,9 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <priceModel.h>
+#include <priceStats.h>
+
 void printHelp() {
     printf("Usage:\n"
            "    # Only one option can be used at a time.\n"
@@ -22,6 +23,15 @@ void printHelp() {
            "Options:\n"
            "    -r                   Randomize distibution parameters for "
            "options u, g, e, and b.\n"
+           "    -G                   Draw every sample from GSL, one call per "
+           "sample, instead of\n"
+           "                         the vectorized sampler. Slower, but the "
+           "reference to check the\n"
+           "                         distributions against.\n"
+           "    -q                   Also calculate the statistics of the prices, and save them\n"
+           "                         next to the file for propheticBandits.\n"
+           "    -S <seed>            Seed the prices with <seed> instead of the time, the same\n"
+           "                         seed gives the same prices as propheticBandits --model.\n"
            "    -u                   Generate prices from the Uniform "
            "Distribution from 0 to 1.\n"
            "    -g                   Generate prices from the Gaussian "
@@ -53,19 +63,21 @@ int main(int argc, char *argv[]) {
 
     char distLetter = 'u';
     uint8_t randomizeFlag = 0;
+    uint8_t referenceFlag = 0;
+    uint8_t statsFlag = 0;
 
-    double autoregressivePhi = 1;
-    double movingAvgTheta = 1;
-    double sineFrequency = 1;
+    // phi of -a, theta of -m, or the frequency of -s and -c
+    double parameter = 1;
 
     uint64_t totalRounds = 1000;
     uint64_t pricesPerRound = 10;
+    uint64_t seed = time(nullptr);
 
     int opt;
 
     opterr = 0;
 
-    while ((opt = getopt(argc, argv, "hrugebTa:m:s:c:t:n:")) != -1) {
+    while ((opt = getopt(argc, argv, "hrGqugebTa:m:s:c:t:n:S:")) != -1) {
         switch (opt) {
             case 'h':
                 printHelp();
@@ -73,6 +85,12 @@ int main(int argc, char *argv[]) {
             case 'r':
                 randomizeFlag = 1;
                 break;
+            case 'G':
+                referenceFlag = 1;
+                break;
+            case 'q':
+                statsFlag = 1;
+                break;
             case 'u':
                 distLetter = 'u';
                 break;
@@ -90,19 +108,19 @@ int main(int argc, char *argv[]) {
                 break;
             case 'a':
                 distLetter = 'a';
-                autoregressivePhi = atof(optarg);
+                parameter = atof(optarg);
                 break;
             case 'm':
                 distLetter = 'm';
-                movingAvgTheta = atof(optarg);
+                parameter = atof(optarg);
                 break;
             case 's':
                 distLetter = 's';
-                sineFrequency = atof(optarg);
+                parameter = atof(optarg);
                 break;
             case 'c':
                 distLetter = 'c';
-                sineFrequency = atof(optarg);
+                parameter = atof(optarg);
                 break;
             case 't':
                 totalRounds = atoll(optarg);
@@ -110,8 +128,12 @@ int main(int argc, char *argv[]) {
             case 'n':
                 pricesPerRound = atoll(optarg);
                 break;
+            case 'S':
+                seed = strtoull(optarg, nullptr, 10);
+                break;
             case '?':
-                if (optopt == 'a' || optopt == 's' || optopt == 'c' || optopt == 't' || optopt == 'n')
+                if (optopt == 'a' || optopt == 'm' || optopt == 's' || optopt == 'c' || optopt == 't' ||
+                    optopt == 'n' || optopt == 'S')
                     fprintf(stderr, "Option -%c requires an argument.\n", optopt);
                 break;
             default:
@@ -123,32 +145,26 @@ int main(int argc, char *argv[]) {
         randomizeFlag = 0;
     }
 
+    PriceModel model = {distLetter, parameter, randomizeFlag, totalRounds, pricesPerRound, seed, nullptr};
+
     // Initialise gnu_rng variables for generating random values
-    const gsl_rng_type *T;
-    gsl_rng *r;
-    gsl_rng_env_setup();
-    T = gsl_rng_default;
-    r = gsl_rng_alloc(T);
-    gsl_rng_set(r, time(nullptr));
+    gsl_rng *r = nullptr;
+    if (referenceFlag) {
+        gsl_rng_env_setup();
+        r = gsl_rng_alloc(gsl_rng_default);
+        gsl_rng_set(r, seed);
+        model.reference = r;
+    }
 
     struct stat st = {0};
     if (stat("prophetData", &st) == -1) {
         mkdir("prophetData", 0700);
     }
 
+    char name[192];
+    getPriceModelName(&model, name, sizeof(name));
     char filename[256];
-    if (randomizeFlag) {
-        snprintf(filename, sizeof(filename), "prophetData/%crdataT%luN%lu.dat", distLetter, totalRounds,
-                 pricesPerRound);
-    } else if (distLetter == 'a') {
-        snprintf(filename, sizeof(filename), "prophetData/%cdataP%gT%luN%lu.dat", distLetter, autoregressivePhi,
-                 totalRounds, pricesPerRound);
-    } else if (distLetter == 's' || distLetter == 'c') {
-        snprintf(filename, sizeof(filename), "prophetData/%cdataP%gT%luN%lu.dat", distLetter, sineFrequency,
-                 totalRounds, pricesPerRound);
-    } else {
-        snprintf(filename, sizeof(filename), "prophetData/%cdataT%luN%lu.dat", distLetter, totalRounds, pricesPerRound);
-    }
+    snprintf(filename, sizeof(filename), "prophetData/%s.dat", name);
 
     FILE *file = fopen(filename, "wb");
     if (!file) {
@@ -159,129 +175,35 @@ int main(int argc, char *argv[]) {
     fwrite(&totalRounds, sizeof(totalRounds), 1, file);
     fwrite(&pricesPerRound, sizeof(pricesPerRound), 1, file);
 
-    if (distLetter == 'u') {
-        double high = 1;
-        double low = 0;
-        for (uint64_t t = 0; t < totalRounds; t++) {
-            for (uint64_t n = 0; n < pricesPerRound; n++) {
-                double u = gsl_rng_uniform(r) * (high - low) + low;
-                // printf("%lf\n", u);
-                fwrite(&u, sizeof(u), 1, file);
-            }
-            if (randomizeFlag) {
-                low += gsl_ran_gaussian(r, 1);
-                high += gsl_ran_gaussian(r, 1);
-                if (high < low) {
-                    // if low is larger than high then switch the their values
-                    double temp = low;
-                    low = high;
-                    high = temp;
-                }
-            }
-        }
-    }
-
-    if (distLetter == 'g') {
-        double mean = 0;
-        double sigma = 1;
-        for (uint64_t t = 0; t < totalRounds; t++) {
-            for (uint64_t n = 0; n < pricesPerRound; n++) {
-                double g = gsl_ran_gaussian(r, sigma) + mean;
-                // printf("%lf\n", g);
-                fwrite(&g, sizeof(g), 1, file);
-            }
-            if (randomizeFlag) {
-                mean += gsl_ran_gaussian(r, 1);
-                // make sure sigma is positive
-                sigma = fabs(sigma + gsl_ran_gaussian(r, 1));
-            }
-        }
-    }
-
-    if (distLetter == 'e') {
-        double mean = 1;
-        for (uint64_t t = 0; t < totalRounds; t++) {
-            for (uint64_t n = 0; n < pricesPerRound; n++) {
-                double e = gsl_ran_exponential(r, mean);
-                // printf("%lf\n", e);
-                fwrite(&e, sizeof(e), 1, file);
-            }
-            if (randomizeFlag) {
-                mean += gsl_ran_gaussian(r, 1);
-            }
-        }
-    }
-
-    if (distLetter == 'b') {
-        double prob = 0.5;
-        for (uint64_t t = 0; t < totalRounds; t++) {
-            for (uint64_t n = 0; n < pricesPerRound; n++) {
-                double b = (double) gsl_ran_bernoulli(r, prob);
-                // printf("%lf\n", b);
-                fwrite(&b, sizeof(b), 1, file);
-            }
-            if (randomizeFlag) {
-                prob = gsl_rng_uniform(r);
-            }
-        }
-    }
-
-    if (distLetter == 'T') {
-        uint64_t i = 0;
-        while (i < totalRounds * pricesPerRound) {
-            double num = (double) (i % 2);
-            fwrite(&num, sizeof(num), 1, file);
-            i++;
-        }
-    }
-
-    if (distLetter == 'a') {
-        double prev = gsl_ran_gaussian(r, 1);
-        for (uint64_t i = 0; i < totalRounds * pricesPerRound; i++) {
-            double noise = gsl_ran_gaussian(r, 1);
-            double a = prev * autoregressivePhi + noise;
-            prev = a;
-            // printf("%lf\n", a);
-            fwrite(&a, sizeof(a), 1, file);
-        }
-    }
-
-    if (distLetter == 'm') {
-        double prevNoise = 0;
-        for (uint64_t i = 0; i < totalRounds * pricesPerRound; i++) {
-            double noise = gsl_ran_gaussian(r, 1);
-            double m = noise + movingAvgTheta * prevNoise;
-            prevNoise = noise;
-            // printf("%lf\n", m);
-            fwrite(&m, sizeof(m), 1, file);
-        }
-    }
-
-    if (distLetter == 's') {
-        for (uint64_t i = 0; i < totalRounds * pricesPerRound; i++) {
-            double noise = gsl_ran_gaussian(r, 1);
-            // The sine wave will complete <frequency> cycles throughout all the rounds
-            double angularFreq = M_PI * sineFrequency / (double) (totalRounds * pricesPerRound);
-            double s = 5 * cos((double) i * angularFreq) + noise;
-            // printf("%lf\n", s);
-            fwrite(&s, sizeof(s), 1, file);
-        }
+    // the chunks are generated and joined in order, and each is written with a single call
+    PriceChunks chunks;
+    if (planPrices(&model, &chunks)) {
+        printf("Error: Not enough memory to plan the prices\n");
+        fclose(file);
+        return 1;
     }
-
-    if (distLetter == 'c') {
-        for (uint64_t i = 0; i < totalRounds * pricesPerRound; i++) {
-            double noise = gsl_ran_gaussian(r, 1);
-            // The sine wave will complete <frequency> cycles throughout all the rounds
-            double angularFreq = M_PI * sineFrequency / (double) (totalRounds * pricesPerRound);
-            double c = 5 * cbrt(cos((double) i * angularFreq)) + noise;
-            // printf("%lf\n", c);
-            fwrite(&c, sizeof(c), 1, file);
-        }
+    uint64_t start, size;
+    getChunkRange(&chunks, 0, &start, &size);
+    // the first chunk is the biggest one
+    double *prices = malloc(size * sizeof(double));
+
+    ChunkEnd previous = {0};
+    ChunkEnd end;
+    for (uint32_t c = 0; c < chunks.chunkCount; c++) {
+        getChunkRange(&chunks, c, &start, &size);
+        generateChunk(&chunks, c, prices, &end);
+        joinChunk(&chunks, c, prices, &previous);
+        carryChunkEnd(&chunks, c, &previous, &end);
+        previous = end;
+
+        fwrite(prices, sizeof(double), size, file);
     }
+    free(prices);
+    freePriceChunks(&chunks);
 
     /*  INFO: For quick testing if the distributions are correct:
      *
-     *  Uncomment the printf lines above.
+     *  Print every price of the chunk in the loop above, with printf("%lf\n", prices[j]).
      *  Run the command:
      *
      * ./priceGenerator [flags] | gnuplot -p -e "plot '<cat' frequency with lines"
@@ -289,5 +211,12 @@ int main(int argc, char *argv[]) {
      */
 
     fclose(file);
-    gsl_rng_free(r);
+    if (r) {
+        gsl_rng_free(r);
+    }
+
+    if (statsFlag && writePriceStats(filename, 0)) {
+        printf("Error: Couldn't save the statistics of %s\n", filename);
+        return 1;
+    }
 }
@@ -0,0 +1,565 @@
+#include <fcntl.h>
+#include <libgen.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <priceStats.h>
+#include <threadPool.h>
+
+// the bytes of the file each task parses
+#define TICK_CHUNK_BYTES (16u << 20)
+// numbers with more significant digits are rounded by strtod instead
+#define MAX_DIGITS 19
+
+void printHelp() {
+    printf("Usage:\n"
+           "    priceImporter [options] -n <prices per round> <csv file>\n"
+           "    priceImporter -h      # Display this help screen.\n\n"
+           "    # Every line of the file is a tick, \"<timestamp>,<symbol>,<price>\", in time\n"
+           "    # order. A first line that doesn't start with a timestamp is a header, and is\n"
+           "    # skipped. Timestamps are numbers, or dates like 2024-01-31T09:30:00.250 (UTC),\n"
+           "    # which are turned into seconds.\n\n"
+           "Options:\n"
+           "    -n <integer>         The prices of every round (default = 10).\n"
+           "    -b <seconds>         Make a round of every bucket of <seconds> of time instead of\n"
+           "                         every n ticks, whose prices are the last price at the end of\n"
+           "                         each n-th of the bucket. Buckets without ticks are skipped.\n"
+           "    -s <symbol>          Only import the ticks of <symbol>, all of them without it.\n"
+           "    -o <file>            Write the prices to <file>, instead of\n"
+           "                         prophetData/<csv name>[_<symbol>][B<seconds>]N<n>.dat.\n"
+           "    -q                   Also calculate the statistics of the prices, and save them\n"
+           "                         next to the .dat file for propheticBandits.\n"
+           "    -j <integer>         Parse the file with up to <integer> threads (0 = one per\n"
+           "                         cpu, the default).\n");
+}
+
+/**
+ * @typedef tickChunkStruct
+ * @brief The lines of the file a task parses, and the ticks it found in them
+ *
+ */
+typedef struct tickChunkStruct {
+    const char *start;
+    const char *end;
+    // only kept when the rounds are buckets of time
+    double *times;
+    double *prices;
+    uint64_t count;
+    uint64_t capacity;
+    // the line that couldn't be parsed, NULL if every line could
+    const char *badLine;
+    uint8_t outOfMemory;
+} TickChunk;
+
+/**
+ * @typedef importTaskStruct
+ * @brief What the tasks parsing the chunks share
+ *
+ */
+typedef struct importTaskStruct {
+    TickChunk *chunks;
+    const char *symbol;
+    size_t symbolLength;
+    uint8_t keepTimes;
+} ImportTask;
+
+static const double powersOf10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static inline uint8_t isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief Parses the decimal number at the start of [s, end), correctly rounded, and sets *next past it
+ *
+ * A number with at most 19 significant digits and a power of 10 up to 22 is a product or quotient of two doubles that
+ * are exact, so it is rounded correctly by a single operation, the rest are handed to strtod.
+ *
+ * @returns 0 on success, 1 if there is no number
+ */
+static uint8_t parseNumber(const char *s, const char *end, const char **next, double *value) {
+    const char *start = s;
+    uint8_t negative = 0;
+    if (s < end && (*s == '-' || *s == '+')) {
+        negative = *s++ == '-';
+    }
+
+    uint64_t mantissa = 0;
+    int32_t exponent = 0;
+    uint32_t digits = 0;
+    uint8_t anyDigit = 0;
+    uint8_t truncated = 0;
+    for (; s < end && isDigit(*s); s++) {
+        anyDigit = 1;
+        if (digits < MAX_DIGITS) {
+            mantissa = mantissa * 10 + (*s - '0');
+            digits += mantissa != 0;
+        } else {
+            exponent++;
+            truncated |= *s != '0';
+        }
+    }
+    if (s < end && *s == '.') {
+        for (s++; s < end && isDigit(*s); s++) {
+            anyDigit = 1;
+            if (digits < MAX_DIGITS) {
+                mantissa = mantissa * 10 + (*s - '0');
+                digits += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= *s != '0';
+            }
+        }
+    }
+    if (!anyDigit) {
+        return 1;
+    }
+    if (s < end && (*s == 'e' || *s == 'E')) {
+        const char *e = s + 1;
+        uint8_t negativeExp = 0;
+        if (e < end && (*e == '-' || *e == '+')) {
+            negativeExp = *e++ == '-';
+        }
+        if (e < end && isDigit(*e)) {
+            int32_t power = 0;
+            for (; e < end && isDigit(*e); e++) {
+                // anything bigger is already out of the range of doubles
+                if (power < 100000) {
+                    power = power * 10 + (*e - '0');
+                }
+            }
+            exponent += negativeExp ? -power : power;
+            s = e;
+        }
+    }
+    *next = s;
+
+    if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        double result = (double) mantissa;
+        result = exponent < 0 ? result / powersOf10[-exponent] : result * powersOf10[exponent];
+        *value = negative ? -result : result;
+        return 0;
+    }
+
+    // the file isn't terminated, so strtod reads a copy
+    char text[128];
+    size_t length = s - start;
+    if (length >= sizeof(text)) {
+        return 1;
+    }
+    memcpy(text, start, length);
+    text[length] = '\0';
+    *value = strtod(text, nullptr);
+    return 0;
+}
+
+// the days from 1970-01-01 to a date of the proleptic Gregorian calendar
+static int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// parses exactly count digits
+static uint8_t parseDigits(const char *s, const char *end, uint32_t count, int64_t *value) {
+    if (end - s < (ptrdiff_t) count) {
+        return 1;
+    }
+    *value = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!isDigit(s[i])) {
+            return 1;
+        }
+        *value = *value * 10 + (s[i] - '0');
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses a timestamp field, a number, or a date YYYY-MM-DD[(T| )HH:MM:SS[.fraction]][Z] turned into seconds
+ *
+ * @returns 0 on success, 1 if the whole field isn't a timestamp
+ */
+static uint8_t parseTimestamp(const char *s, const char *end, double *value) {
+    const char *next;
+    if (end - s < 10 || s[4] != '-') {
+        return parseNumber(s, end, &next, value) || next != end;
+    }
+
+    int64_t year, month, day, hour = 0, minute = 0, second = 0;
+    if (parseDigits(s, end, 4, &year) || parseDigits(s + 5, end, 2, &month) || s[7] != '-' ||
+        parseDigits(s + 8, end, 2, &day)) {
+        return 1;
+    }
+    s += 10;
+    double fraction = 0;
+    if (s < end && (*s == 'T' || *s == ' ')) {
+        if (end - s < 9 || parseDigits(s + 1, end, 2, &hour) || s[3] != ':' || parseDigits(s + 4, end, 2, &minute) ||
+            s[6] != ':' || parseDigits(s + 7, end, 2, &second)) {
+            return 1;
+        }
+        s += 9;
+        if (s < end && *s == '.') {
+            if (parseNumber(s, end, &next, &fraction)) {
+                return 1;
+            }
+            s = next;
+        }
+    }
+    if (s < end && *s == 'Z') {
+        s++;
+    }
+    if (s != end) {
+        return 1;
+    }
+
+    *value = (double) ((daysFromCivil(year, month, day) * 24 + hour) * 3600 + minute * 60 + second) + fraction;
+    return 0;
+}
+
+static uint8_t addTick(TickChunk *chunk, uint8_t keepTimes, double time, double price) {
+    if (chunk->count == chunk->capacity) {
+        uint64_t capacity = chunk->capacity ? 2 * chunk->capacity : 4096;
+        double *prices = realloc(chunk->prices, capacity * sizeof(double));
+        if (!prices) {
+            return 1;
+        }
+        chunk->prices = prices;
+        if (keepTimes) {
+            double *times = realloc(chunk->times, capacity * sizeof(double));
+            if (!times) {
+                return 1;
+            }
+            chunk->times = times;
+        }
+        chunk->capacity = capacity;
+    }
+
+    if (keepTimes) {
+        chunk->times[chunk->count] = time;
+    }
+    chunk->prices[chunk->count++] = price;
+    return 0;
+}
+
+static void parseChunk(void *arg, uint32_t c) {
+    ImportTask *task = arg;
+    TickChunk *chunk = &task->chunks[c];
+
+    const char *line = chunk->start;
+    while (line < chunk->end) {
+        const char *lineEnd = memchr(line, '\n', chunk->end - line);
+        lineEnd = lineEnd ? lineEnd : chunk->end;
+        const char *next = lineEnd + 1;
+        if (lineEnd > line && lineEnd[-1] == '\r') {
+            lineEnd--;
+        }
+        if (lineEnd == line) {
+            line = next;
+            continue;
+        }
+
+        const char *timeEnd = memchr(line, ',', lineEnd - line);
+        const char *symbol = timeEnd ? timeEnd + 1 : nullptr;
+        const char *symbolEnd = symbol ? memchr(symbol, ',', lineEnd - symbol) : nullptr;
+        const char *price = symbolEnd ? symbolEnd + 1 : nullptr;
+        const char *priceEnd;
+        double time, value;
+        if (!price || parseTimestamp(line, timeEnd, &time) || parseNumber(price, lineEnd, &priceEnd, &value) ||
+            priceEnd != lineEnd) {
+            // a header is only allowed on the first line of the file
+            if (line != chunk->start || c != 0) {
+                chunk->badLine = line;
+                return;
+            }
+            line = next;
+            continue;
+        }
+
+        uint8_t wanted = !task->symbol || ((size_t) (symbolEnd - symbol) == task->symbolLength &&
+                                           !memcmp(symbol, task->symbol, task->symbolLength));
+        if (wanted && addTick(chunk, task->keepTimes, time, value)) {
+            chunk->outOfMemory = 1;
+            return;
+        }
+        line = next;
+    }
+}
+
+/**
+ * @typedef bucketWriterStruct
+ * @brief The round of the time bucket being filled, its prices are the last price at the end of every n-th of it
+ *
+ */
+typedef struct bucketWriterStruct {
+    FILE *file;
+    double bucket;
+    uint64_t N;
+    double *round;
+    // the index of the current bucket, and the next price of its round
+    int64_t index;
+    uint64_t filled;
+    double last;
+    uint64_t rounds;
+} BucketWriter;
+
+static void finishBucket(BucketWriter *writer) {
+    while (writer->filled < writer->N) {
+        writer->round[writer->filled++] = writer->last;
+    }
+    fwrite(writer->round, sizeof(double), writer->N, writer->file);
+    writer->rounds++;
+}
+
+static void addBucketTick(BucketWriter *writer, uint8_t first, double time, double price) {
+    int64_t index = (int64_t) floor(time / writer->bucket);
+    if (first) {
+        writer->index = index;
+        writer->filled = 0;
+        writer->last = price;
+    } else if (index > writer->index) {
+        // the buckets in between had no ticks, so they are skipped
+        finishBucket(writer);
+        writer->index = index;
+        writer->filled = 0;
+    }
+
+    // the ends of the n-ths before the tick take the price before it
+    double step = writer->bucket / writer->N;
+    double start = writer->index * writer->bucket;
+    while (writer->filled < writer->N && start + (writer->filled + 1) * step <= time) {
+        writer->round[writer->filled++] = writer->last;
+    }
+    writer->last = price;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        printHelp();
+        return 0;
+    }
+
+    uint64_t pricesPerRound = 10;
+    double bucket = 0;
+    char *symbol = nullptr;
+    char *outputPath = nullptr;
+    uint32_t threads = 0;
+    uint8_t statsFlag = 0;
+
+    int opt;
+
+    opterr = 0;
+
+    while ((opt = getopt(argc, argv, "hqn:b:s:o:j:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printHelp();
+                return 0;
+            case 'n':
+                pricesPerRound = atoll(optarg);
+                break;
+            case 'b':
+                bucket = atof(optarg);
+                break;
+            case 's':
+                symbol = optarg;
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'q':
+                statsFlag = 1;
+                break;
+            case '?':
+                if (optopt == 'n' || optopt == 'b' || optopt == 's' || optopt == 'o' || optopt == 'j')
+                    fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+                break;
+            default:
+                abort();
+        }
+    }
+
+    if (optind >= argc) {
+        printf("Error: No filename provided\n");
+        return 1;
+    }
+    char *csvPath = argv[optind];
+    if (!pricesPerRound) {
+        printf("Error: A round needs at least 1 price\n");
+        return 1;
+    }
+    if (bucket < 0 || !isfinite(bucket)) {
+        printf("Error: A bucket has to be a positive number of seconds\n");
+        return 1;
+    }
+
+    int fd = open(csvPath, O_RDONLY);
+    if (fd < 0) {
+        printf("Error opening file %s\n", csvPath);
+        return 1;
+    }
+    off_t fileSize = lseek(fd, 0, SEEK_END);
+    if (fileSize <= 0) {
+        printf("Error: %s is empty\n", csvPath);
+        close(fd);
+        return 1;
+    }
+    const char *text = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        printf("Error: Couldn't map %s\n", csvPath);
+        return 1;
+    }
+    madvise((void *) text, fileSize, MADV_SEQUENTIAL);
+
+    /* INFO: The file is parsed in parallel, in chunks of whole lines:
+     *
+     * --------------------------------------------------
+     * the file is cut every TICK_CHUNK_BYTES, each cut moved past the end of the line it falls in
+     * each task parses the lines of its chunk into an array of its own
+     * the arrays are written in the order of the chunks, so the ticks keep the order of the file
+     * --------------------------------------------------
+     */
+    uint32_t chunkCount = (fileSize + TICK_CHUNK_BYTES - 1) / TICK_CHUNK_BYTES;
+    TickChunk *chunks = calloc(chunkCount, sizeof(TickChunk));
+    const char *fileEnd = text + fileSize;
+    const char *cut = text;
+    for (uint32_t c = 0; c < chunkCount; c++) {
+        chunks[c].start = cut;
+        if (c + 1 < chunkCount) {
+            const char *end = text + (uint64_t) (c + 1) * TICK_CHUNK_BYTES;
+            end = end > cut ? end : cut;
+            const char *newline = end < fileEnd ? memchr(end, '\n', fileEnd - end) : nullptr;
+            cut = newline ? newline + 1 : fileEnd;
+        } else {
+            cut = fileEnd;
+        }
+        chunks[c].end = cut;
+    }
+
+    ImportTask task = {chunks, symbol, symbol ? strlen(symbol) : 0, bucket > 0};
+    runTasks(chunkCount, threads, parseChunk, &task);
+
+    uint64_t ticks = 0;
+    uint8_t error = 0;
+    for (uint32_t c = 0; c < chunkCount && !error; c++) {
+        if (chunks[c].badLine) {
+            printf("Error: The line at byte %lu of %s isn't a tick\n", (uint64_t) (chunks[c].badLine - text), csvPath);
+            error = 1;
+        } else if (chunks[c].outOfMemory) {
+            printf("Error: Not enough memory for the ticks\n");
+            error = 1;
+        }
+        ticks += chunks[c].count;
+    }
+    if (!error && !ticks) {
+        printf("Error: %s has no ticks%s%s\n", csvPath, symbol ? " of " : "", symbol ? symbol : "");
+        error = 1;
+    }
+    if (!error && !bucket && ticks < pricesPerRound) {
+        printf("Error: %s has fewer ticks than a round\n", csvPath);
+        error = 1;
+    }
+
+    char filename[512];
+    if (!error && !outputPath) {
+        struct stat st = {0};
+        if (stat("prophetData", &st) == -1) {
+            mkdir("prophetData", 0700);
+        }
+
+        // the name of the csv file, without its directory and extension
+        char name[256];
+        snprintf(name, sizeof(name), "%s", csvPath);
+        char *base = basename(name);
+        char *extension = strrchr(base, '.');
+        if (extension && extension != base) {
+            *extension = '\0';
+        }
+
+        int length = snprintf(filename, sizeof(filename), "prophetData/%s", base);
+        if (symbol) {
+            length += snprintf(filename + length, sizeof(filename) - length, "_%s", symbol);
+        }
+        if (bucket) {
+            length += snprintf(filename + length, sizeof(filename) - length, "B%g", bucket);
+        }
+        snprintf(filename + length, sizeof(filename) - length, "N%lu.dat", pricesPerRound);
+        outputPath = filename;
+    }
+
+    FILE *file = error ? nullptr : fopen(outputPath, "wb");
+    if (!error && !file) {
+        printf("Error opening file %s\n", outputPath);
+        error = 1;
+    }
+
+    uint64_t totalRounds = 0;
+    if (!error) {
+        // the number of rounds of a bucketed file is only known at the end, so it is written last
+        totalRounds = ticks / pricesPerRound;
+        fwrite(&totalRounds, sizeof(totalRounds), 1, file);
+        fwrite(&pricesPerRound, sizeof(pricesPerRound), 1, file);
+
+        if (bucket) {
+            BucketWriter writer = {file, bucket, pricesPerRound, malloc(pricesPerRound * sizeof(double))};
+            uint8_t first = 1;
+            for (uint32_t c = 0; c < chunkCount; c++) {
+                for (uint64_t i = 0; i < chunks[c].count; i++) {
+                    addBucketTick(&writer, first, chunks[c].times[i], chunks[c].prices[i]);
+                    first = 0;
+                }
+            }
+            finishBucket(&writer);
+            free(writer.round);
+
+            totalRounds = writer.rounds;
+            fseek(file, 0, SEEK_SET);
+            fwrite(&totalRounds, sizeof(totalRounds), 1, file);
+        } else {
+            // the ticks after the last whole round are left out
+            uint64_t remaining = totalRounds * pricesPerRound;
+            for (uint32_t c = 0; c < chunkCount && remaining; c++) {
+                uint64_t count = chunks[c].count < remaining ? chunks[c].count : remaining;
+                fwrite(chunks[c].prices, sizeof(double), count, file);
+                remaining -= count;
+            }
+        }
+
+        if (fclose(file)) {
+            printf("Error writing file %s\n", outputPath);
+            error = 1;
+        } else {
+            printf("Imported %lu ticks into %lu rounds of %lu prices in %s\n", ticks, totalRounds, pricesPerRound,
+                   outputPath);
+        }
+    }
+
+    if (!error && statsFlag && writePriceStats(outputPath, threads)) {
+        printf("Error: Couldn't save the statistics of %s\n", outputPath);
+        error = 1;
+    }
+
+    for (uint32_t c = 0; c < chunkCount; c++) {
+        free(chunks[c].times);
+        free(chunks[c].prices);
+    }
+    free(chunks);
+    munmap((void *) text, fileSize);
+    return error;
+}
@@ -0,0 +1,322 @@
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <priceModel.h>
+#include <threadPool.h>
+
+// the prices of a chunk, enough for a task to be worth it, and few enough for the chunks to spread over the threads
+#define CHUNK_PRICES 65536
+// the prices whose samples are drawn and turned into prices together
+#define PRICE_BLOCK 4096
+
+uint8_t parsePriceModel(char *spec, PriceModel *model) {
+    if (!spec[0] || !strchr("ugebTamsc", spec[0])) {
+        return 1;
+    }
+    model->kind = spec[0];
+    model->parameter = 1;
+    model->randomize = 0;
+    model->reference = nullptr;
+
+    char *next = spec + 1;
+    if (*next == 'r') {
+        model->randomize = 1;
+        next++;
+    }
+    if (*next == '=') {
+        model->parameter = strtod(next + 1, &next);
+    }
+    if (*next != ',') {
+        return 1;
+    }
+    model->T = strtoull(next + 1, &next, 10);
+    if (*next != ',') {
+        return 1;
+    }
+    model->N = strtoull(next + 1, &next, 10);
+    if (*next == ',') {
+        model->seed = strtoull(next + 1, &next, 10);
+    }
+    if (*next || !model->T || !model->N) {
+        return 1;
+    }
+
+    // only the distributions have parameters that drift
+    if (strchr("amsc", model->kind)) {
+        model->randomize = 0;
+    }
+
+    return 0;
+}
+
+void getPriceModelName(PriceModel *model, char *name, size_t size) {
+    if (model->randomize) {
+        snprintf(name, size, "%crdataT%luN%lu", model->kind, model->T, model->N);
+    } else if (model->kind == 'a' || model->kind == 's' || model->kind == 'c') {
+        snprintf(name, size, "%cdataP%gT%luN%lu", model->kind, model->parameter, model->T, model->N);
+    } else {
+        snprintf(name, size, "%cdataT%luN%lu", model->kind, model->T, model->N);
+    }
+}
+
+static ModelParams initialParams(char kind) {
+    return (ModelParams) {0, 1, kind == 'e' ? 1 : 0, 1, 0.5};
+}
+
+// the parameters change after the last price of each round
+static void driftParams(char kind, ModelParams *params, Sampler *drift) {
+    if (kind == 'u') {
+        params->low += sampleNormal(drift);
+        params->high += sampleNormal(drift);
+        if (params->high < params->low) {
+            // if low is larger than high then switch the their values
+            double temp = params->low;
+            params->low = params->high;
+            params->high = temp;
+        }
+    } else if (kind == 'g') {
+        params->mean += sampleNormal(drift);
+        // make sure sigma is positive
+        params->sigma = fabs(params->sigma + sampleNormal(drift));
+    } else if (kind == 'e') {
+        params->mean += sampleNormal(drift);
+    } else if (kind == 'b') {
+        params->prob = sampleUniform(drift);
+    }
+}
+
+// phi^(size), multiplied the same way joinChunk does, so the carried end is the last price after the join
+static double chunkDecay(double phi, uint64_t size) {
+    double factor = phi;
+    for (uint64_t k = 1; k < size && fabs(factor) >= DBL_MIN; k++) {
+        factor *= phi;
+    }
+    return fabs(factor) >= DBL_MIN ? factor : 0;
+}
+
+uint8_t planPrices(PriceModel *model, PriceChunks *chunks) {
+    chunks->model = *model;
+    chunks->chunkRounds = model->N < CHUNK_PRICES ? CHUNK_PRICES / model->N : 1;
+    chunks->chunkCount = (model->T + chunks->chunkRounds - 1) / chunks->chunkRounds;
+    chunks->starts = nullptr;
+
+    // stream 0 of the seed draws the drift and the AR price before the first one, even for a reference model, so
+    // the starts of the chunks stay valid, the chunks draw their prices from the streams after it
+    Sampler drift;
+    initSamplerStream(&drift, model->seed, 0);
+    chunks->first = model->kind == 'a' ? sampleNormal(&drift) : 0;
+    chunks->decay = model->kind == 'a' ? chunkDecay(model->parameter, chunks->chunkRounds * model->N) : 0;
+    if (!model->randomize) {
+        return 0;
+    }
+
+    chunks->starts = malloc(chunks->chunkCount * sizeof(ChunkStart));
+    if (!chunks->starts) {
+        return 1;
+    }
+    ModelParams params = initialParams(model->kind);
+    for (uint32_t c = 0; c < chunks->chunkCount; c++) {
+        chunks->starts[c].params = params;
+        chunks->starts[c].drift = drift;
+
+        uint64_t start, size;
+        getChunkRange(chunks, c, &start, &size);
+        for (uint64_t round = 0; round < size / model->N; round++) {
+            driftParams(model->kind, &params, &drift);
+        }
+    }
+
+    return 0;
+}
+
+void freePriceChunks(PriceChunks *chunks) {
+    free(chunks->starts);
+    chunks->starts = nullptr;
+}
+
+void getChunkRange(PriceChunks *chunks, uint32_t c, uint64_t *start, uint64_t *size) {
+    uint64_t firstRound = c * chunks->chunkRounds;
+    uint64_t rounds = chunks->model.T - firstRound;
+    rounds = rounds < chunks->chunkRounds ? rounds : chunks->chunkRounds;
+    *start = firstRound * chunks->model.N;
+    *size = rounds * chunks->model.N;
+}
+
+void generateChunk(PriceChunks *chunks, uint32_t c, double *prices, ChunkEnd *end) {
+    PriceModel *model = &chunks->model;
+    uint64_t start, size;
+    getChunkRange(chunks, c, &start, &size);
+
+    Sampler sampler;
+    if (model->reference) {
+        initReferenceSampler(&sampler, model->reference);
+    } else {
+        initSamplerStream(&sampler, model->seed, c + 1);
+    }
+    // the drift is copied, so a chunk can be generated again
+    ChunkStart begin = {initialParams(model->kind)};
+    if (chunks->starts) {
+        begin = chunks->starts[c];
+    }
+    ModelParams *params = &begin.params;
+
+    double prev = c == 0 ? chunks->first : 0;
+    double prevNoise = 0;
+    // the cosine waves complete <parameter> cycles throughout all the rounds
+    double angularFreq = M_PI * model->parameter / (double) (model->T * model->N);
+
+    /* INFO: The prices of the chunk are generated a block at a time:
+     *
+     * --------------------------------------------------
+     * the sampler fills the block with the samples of the distribution, or with the noise of the model
+     * the samples are turned into prices, with the parameters of the round each one belongs to
+     * --------------------------------------------------
+     */
+    for (uint64_t blockStart = 0; blockStart < size; blockStart += PRICE_BLOCK) {
+        uint64_t blockSize = size - blockStart < PRICE_BLOCK ? size - blockStart : PRICE_BLOCK;
+        double *block = prices + blockStart;
+        if (model->kind == 'u' || model->kind == 'b') {
+            fillUniform(&sampler, block, blockSize);
+        } else if (model->kind == 'e') {
+            fillExponential(&sampler, block, blockSize);
+        } else if (model->kind != 'T') {
+            fillNormal(&sampler, block, blockSize);
+        }
+
+        for (uint64_t j = 0; j < blockSize; j++) {
+            uint64_t i = start + blockStart + j;
+            double *price = &block[j];
+            if (model->kind == 'u') {
+                *price = *price * (params->high - params->low) + params->low;
+            } else if (model->kind == 'g') {
+                *price = *price * params->sigma + params->mean;
+            } else if (model->kind == 'e') {
+                *price *= params->mean;
+            } else if (model->kind == 'b') {
+                *price = *price < params->prob;
+            } else if (model->kind == 'T') {
+                *price = (double) (i % 2);
+            } else if (model->kind == 'a') {
+                *price = prev * model->parameter + *price;
+                prev = *price;
+            } else if (model->kind == 'm') {
+                double noise = *price;
+                *price = noise + model->parameter * prevNoise;
+                prevNoise = noise;
+            } else if (model->kind == 's') {
+                *price = 5 * cos((double) i * angularFreq) + *price;
+            } else if (model->kind == 'c') {
+                *price = 5 * cbrt(cos((double) i * angularFreq)) + *price;
+            }
+
+            if (chunks->starts && (i + 1) % model->N == 0) {
+                driftParams(model->kind, params, &begin.drift);
+            }
+        }
+    }
+
+    end->last = prev;
+    end->lastNoise = prevNoise;
+}
+
+void joinChunk(PriceChunks *chunks, uint32_t c, double *prices, ChunkEnd *previous) {
+    PriceModel *model = &chunks->model;
+    if (!c) {
+        return;
+    }
+    uint64_t start, size;
+    getChunkRange(chunks, c, &start, &size);
+
+    if (model->kind == 'a') {
+        // the kth AR price misses phi^(k + 1) times the price before the chunk, which fades away as k grows, it stops
+        // once the factor is subnormal, whose multiplications are many times slower and add nothing to the prices
+        double factor = model->parameter;
+        for (uint64_t k = 0; k < size && fabs(factor) >= DBL_MIN; k++) {
+            prices[k] += factor * previous->last;
+            factor *= model->parameter;
+        }
+    } else if (model->kind == 'm') {
+        prices[0] += model->parameter * previous->lastNoise;
+    }
+}
+
+void carryChunkEnd(PriceChunks *chunks, uint32_t c, ChunkEnd *previous, ChunkEnd *end) {
+    if (!c || chunks->model.kind != 'a') {
+        return;
+    }
+    uint64_t start, size;
+    getChunkRange(chunks, c, &start, &size);
+    // only the last chunk can be shorter
+    double decay = size == chunks->chunkRounds * chunks->model.N ? chunks->decay
+                                                                 : chunkDecay(chunks->model.parameter, size);
+    end->last += decay * previous->last;
+}
+
+/**
+ * @typedef priceTaskStruct
+ * @brief What the tasks generating and joining the chunks share
+ *
+ */
+typedef struct priceTaskStruct {
+    PriceChunks *chunks;
+    double *data;
+    ChunkEnd *ends;
+} PriceTask;
+
+static void generateTask(void *arg, uint32_t c) {
+    PriceTask *task = arg;
+    uint64_t start, size;
+    getChunkRange(task->chunks, c, &start, &size);
+    generateChunk(task->chunks, c, task->data + start, &task->ends[c]);
+}
+
+static void joinTask(void *arg, uint32_t i) {
+    PriceTask *task = arg;
+    uint64_t start, size;
+    getChunkRange(task->chunks, i + 1, &start, &size);
+    joinChunk(task->chunks, i + 1, task->data + start, &task->ends[i]);
+}
+
+uint8_t generatePrices(PriceModel *model, double **data, uint32_t threads, const MemoryPolicy *policy) {
+    PriceChunks chunks;
+    if (planPrices(model, &chunks)) {
+        return 1;
+    }
+    // the generating threads are the first to write the chunks, so the pages aren't written by the workers before
+    MemoryPolicy placement = policy ? *policy : (MemoryPolicy) {0};
+    if (placement.placement == PLACE_WORKERS) {
+        placement.placement = PLACE_DEFAULT;
+    }
+    *data = allocMemory(&placement, model->T * model->N * sizeof(double), threads);
+    ChunkEnd *ends = malloc(chunks.chunkCount * sizeof(ChunkEnd));
+    if (!*data || !ends) {
+        freeMemory(*data);
+        free(ends);
+        freePriceChunks(&chunks);
+        return 1;
+    }
+
+    // every sample of a reference model comes from the same generator, so its chunks are generated in order
+    if (model->reference) {
+        threads = 1;
+    }
+    // each chunk is written by the thread that generates it, which places its pages near that thread
+    PriceTask task = {&chunks, *data, ends};
+    runTasks(chunks.chunkCount, threads, generateTask, &task);
+
+    // the ends are carried in order, which takes a multiplication per chunk, then the chunks are joined in parallel
+    if (model->kind == 'a' || model->kind == 'm') {
+        for (uint32_t c = 1; c < chunks.chunkCount; c++) {
+            carryChunkEnd(&chunks, c, &ends[c - 1], &ends[c]);
+        }
+        runTasks(chunks.chunkCount - 1, threads, joinTask, &task);
+    }
+
+    free(ends);
+    freePriceChunks(&chunks);
+    return 0;
+}
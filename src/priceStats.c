@@ -0,0 +1,469 @@
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gsl/gsl_sort.h>
+#include <gsl/gsl_statistics_double.h>
+#include <priceStats.h>
+#include <threadPool.h>
+#include <util.h>
+
+// the first bytes of every sidecar, "PBQS"
+#define PRICE_STATS_MAGIC 0x53514250u
+#define PRICE_STATS_VERSION 1u
+// the prices of a task of the global passes
+#define STATS_CHUNK_PRICES (1u << 20)
+// the buckets of the histogram of the global range
+#define HISTOGRAM_BUCKETS 65536
+
+/**
+ * @typedef statsHeaderStruct
+ * @brief The start of a sidecar file, followed by the global quantiles, the sorted first round, the mean of every
+ * round and the quantiles of every round
+ *
+ */
+typedef struct statsHeaderStruct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t T;
+    uint64_t N;
+    uint32_t roundQuantiles;
+    uint32_t globalQuantiles;
+    // the price file the statistics are of, when they were saved
+    uint64_t fileSize;
+    int64_t fileModified;
+    double min;
+    double max;
+    double mean;
+    double lowerMedian;
+    double upperMedian;
+} StatsHeader;
+
+/**
+ * @typedef statsTaskStruct
+ * @brief What the tasks of the passes over the prices share, and the partial results of every task
+ *
+ */
+typedef struct statsTaskStruct {
+    double *data;
+    PriceStats *stats;
+    uint64_t chunkRounds;
+    uint64_t size;
+    // the min, max and sum of the prices of every task of the first pass, combined in order afterwards
+    double *taskMin;
+    double *taskMax;
+    double *taskSum;
+    // the histogram every task of the second pass adds its counts to
+    uint64_t *histogram;
+    double scale;
+    // the buckets whose prices the third pass collects, in an array per task
+    uint32_t firstBucket;
+    uint32_t lastBucket;
+    double **collected;
+    uint64_t *collectedCount;
+    uint8_t outOfMemory;
+} StatsTask;
+
+static uint32_t bucketOf(StatsTask *task, double price) {
+    double bucket = (price - task->stats->min) * task->scale;
+    return bucket < HISTOGRAM_BUCKETS - 1 ? (uint32_t) bucket : HISTOGRAM_BUCKETS - 1;
+}
+
+static void roundTask(void *arg, uint32_t c) {
+    StatsTask *task = arg;
+    PriceStats *stats = task->stats;
+    uint64_t first = c * task->chunkRounds;
+    uint64_t last = first + task->chunkRounds < stats->T ? first + task->chunkRounds : stats->T;
+
+    double *sorted = malloc(stats->N * sizeof(double));
+    if (!sorted) {
+        task->outOfMemory = 1;
+        return;
+    }
+    double min = INFINITY, max = -INFINITY, sum = 0;
+    for (uint64_t t = first; t < last; t++) {
+        memcpy(sorted, task->data + t * stats->N, stats->N * sizeof(double));
+        gsl_sort(sorted, 1, stats->N);
+        if (t == 0) {
+            memcpy(stats->sortedFirstRound, sorted, stats->N * sizeof(double));
+        }
+
+        double roundSum = 0;
+        for (uint64_t n = 0; n < stats->N; n++) {
+            roundSum += sorted[n];
+        }
+        stats->roundMeans[t] = roundSum / stats->N;
+        for (uint32_t q = 0; q < ROUND_QUANTILES; q++) {
+            stats->roundQuantiles[t * ROUND_QUANTILES + q] =
+                    gsl_stats_quantile_from_sorted_data(sorted, 1, stats->N, (double) q / (ROUND_QUANTILES - 1));
+        }
+        min = fmin(min, sorted[0]);
+        max = fmax(max, sorted[stats->N - 1]);
+        sum += roundSum;
+    }
+    free(sorted);
+
+    task->taskMin[c] = min;
+    task->taskMax[c] = max;
+    task->taskSum[c] = sum;
+}
+
+static void histogramTask(void *arg, uint32_t c) {
+    StatsTask *task = arg;
+    uint64_t start = (uint64_t) c * STATS_CHUNK_PRICES;
+    uint64_t end = start + STATS_CHUNK_PRICES < task->size ? start + STATS_CHUNK_PRICES : task->size;
+
+    uint64_t *counts = calloc(HISTOGRAM_BUCKETS, sizeof(uint64_t));
+    if (!counts) {
+        task->outOfMemory = 1;
+        return;
+    }
+    for (uint64_t i = start; i < end; i++) {
+        counts[bucketOf(task, task->data[i])]++;
+    }
+    // the counts are integers, so the order the tasks add them in doesn't matter
+    for (uint32_t bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+        if (counts[bucket]) {
+            __atomic_fetch_add(&task->histogram[bucket], counts[bucket], __ATOMIC_RELAXED);
+        }
+    }
+    free(counts);
+}
+
+static void collectTask(void *arg, uint32_t c) {
+    StatsTask *task = arg;
+    uint64_t start = (uint64_t) c * STATS_CHUNK_PRICES;
+    uint64_t end = start + STATS_CHUNK_PRICES < task->size ? start + STATS_CHUNK_PRICES : task->size;
+
+    uint64_t count = 0, capacity = 0;
+    double *collected = nullptr;
+    for (uint64_t i = start; i < end; i++) {
+        uint32_t bucket = bucketOf(task, task->data[i]);
+        if (bucket < task->firstBucket || bucket > task->lastBucket) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? 2 * capacity : 1024;
+            double *grown = realloc(collected, capacity * sizeof(double));
+            if (!grown) {
+                task->outOfMemory = 1;
+                break;
+            }
+            collected = grown;
+        }
+        collected[count++] = task->data[i];
+    }
+    task->collected[c] = collected;
+    task->collectedCount[c] = count;
+}
+
+// the bucket of the price of a rank, and how many prices are in the buckets before it
+static uint32_t bucketOfRank(uint64_t *histogram, uint64_t rank, uint64_t *below) {
+    uint64_t count = 0;
+    uint32_t bucket = 0;
+    while (count + histogram[bucket] <= rank) {
+        count += histogram[bucket++];
+    }
+    *below = count;
+    return bucket;
+}
+
+// the exact median, from the prices in the buckets of the two middle ranks
+static uint8_t findMedian(StatsTask *task, uint32_t taskCount, uint32_t threads) {
+    PriceStats *stats = task->stats;
+    uint64_t lowerRank = (task->size - 1) / 2;
+    uint64_t upperRank = task->size / 2;
+    uint64_t below, upperBelow;
+    task->firstBucket = bucketOfRank(task->histogram, lowerRank, &below);
+    task->lastBucket = bucketOfRank(task->histogram, upperRank, &upperBelow);
+
+    task->collected = calloc(taskCount, sizeof(double *));
+    task->collectedCount = calloc(taskCount, sizeof(uint64_t));
+    if (!task->collected || !task->collectedCount) {
+        free(task->collected);
+        free(task->collectedCount);
+        return 1;
+    }
+    runTasks(taskCount, threads, collectTask, task);
+
+    uint64_t total = 0;
+    for (uint32_t c = 0; c < taskCount; c++) {
+        total += task->collectedCount[c];
+    }
+    double *prices = task->outOfMemory ? nullptr : malloc(total * sizeof(double));
+    uint8_t error = !prices;
+    if (prices) {
+        uint64_t offset = 0;
+        for (uint32_t c = 0; c < taskCount; c++) {
+            if (task->collectedCount[c]) {
+                memcpy(prices + offset, task->collected[c], task->collectedCount[c] * sizeof(double));
+            }
+            offset += task->collectedCount[c];
+        }
+
+        // a bucket of a single repeated price, like the ones of a Bernoulli model, doesn't need sorting
+        double min, max;
+        gsl_stats_minmax(&min, &max, prices, 1, total);
+        if (min != max) {
+            gsl_sort(prices, 1, total);
+        }
+        stats->lowerMedian = prices[lowerRank - below];
+        stats->upperMedian = prices[upperRank - below];
+        free(prices);
+    }
+
+    for (uint32_t c = 0; c < taskCount; c++) {
+        free(task->collected[c]);
+    }
+    free(task->collected);
+    free(task->collectedCount);
+    return error;
+}
+
+// the global quantiles, each placed linearly by its rank inside its bucket
+static void sketchQuantiles(StatsTask *task) {
+    PriceStats *stats = task->stats;
+    double width = (stats->max - stats->min) / HISTOGRAM_BUCKETS;
+    uint64_t below = 0;
+    uint32_t bucket = 0;
+    for (uint32_t q = 0; q < GLOBAL_QUANTILES; q++) {
+        double rank = (double) q / (GLOBAL_QUANTILES - 1) * (task->size - 1);
+        while (bucket < HISTOGRAM_BUCKETS - 1 && below + task->histogram[bucket] <= rank) {
+            below += task->histogram[bucket++];
+        }
+        double inBucket = task->histogram[bucket] ? (rank - below) / task->histogram[bucket] : 0;
+        double quantile = stats->min + (bucket + inBucket) * width;
+        stats->globalQuantiles[q] = fmin(fmax(quantile, stats->min), stats->max);
+    }
+    stats->globalQuantiles[0] = stats->min;
+    stats->globalQuantiles[GLOBAL_QUANTILES - 1] = stats->max;
+}
+
+uint8_t computePriceStats(double *data, uint64_t T, uint64_t N, uint32_t threads, PriceStats *stats) {
+    stats->T = T;
+    stats->N = N;
+    stats->map = nullptr;
+    stats->globalQuantiles = malloc(GLOBAL_QUANTILES * sizeof(double));
+    stats->sortedFirstRound = malloc(N * sizeof(double));
+    stats->roundMeans = malloc(T * sizeof(double));
+    stats->roundQuantiles = malloc(T * ROUND_QUANTILES * sizeof(double));
+
+    StatsTask task = {data, stats};
+    task.chunkRounds = N < STATS_CHUNK_PRICES ? STATS_CHUNK_PRICES / N : 1;
+    task.size = T * N;
+    uint32_t roundTasks = (T + task.chunkRounds - 1) / task.chunkRounds;
+    uint32_t priceTasks = (task.size + STATS_CHUNK_PRICES - 1) / STATS_CHUNK_PRICES;
+    task.taskMin = malloc(roundTasks * sizeof(double));
+    task.taskMax = malloc(roundTasks * sizeof(double));
+    task.taskSum = malloc(roundTasks * sizeof(double));
+    task.histogram = calloc(HISTOGRAM_BUCKETS, sizeof(uint64_t));
+
+    uint8_t error = !stats->globalQuantiles || !stats->sortedFirstRound || !stats->roundMeans ||
+                    !stats->roundQuantiles || !task.taskMin || !task.taskMax || !task.taskSum || !task.histogram;
+    if (!error) {
+        runTasks(roundTasks, threads, roundTask, &task);
+        error = task.outOfMemory;
+    }
+
+    if (!error) {
+        stats->min = INFINITY;
+        stats->max = -INFINITY;
+        double sum = 0;
+        for (uint32_t c = 0; c < roundTasks; c++) {
+            stats->min = fmin(stats->min, task.taskMin[c]);
+            stats->max = fmax(stats->max, task.taskMax[c]);
+            sum += task.taskSum[c];
+        }
+        stats->mean = sum / task.size;
+
+        if (stats->min == stats->max) {
+            stats->lowerMedian = stats->min;
+            stats->upperMedian = stats->min;
+            for (uint32_t q = 0; q < GLOBAL_QUANTILES; q++) {
+                stats->globalQuantiles[q] = stats->min;
+            }
+        } else {
+            task.scale = HISTOGRAM_BUCKETS / (stats->max - stats->min);
+            runTasks(priceTasks, threads, histogramTask, &task);
+            error = task.outOfMemory || findMedian(&task, priceTasks, threads);
+            sketchQuantiles(&task);
+        }
+    }
+
+    free(task.taskMin);
+    free(task.taskMax);
+    free(task.taskSum);
+    free(task.histogram);
+    if (error) {
+        freePriceStats(stats);
+    }
+    return error;
+}
+
+void getPriceStatsPath(char *filepath, char *statsPath, size_t size) {
+    size_t length = strlen(filepath);
+    if (length >= 4 && !strcmp(filepath + length - 4, ".dat")) {
+        length -= 4;
+    }
+    snprintf(statsPath, size, "%.*s.stats", (int) length, filepath);
+}
+
+// the size and modification time of the price file, which a sidecar has to match
+static uint8_t statPriceFile(char *filepath, uint64_t *size, int64_t *modified) {
+    struct stat fileStat;
+    if (stat(filepath, &fileStat)) {
+        return 1;
+    }
+    *size = fileStat.st_size;
+    *modified = (int64_t) fileStat.st_mtim.tv_sec * 1000000000 + fileStat.st_mtim.tv_nsec;
+    return 0;
+}
+
+uint8_t savePriceStats(PriceStats *stats, char *filepath) {
+    StatsHeader header = {PRICE_STATS_MAGIC, PRICE_STATS_VERSION, stats->T, stats->N, ROUND_QUANTILES,
+                          GLOBAL_QUANTILES};
+    if (statPriceFile(filepath, &header.fileSize, &header.fileModified)) {
+        return 1;
+    }
+    header.min = stats->min;
+    header.max = stats->max;
+    header.mean = stats->mean;
+    header.lowerMedian = stats->lowerMedian;
+    header.upperMedian = stats->upperMedian;
+
+    char statsPath[512];
+    getPriceStatsPath(filepath, statsPath, sizeof(statsPath));
+    FILE *file = fopen(statsPath, "wb");
+    if (!file) {
+        return 1;
+    }
+    uint8_t error = fwrite(&header, sizeof(header), 1, file) != 1;
+    error |= fwrite(stats->globalQuantiles, sizeof(double), GLOBAL_QUANTILES, file) != GLOBAL_QUANTILES;
+    error |= fwrite(stats->sortedFirstRound, sizeof(double), stats->N, file) != stats->N;
+    error |= fwrite(stats->roundMeans, sizeof(double), stats->T, file) != stats->T;
+    error |= fwrite(stats->roundQuantiles, sizeof(double), stats->T * ROUND_QUANTILES, file) !=
+             stats->T * ROUND_QUANTILES;
+    error |= fclose(file) != 0;
+    return error;
+}
+
+uint8_t loadPriceStats(PriceStats *stats, char *filepath) {
+    stats->map = nullptr;
+
+    char statsPath[512];
+    getPriceStatsPath(filepath, statsPath, sizeof(statsPath));
+    int fd = open(statsPath, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t) sizeof(StatsHeader)) {
+        close(fd);
+        return 1;
+    }
+    uint8_t *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 1;
+    }
+
+    // the sidecar has to be complete, and of the price file as it is now
+    StatsHeader *header = (StatsHeader *) map;
+    uint64_t fileSize;
+    int64_t fileModified;
+    uint8_t valid = header->magic == PRICE_STATS_MAGIC && header->version == PRICE_STATS_VERSION &&
+                    header->roundQuantiles == ROUND_QUANTILES && header->globalQuantiles == GLOBAL_QUANTILES &&
+                    sizeof(StatsHeader) + (GLOBAL_QUANTILES + header->N + header->T * (1 + ROUND_QUANTILES)) *
+                                                  sizeof(double) == (uint64_t) size &&
+                    !statPriceFile(filepath, &fileSize, &fileModified) && fileSize == header->fileSize &&
+                    fileModified == header->fileModified;
+    if (!valid) {
+        munmap(map, size);
+        return 1;
+    }
+
+    stats->T = header->T;
+    stats->N = header->N;
+    stats->min = header->min;
+    stats->max = header->max;
+    stats->mean = header->mean;
+    stats->lowerMedian = header->lowerMedian;
+    stats->upperMedian = header->upperMedian;
+    stats->globalQuantiles = (double *) (map + sizeof(StatsHeader));
+    stats->sortedFirstRound = stats->globalQuantiles + GLOBAL_QUANTILES;
+    stats->roundMeans = stats->sortedFirstRound + stats->N;
+    stats->roundQuantiles = stats->roundMeans + stats->T;
+    stats->map = map;
+    stats->mapSize = size;
+    return 0;
+}
+
+void freePriceStats(PriceStats *stats) {
+    if (stats->map) {
+        munmap(stats->map, stats->mapSize);
+        stats->map = nullptr;
+    } else {
+        free(stats->globalQuantiles);
+        free(stats->sortedFirstRound);
+        free(stats->roundMeans);
+        free(stats->roundQuantiles);
+    }
+    stats->globalQuantiles = nullptr;
+    stats->sortedFirstRound = nullptr;
+    stats->roundMeans = nullptr;
+    stats->roundQuantiles = nullptr;
+}
+
+uint8_t writePriceStats(char *filepath, uint32_t threads) {
+    double *data;
+    uint64_t T, N;
+    if (loadPrices(filepath, &data, &T, &N, nullptr, threads)) {
+        return 1;
+    }
+
+    PriceStats stats;
+    uint8_t error = computePriceStats(data, T, N, threads, &stats);
+    freeMemory(data);
+    if (!error) {
+        error = savePriceStats(&stats, filepath);
+        freePriceStats(&stats);
+    }
+    return error;
+}
+
+// the value at position x of values spaced evenly over [0,1], interpolated linearly
+static double interpolate(double *values, uint32_t count, double x) {
+    double position = fmin(fmax(x, 0), 1) * (count - 1);
+    uint32_t i = (uint32_t) position;
+    if (i >= count - 1) {
+        return values[count - 1];
+    }
+    double delta = position - i;
+    return (1 - delta) * values[i] + delta * values[i + 1];
+}
+
+double getRoundQuantile(PriceStats *stats, uint64_t round, double q) {
+    return interpolate(stats->roundQuantiles + round * ROUND_QUANTILES, ROUND_QUANTILES, q);
+}
+
+double getGlobalQuantile(PriceStats *stats, double q) {
+    return interpolate(stats->globalQuantiles, GLOBAL_QUANTILES, q);
+}
+
+void getNormalizedFirstRound(PriceStats *stats, double min, double max, double *sorted) {
+    memcpy(sorted, stats->sortedFirstRound, stats->N * sizeof(double));
+    normalizePrices(min, max, sorted, stats->N);
+}
+
+double getNormalizedMedian(PriceStats *stats, double min, double max) {
+    double middle[2] = {stats->lowerMedian, stats->upperMedian};
+    normalizePrices(min, max, middle, 2);
+    // the mean of the two middle prices, as GSL takes it
+    return (stats->T * stats->N) % 2 ? middle[0] : (middle[0] + middle[1]) / 2;
+}
@@ -1,17 +1,32 @@
 #include <getopt.h>
-#include <gsl/gsl_statistics_double.h>
-#include <math.h>
+#include <gsl/gsl_rng.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 #include <banditAlgs.h>
+#include <checkpoint.h>
+#include <engine.h>
+#include <metrics.h>
+#include <output.h>
+#include <plot.h>
+#include <priceModel.h>
+#include <priceStats.h>
+#include <replications.h>
+#include <reporter.h>
+#include <resultStore.h>
+#include <sweep.h>
+#include <timing.h>
 #include <util.h>
 
 void printHelp() {
     printf("Usage:\n"
            "    propheticBandits [options] [-t <integer>] "
            "<file>\n"
+           "    propheticBandits [options] [-t <integer>] --model <model>\n"
            "    propheticBandits -h      # Display this help screen.\n\n"
            "Options:\n"
            "    -t <integer>    Set the number of thresholds (default = 10).\n"
@@ -19,9 +34,58 @@ void printHelp() {
            "    -p              Plot more statistics.\n"
            "    -d              Use two thresholds.\n"
            "    -D              Use dynamic threshold values.\n"
+           "    --rolling <integer>\n"
+           "                    Use dynamic threshold values that follow the prices, the\n"
+           "                    quantiles of the <integer> rounds before each round.\n"
            "    -o              Use median algorithm as OPT.\n"
            "    -O              Use best hand as OPT.\n"
-           "    -k              Keep items between rounds.\n\n"
+           "    -k              Keep items between rounds.\n"
+           "    -j <integer>    Run each algorithm on its own thread, using up to <integer>\n"
+           "                    worker threads (0 = one per cpu).\n"
+           "    -R <integer>    Also run each stochastic algorithm <integer> times with\n"
+           "                    different seeds, and save the mean and variance of the runs.\n"
+           "    -w <name>=<values>\n"
+           "                    Sweep K, ucb2Alpha, eGreedyScale, exp3UpperBound, swUcbWindow\n"
+           "                    or dUcbDiscount over comma separated values, e.g. K=5,10,20,\n"
+           "                    each combination on the -j threads, and save the results of\n"
+           "                    each in its own directory instead of plotting them.\n"
+           "    --checkpoint <integer>\n"
+           "                    Save the progress of the algorithms every <integer> rounds.\n"
+           "    --resume        Continue the checkpointed run with the same options, also\n"
+           "                    playing any rounds appended to the file since.\n"
+           "    --decimate <integer>\n"
+           "                    Only save every <integer>th round in the result store.\n"
+           "    --export <file> Write the columns of the result store <file> as text files\n"
+           "                    next to it, and exit.\n"
+           "    --stats-json <file>\n"
+           "                    Time each phase of the run and each algorithm, print their\n"
+           "                    throughput and save it in <file> as JSON.\n"
+           "    --model <kind>[r][=<parameter>],<rounds>,<prices per round>[,<seed>]\n"
+           "                    Generate the prices in memory from a model of priceGenerator,\n"
+           "                    instead of reading a file, with up to -j threads. The kind\n"
+           "                    and r are its options, e.g. a=0.9,1000,20 for -a 0.9 -t 1000\n"
+           "                    -n 20, and the seed is the time if it is left out.\n"
+           "    --price-stats   Calculate the statistics of the prices in parallel and save\n"
+           "                    them next to the file, if they aren't there already. The\n"
+           "                    range, the median and the first round of -D are read from\n"
+           "                    them instead of from the prices, whenever they are there.\n"
+           "    --seed <integer>\n"
+           "                    Seed the stochastic algorithms with <integer> instead of the\n"
+           "                    time, replication i with <integer> + i.\n"
+           "    --memory <policy>\n"
+           "                    Place the prices and the results in memory with <policy>,\n"
+           "                    its parts joined by +: thp or hugetlb huge pages,\n"
+           "                    interleave over the NUMA nodes or workers to have the -j\n"
+           "                    workers write them first, and prefetch to prefetch the\n"
+           "                    next round (default = default, none of them).\n"
+           "    --batch <integer>\n"
+           "                    Have UCB1, EXP3, Epsilon Greedy and Successive Elimination\n"
+           "                    pick the arms of <integer> rounds at once and learn from them\n"
+           "                    afterwards, playing the rounds of each batch on the -j\n"
+           "                    threads. The other algorithms play round by round.\n"
+           "    --profile       Also count the cycles, instructions, branch misses and last\n"
+           "                    level cache misses of each phase and algorithm with the\n"
+           "                    hardware counters, and print them with the times.\n\n"
            "    -a              Run all the available algorithms.\n"
            "    -m              Run the Median algorithm.\n"
            "    -g              Run the Greedy algorithm.\n"
@@ -29,23 +93,97 @@ void printHelp() {
            "    -s              Run the Successive Elimination algorithm.\n"
            "    -u              Run the UCB1 algorithm.\n"
            "    -U              Run the UCB2 algorithm.\n"
-           "    -x              Run the EXP3 algorithm.\n");
+           "    -x              Run the EXP3 algorithm.\n"
+           "    -z              Run the HOO algorithm, which picks thresholds anywhere in\n"
+           "                    [0,1] instead of from the K fixed ones.\n"
+           "    -l              Run the Sliding Window UCB algorithm.\n"
+           "    -c              Run the Discounted UCB algorithm.\n");
 }
 
+// prints the timings of the run, and saves them in statsPath if it is given
+static void finishTimings(Timings *timings, char *statsPath, char *filepath, Bandit b, Reporter *reporter) {
+    if (!timings)
+        return;
+
+    printf("\n");
+    reportTimings(timings, reporter);
+    if (statsPath && saveTimings(statsPath, filepath, b, timings)) {
+        printf("Error: Couldn't save the timings in %s\n", statsPath);
+    }
+    stopProfiling(timings);
+}
+
+// the options that only have a long name
+enum longOption {
+    OPT_CHECKPOINT = 256,
+    OPT_RESUME,
+    OPT_DECIMATE,
+    OPT_EXPORT,
+    OPT_STATS_JSON,
+    OPT_PROFILE,
+    OPT_MODEL,
+    OPT_PRICE_STATS,
+    OPT_ROLLING,
+    OPT_MEMORY,
+    OPT_SEED,
+    OPT_BATCH
+};
+
 int main(int argc, char **argv) {
     if (argc == 1) {
         printHelp();
         return 0;
     }
 
-    Bandit b = {0, 0, 10, 10, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    Bandit b = {.T = 0,
+                .N = 0,
+                .K = 10,
+                .thresholds = 10,
+                .ucb2Alpha = DEFAULT_UCB2_ALPHA,
+                .eGreedyScale = DEFAULT_EGREEDY_SCALE};
     uint8_t plot = 1;
     uint8_t morePlot = 0;
+    uint8_t concurrent = 0;
+    uint32_t threads = 0;
+    uint32_t replications = 0;
+    uint8_t sweeping = 0;
+    Sweep sweep = {0};
+    uint8_t checkpointing = 0;
+    Checkpoint checkpoint = {0};
+    uint64_t decimation = 1;
+    // only set with --stats-json, every phase is timed into it
+    Timings runTimings = {0};
+    Timings *timings = nullptr;
+    char *statsPath = nullptr;
+    uint8_t profiling = 0;
+    // only set with --model, the prices are generated from it instead of read from a file
+    uint8_t modelling = 0;
+    PriceModel model = {0};
+    uint8_t computingStats = 0;
+    // only set with --seed, the time seeds the algorithms otherwise
+    uint8_t seeded = 0;
+    uint64_t seed = 0;
+
+    struct option longOptions[] = {
+            {"checkpoint", required_argument, nullptr, OPT_CHECKPOINT},
+            {"resume", no_argument, nullptr, OPT_RESUME},
+            {"decimate", required_argument, nullptr, OPT_DECIMATE},
+            {"export", required_argument, nullptr, OPT_EXPORT},
+            {"stats-json", required_argument, nullptr, OPT_STATS_JSON},
+            {"profile", no_argument, nullptr, OPT_PROFILE},
+            {"model", required_argument, nullptr, OPT_MODEL},
+            {"price-stats", no_argument, nullptr, OPT_PRICE_STATS},
+            {"rolling", required_argument, nullptr, OPT_ROLLING},
+            {"memory", required_argument, nullptr, OPT_MEMORY},
+            {"seed", required_argument, nullptr, OPT_SEED},
+            {"batch", required_argument, nullptr, OPT_BATCH},
+            {nullptr, 0, nullptr, 0},
+    };
 
     int opt;
     opterr = 0;
 
-    while ((opt = getopt(argc, argv, ":h:npkdDoOamgesuUxt:")) != -1) {
+    while ((opt = getopt_long(argc, argv, ":h:npkdDoOamgesuUxzlct:j:R:w:", longOptions, nullptr)) != -1) {
         switch (opt) {
             case 'h':
                 printHelp();
@@ -54,6 +192,89 @@ int main(int argc, char **argv) {
                 b.K = atoi(optarg);
                 b.thresholds = b.K;
                 break;
+            case 'j':
+                concurrent = 1;
+                threads = atoi(optarg);
+                break;
+            case 'R':
+                replications = atoi(optarg);
+                break;
+            case 'w':
+                if (addSweepParam(&sweep, optarg)) {
+                    freeSweep(&sweep);
+                    return 1;
+                }
+                sweeping = 1;
+                break;
+            case OPT_CHECKPOINT:
+                checkpointing = 1;
+                checkpoint.interval = strtoull(optarg, nullptr, 10);
+                if (!checkpoint.interval) {
+                    printf("Error: The checkpoint interval has to be at least 1 round\n");
+                    return 1;
+                }
+                break;
+            case OPT_RESUME:
+                checkpointing = 1;
+                checkpoint.resume = 1;
+                break;
+            case OPT_DECIMATE:
+                decimation = strtoull(optarg, nullptr, 10);
+                if (!decimation) {
+                    printf("Error: The decimation has to be at least 1 round\n");
+                    return 1;
+                }
+                break;
+            case OPT_EXPORT:
+                // the text files are written from a saved result store, without running anything
+                if (exportResultStore(optarg)) {
+                    printf("Error: Couldn't export the result store %s\n", optarg);
+                    return 1;
+                }
+                return 0;
+            case OPT_STATS_JSON:
+                statsPath = optarg;
+                timings = &runTimings;
+                break;
+            case OPT_PROFILE:
+                profiling = 1;
+                break;
+            case OPT_MODEL:
+                model.seed = time(nullptr);
+                if (parsePriceModel(optarg, &model)) {
+                    printf("Error: Invalid model %s\n", optarg);
+                    return 1;
+                }
+                modelling = 1;
+                break;
+            case OPT_PRICE_STATS:
+                computingStats = 1;
+                break;
+            case OPT_ROLLING:
+                b.dynamicThres = 1;
+                b.rollingRounds = strtoull(optarg, nullptr, 10);
+                if (!b.rollingRounds) {
+                    printf("Error: The rolling window has to be at least 1 round\n");
+                    return 1;
+                }
+                break;
+            case OPT_MEMORY:
+                if (parseMemoryPolicy(optarg, &b.memory)) {
+                    printf("Error: Invalid memory policy %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_SEED:
+                seeded = 1;
+                seed = strtoull(optarg, nullptr, 10);
+                break;
+            case OPT_BATCH:
+                b.batch = strtoull(optarg, nullptr, 10);
+                if (!b.batch) {
+                    printf("Error: A batch has to be at least 1 round\n");
+                    return 1;
+                }
+                break;
             case 'n':
                 plot = 0;
                 break;
@@ -79,37 +300,42 @@ int main(int argc, char **argv) {
                 b.keepItems = 0;
                 break;
             case 'a':
-                b.median = 1;
-                b.greedy = 1;
-                b.eGreedy = 1;
-                b.succElim = 1;
-                b.ucb1 = 1;
-                b.ucb2 = 1;
-                b.exp3 = 1;
+                for (uint32_t id = 0; id < ALG_COUNT; id++) {
+                    b.algs[id] = 1;
+                }
                 break;
             case 'm':
-                b.median = 1;
+                b.algs[ALG_MEDIAN] = 1;
                 break;
             case 'g':
-                b.greedy = 1;
+                b.algs[ALG_GREEDY] = 1;
                 break;
             case 'e':
-                b.eGreedy = 1;
+                b.algs[ALG_EGREEDY] = 1;
                 break;
             case 's':
-                b.succElim = 1;
+                b.algs[ALG_SUCCELIM] = 1;
                 break;
             case 'u':
-                b.ucb1 = 1;
+                b.algs[ALG_UCB1] = 1;
                 break;
             case 'U':
-                b.ucb2 = 1;
+                b.algs[ALG_UCB2] = 1;
                 break;
             case 'x':
-                b.exp3 = 1;
+                b.algs[ALG_EXP3] = 1;
+                break;
+            case 'z':
+                b.algs[ALG_HOO] = 1;
+                break;
+            case 'l':
+                b.algs[ALG_SWUCB] = 1;
+                break;
+            case 'c':
+                b.algs[ALG_DUCB] = 1;
                 break;
             case '?':
-                if (optopt == 't')
+                if (optopt == 't' || optopt == 'j' || optopt == 'R' || optopt == 'w')
                     fprintf(stderr, "Option -%c requires an argument.\n", optopt);
                 break;
             default:
@@ -128,44 +354,54 @@ int main(int argc, char **argv) {
     double *data;
     uint64_t totalRounds, pricesPerRound;
     char *filepath;
-    // opens binary data file
-    if (optind < argc) {
+    char modelPath[256];
+    if (modelling) {
+        // the results go where they would for the file priceGenerator writes for the same model
+        char name[192];
+        getPriceModelName(&model, name, sizeof(name));
+        snprintf(modelPath, sizeof(modelPath), "prophetData/%s.dat", name);
+        filepath = modelPath;
+    } else if (optind >= argc) {
+        printf("Error: No filename provided\n");
+        return 1;
+    } else {
         // small hack to get first non-option argument because getopt is a pain
         filepath = argv[optind];
-        FILE *file = fopen(filepath, "rb");
-        if (!file) {
-            printf("Error opening file\n");
-            return 1;
-        }
-
-        printf("Importing file...\n");
+    }
 
-        // first 2 values are 64bit integers
-        if (!fread(&totalRounds, sizeof(uint64_t), 1, file)) {
-            printf("Error while importing file");
-            return 1;
-        }
-        if (!fread(&pricesPerRound, sizeof(uint64_t), 1, file)) {
-            printf("Error while importing file");
-            return 1;
-        }
+    Reporter printer = {writeToStream, stdout};
+    // the counters are opened before the first phase, so every thread started afterwards is counted too
+    if (profiling) {
+        timings = &runTimings;
+        startProfiling(timings, &printer);
+    }
 
-        if (pricesPerRound <= 2) {
-            printf("Error: Program does not support 2 prices per round\n");
+    PhaseMark runStart = startPhase(timings);
+    PhaseMark phaseStart = runStart;
+    if (modelling) {
+        printf("Generating prices...\n");
+        if (generatePrices(&model, &data, threads, &b.memory)) {
+            printf("Error: Not enough memory for the prices\n");
             return 1;
         }
-
-        // allocate memory and get the actual data
-        data = malloc(totalRounds * pricesPerRound * sizeof(double));
-        if (!fread(data, sizeof(double), totalRounds * pricesPerRound, file)) {
-            printf("Error while importing file");
-            free(data);
+        totalRounds = model.T;
+        pricesPerRound = model.N;
+        endPhase(timings, "generate", phaseStart, totalRounds, totalRounds * pricesPerRound,
+                 totalRounds * pricesPerRound * sizeof(double));
+    } else {
+        printf("Importing file...\n");
+        if (loadPrices(filepath, &data, &totalRounds, &pricesPerRound, &b.memory, threads)) {
+            printf("Error while importing file\n");
             return 1;
         }
+        struct stat fileStat;
+        uint64_t fileSize = stat(filepath, &fileStat) ? 0 : (uint64_t) fileStat.st_size;
+        endPhase(timings, "import", phaseStart, totalRounds, totalRounds * pricesPerRound, fileSize);
+    }
 
-        fclose(file);
-    } else {
-        printf("Error: No filename provided\n");
+    if (pricesPerRound <= 2) {
+        printf("Error: Program does not support 2 prices per round\n");
+        freeMemory(data);
         return 1;
     }
 
@@ -179,318 +415,309 @@ int main(int argc, char **argv) {
     }
 
     if (b.medianOpt) {
-        b.median = 0;
+        b.algs[ALG_MEDIAN] = 0;
     }
 
-    if ((b.dualThres && b.K <= 2) || b.K < 1) {
+    // the points of a sweep check their own number of thresholds
+    if (!sweeping && ((b.dualThres && b.K <= 2) || b.K < 1)) {
         printf("Error: Too few thresholds\n");
-        free(data);
+        freeMemory(data);
         return 1;
-    } else if (b.K > b.T) {
+    } else if (!sweeping && b.K > b.T) {
         printf("Error: Too many thresholds\n");
-        free(data);
+        freeMemory(data);
         return 1;
     }
 
-    if (b.N < b.thresholds) {
+    if (b.N < b.thresholds && !sweeping) {
         b.dynamicThres = 0;
     }
 
+    // read GSL_RNG_TYPE and GSL_RNG_SEED once, before any algorithm allocates a generator
+    gsl_rng_env_setup();
+    b.seed = seeded ? seed : (uint64_t) time(nullptr);
+
+    // the statistics of the prices come from the sidecar of the file when it is up to date, or with --price-stats
+    // are calculated, and saved in it unless the prices were generated
+    uint64_t dataBytes = b.T * b.N * sizeof(double);
+    PriceStats priceStats = {0};
+    uint8_t haveStats = !modelling && !loadPriceStats(&priceStats, filepath);
+    if (!haveStats && computingStats) {
+        printf("Calculating price statistics...\n");
+        phaseStart = startPhase(timings);
+        haveStats = !computePriceStats(data, b.T, b.N, threads, &priceStats);
+        if (!haveStats) {
+            printf("Error: Not enough memory for the price statistics\n");
+        } else if (!modelling && savePriceStats(&priceStats, filepath)) {
+            printf("Error: Couldn't save the price statistics next to %s\n", filepath);
+        }
+        endPhase(timings, "priceStats", phaseStart, b.T, b.T * b.N, dataBytes);
+    }
+
+    // the prices are read once more to find their range, unless the statistics have it, and once to normalize them
+    phaseStart = startPhase(timings);
     double dataMin, dataMax;
-    gsl_stats_minmax(&dataMin, &dataMax, data, 1, b.T * b.N);
-    dataMin = fmin(dataMin, 0);
-    dataMax = fmax(dataMax, 1);
+    if (haveStats) {
+        double range[2] = {priceStats.min, priceStats.max};
+        getPriceRange(range, 2, &dataMin, &dataMax);
+    } else {
+        getPriceRange(data, b.T * b.N, &dataMin, &dataMax);
+    }
+    endPhase(timings, "priceRange", phaseStart, b.T, b.T * b.N, haveStats ? 0 : dataBytes);
+
+    if (checkpointing && sweeping) {
+        printf("Error: Sweeps can't be checkpointed\n");
+        freeSweep(&sweep);
+        freeMemory(data);
+        return 1;
+    } else if (checkpointing) {
+        char resultPath[256];
+        getResultPath(resultPath, filepath, b);
+        initCheckpoint(&checkpoint, resultPath);
+        // a resumed run keeps the seed and the normalization it started with, even if rounds have been appended
+        if (checkpoint.resume && loadCheckpointInfo(&checkpoint, &b, data, &dataMin, &dataMax, &printer)) {
+            freeMemory(data);
+            return 1;
+        }
+        if (saveCheckpointInfo(&checkpoint, b, data, dataMin, dataMax)) {
+            printf("Error: Couldn't save the checkpoint in %s\n", checkpoint.path);
+            freeMemory(data);
+            return 1;
+        }
+    }
 
     // Normalize prices to [0, 1]
     printf("Normalizing prices to [0,1]...\n");
+    phaseStart = startPhase(timings);
     normalizePrices(dataMin, dataMax, data, b.T * b.N);
+    endPhase(timings, "normalize", phaseStart, b.T, b.T * b.N, 2 * dataBytes);
+
+    // the statistics that don't depend on K replace the sorts of the prices, for every run
+    double dataMedian;
+    if (haveStats) {
+        if (b.dynamicThres) {
+            b.sortedFirstRound = malloc(b.N * sizeof(double));
+            getNormalizedFirstRound(&priceStats, dataMin, dataMax, b.sortedFirstRound);
+        }
+        if (b.algs[ALG_MEDIAN] || b.medianOpt) {
+            dataMedian = getNormalizedMedian(&priceStats, dataMin, dataMax);
+            b.dataMedian = &dataMedian;
+        }
+        freePriceStats(&priceStats);
+    }
+
+    if (sweeping) {
+        phaseStart = startPhase(timings);
+        runSweep(data, filepath, b, &sweep, threads, decimation);
+        endPhase(timings, "sweep", phaseStart, 0, 0, 0);
+        freeSweep(&sweep);
+        freeMemory(data);
+        free(b.sortedFirstRound);
+        endPhase(timings, "total", runStart, 0, 0, 0);
+        finishTimings(timings, statsPath, filepath, b, &printer);
+        return 0;
+    }
+
+    uint8_t noAlgs = 1;
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id])
+            noAlgs = 0;
+    }
+
+    /* INFO: Every per round result is a column of the run's result store, written to the file while it is calculated.
+     * With decimation the results are kept in memory instead, and only every decimation-th round is saved at the end.
+     */
+    ResultStore store = {0};
+    if (!noAlgs && createRunStore(&store, filepath, b, decimation, 1)) {
+        printf("Error: Couldn't create the result store, the results won't be saved\n");
+    }
 
     printf("Calculating optimal result...\n");
-    double *totalOpt = malloc(b.T * sizeof(double));
-    double *avgOpt = malloc(b.T * sizeof(double));
-    double *optAvgTrades = malloc(b.T * sizeof(double));
-    double *optAvgLowThres = malloc(b.T * sizeof(double));
-    double *optAvgHighThres = malloc(b.T * sizeof(double));
-    double *optAvgTradeGain = malloc(b.T * sizeof(double));
+    phaseStart = startPhase(timings);
+    double *totalOpt = allocResult(&store, "opt", "totalGain", b.T);
+    double *optAvgTrades = allocResult(&store, "opt", "avgTrades", b.T);
+    double *optAvgLowThres = allocResult(&store, "opt", "avgLowThreshold", b.T);
+    double *optAvgHighThres = allocResult(&store, "opt", "avgHighThreshold", b.T);
 
     if (!b.medianOpt && !b.bestHandOpt) {
-        findOpt(data, totalOpt, optAvgTrades, b);
+        findOpt(data, totalOpt, optAvgTrades, b, &printer);
     } else if (b.medianOpt) {
-        median(data, totalOpt, optAvgLowThres, optAvgTrades, totalOpt, b);
+        // the median algorithm is run on its own, and its results become OPT
+        Bandit medianBandit = b;
+        for (uint32_t id = 0; id < ALG_COUNT; id++) {
+            medianBandit.algs[id] = id == ALG_MEDIAN;
+        }
+        AlgResults medianResults[ALG_COUNT] = {0};
+        medianResults[ALG_MEDIAN] = (AlgResults) {totalOpt, optAvgLowThres, optAvgHighThres, optAvgTrades};
+        runAlgorithms(data, totalOpt, medianResults, medianBandit, &printer, nullptr);
     } else if (b.bestHandOpt) {
-        bestHand(data, totalOpt, optAvgLowThres, optAvgHighThres, optAvgTrades, b);
-    }
-    getAvgGain(b.T, avgOpt, totalOpt);
-    getAvgTradeGain(b.T, totalOpt, optAvgTrades, optAvgTradeGain);
-
-
-    double *medianAvgGain = malloc(b.T * sizeof(double));
-    double *medianAvgRegret = malloc(b.T * sizeof(double));
-    double *medianCompRatio = malloc(b.T * sizeof(double));
-    double *medianAvgTrades = malloc(b.T * sizeof(double));
-    double *medianAvgThreshold = malloc(b.T * sizeof(double));
-    double *medianAvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.median) {
-        double *medianGain = malloc(b.T * sizeof(double));
-        printf("Calculating Median...\n");
-        median(data, medianGain, medianAvgThreshold, medianAvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, medianAvgGain, medianGain);
-        getAvgRegret(b.T, medianAvgRegret, totalOpt, medianGain);
-        getCompRatio(b.T, medianCompRatio, totalOpt, medianGain);
-        getAvgTradeGain(b.T, medianGain, medianAvgTrades, medianAvgTradeGain);
-        free(medianGain);
-    }
-
-    double *greedyAvgGain = malloc(b.T * sizeof(double));
-    double *greedyAvgRegret = malloc(b.T * sizeof(double));
-    double *greedyCompRatio = malloc(b.T * sizeof(double));
-    double *greedyAvgTrades = malloc(b.T * sizeof(double));
-    double *greedyAvgLowThres = malloc(b.T * sizeof(double));
-    double *greedyAvgHighThres = malloc(b.T * sizeof(double));
-    double *greedyAvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.greedy) {
-        double *greedyGain = malloc(b.T * sizeof(double));
-        printf("Calculating Greedy...\n");
-        greedy(data, greedyGain, greedyAvgLowThres, greedyAvgHighThres, greedyAvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, greedyAvgGain, greedyGain);
-        getAvgRegret(b.T, greedyAvgRegret, totalOpt, greedyGain);
-        getCompRatio(b.T, greedyCompRatio, totalOpt, greedyGain);
-        getAvgTradeGain(b.T, greedyGain, greedyAvgTrades, greedyAvgTradeGain);
-        free(greedyGain);
-    }
-
-    double *eGreedyAvgGain = malloc(b.T * sizeof(double));
-    double *eGreedyAvgRegret = malloc(b.T * sizeof(double));
-    double *eGreedyCompRatio = malloc(b.T * sizeof(double));
-    double *eGreedyAvgTrades = malloc(b.T * sizeof(double));
-    double *eGreedyAvgLowThres = malloc(b.T * sizeof(double));
-    double *eGreedyAvgHighThres = malloc(b.T * sizeof(double));
-    double *eGreedyAvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.eGreedy) {
-        double *eGreedyGain = malloc(b.T * sizeof(double));
-        printf("Calculating Epsilon-Greedy...\n");
-        epsilonGreedy(data, eGreedyGain, eGreedyAvgLowThres, eGreedyAvgHighThres, eGreedyAvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, eGreedyAvgGain, eGreedyGain);
-        getAvgRegret(b.T, eGreedyAvgRegret, totalOpt, eGreedyGain);
-        getCompRatio(b.T, eGreedyCompRatio, totalOpt, eGreedyGain);
-        getAvgTradeGain(b.T, eGreedyGain, eGreedyAvgTrades, eGreedyAvgTradeGain);
-        free(eGreedyGain);
-    }
-
-    double *succElimAvgGain = malloc(b.T * sizeof(double));
-    double *succElimAvgRegret = malloc(b.T * sizeof(double));
-    double *succElimCompRatio = malloc(b.T * sizeof(double));
-    double *succElimAvgTrades = malloc(b.T * sizeof(double));
-    double *succElimAvgLowThres = malloc(b.T * sizeof(double));
-    double *succElimAvgHighThres = malloc(b.T * sizeof(double));
-    double *succElimAvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.succElim) {
-        double *succElimGain = malloc(b.T * sizeof(double));
-        printf("Calculating Successive Elimination...\n");
-        succElim(data, succElimGain, succElimAvgLowThres, succElimAvgHighThres, succElimAvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, succElimAvgGain, succElimGain);
-        getAvgRegret(b.T, succElimAvgRegret, totalOpt, succElimGain);
-        getCompRatio(b.T, succElimCompRatio, totalOpt, succElimGain);
-        getAvgTradeGain(b.T, succElimGain, succElimAvgTrades, succElimAvgTradeGain);
-        free(succElimGain);
-    }
-
-    double *ucb1AvgGain = malloc(b.T * sizeof(double));
-    double *ucb1AvgRegret = malloc(b.T * sizeof(double));
-    double *ucb1CompRatio = malloc(b.T * sizeof(double));
-    double *ucb1AvgTrades = malloc(b.T * sizeof(double));
-    double *ucb1AvgLowThres = malloc(b.T * sizeof(double));
-    double *ucb1AvgHighThres = malloc(b.T * sizeof(double));
-    double *ucb1AvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.ucb1) {
-        double *ucb1Gain = malloc(b.T * sizeof(double));
-        printf("Calculating UCB1...\n");
-        ucb1(data, ucb1Gain, ucb1AvgLowThres, ucb1AvgHighThres, ucb1AvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, ucb1AvgGain, ucb1Gain);
-        getAvgRegret(b.T, ucb1AvgRegret, totalOpt, ucb1Gain);
-        getCompRatio(b.T, ucb1CompRatio, totalOpt, ucb1Gain);
-        getAvgTradeGain(b.T, ucb1Gain, ucb1AvgTrades, ucb1AvgTradeGain);
-        free(ucb1Gain);
-    }
-
-    double *ucb2AvgGain = malloc(b.T * sizeof(double));
-    double *ucb2AvgRegret = malloc(b.T * sizeof(double));
-    double *ucb2CompRatio = malloc(b.T * sizeof(double));
-    double *ucb2AvgTrades = malloc(b.T * sizeof(double));
-    double *ucb2AvgLowThres = malloc(b.T * sizeof(double));
-    double *ucb2AvgHighThres = malloc(b.T * sizeof(double));
-    double *ucb2AvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.ucb2) {
-        double *ucb2Gain = malloc(b.T * sizeof(double));
-        printf("Calculating UCB2...\n");
-        ucb2(data, ucb2Gain, ucb2AvgLowThres, ucb2AvgHighThres, ucb2AvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, ucb2AvgGain, ucb2Gain);
-        getAvgRegret(b.T, ucb2AvgRegret, totalOpt, ucb2Gain);
-        getCompRatio(b.T, ucb2CompRatio, totalOpt, ucb2Gain);
-        getAvgTradeGain(b.T, ucb2Gain, ucb2AvgTrades, ucb2AvgTradeGain);
-        free(ucb2Gain);
-    }
-
-    double *exp3AvgGain = malloc(b.T * sizeof(double));
-    double *exp3AvgRegret = malloc(b.T * sizeof(double));
-    double *exp3CompRatio = malloc(b.T * sizeof(double));
-    double *exp3AvgTrades = malloc(b.T * sizeof(double));
-    double *exp3AvgLowThres = malloc(b.T * sizeof(double));
-    double *exp3AvgHighThres = malloc(b.T * sizeof(double));
-    double *exp3AvgTradeGain = malloc(b.T * sizeof(double));
-    if (b.exp3) {
-        double *exp3Gain = malloc(b.T * sizeof(double));
-        printf("Calculating EXP3...\n");
-        exp3(data, exp3Gain, exp3AvgLowThres, exp3AvgHighThres, exp3AvgTrades, totalOpt, b);
-
-        getAvgGain(b.T, exp3AvgGain, exp3Gain);
-        getAvgRegret(b.T, exp3AvgRegret, totalOpt, exp3Gain);
-        getCompRatio(b.T, exp3CompRatio, totalOpt, exp3Gain);
-        getAvgTradeGain(b.T, exp3Gain, exp3AvgTrades, exp3AvgTradeGain);
-        free(exp3Gain);
+        bestHand(data, totalOpt, optAvgLowThres, optAvgHighThres, optAvgTrades, b, &printer);
+    }
+    endPhase(timings, "opt", phaseStart, b.T, b.T * b.N, dataBytes);
+
+    /* INFO: Every result is kept in an array of ALG_COUNT arrays, indexed by the algorithm's id.
+     * Only the arrays of the algorithms that are run are allocated, the rest stay NULL. The derived metrics have no
+     * arrays, they are calculated from the sources for the rounds that are saved and plotted.
+     */
+    double *algGain[ALG_COUNT] = {0};
+    double *algAvgTrades[ALG_COUNT] = {0};
+    double *algAvgLowThres[ALG_COUNT] = {0};
+    double *algAvgHighThres[ALG_COUNT] = {0};
+    MetricSource optSource = {totalOpt, nullptr, optAvgTrades};
+    MetricSource sources[ALG_COUNT] = {0};
+    AlgResults results[ALG_COUNT] = {0};
+    uint32_t algCount = 0;
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            char *name = algorithms[id]->name;
+            algGain[id] = allocResult(&store, name, "totalGain", b.T);
+            algAvgTrades[id] = allocResult(&store, name, "avgTrades", b.T);
+            algAvgLowThres[id] = allocResult(&store, name, "avgLowThreshold", b.T);
+            algAvgHighThres[id] = allocResult(&store, name, "avgHighThreshold", b.T);
+            sources[id] = (MetricSource) {algGain[id], totalOpt, algAvgTrades[id]};
+            results[id] = (AlgResults) {.totalGain = algGain[id],
+                                        .avgLowThreshold = algAvgLowThres[id],
+                                        .avgHighThreshold = algAvgHighThres[id],
+                                        .avgTrades = algAvgTrades[id],
+                                        .timing = timings ? &timings->algs[id] : nullptr};
+            algCount++;
+        }
+    }
+
+    Checkpoint *runCheckpoint = checkpointing ? &checkpoint : nullptr;
+    phaseStart = startPhase(timings);
+    if (concurrent && b.batch > 1) {
+        // the threads play the rounds of each batch instead of an algorithm each
+        Bandit batched = b;
+        batched.batchThreads = threads ? threads : (uint32_t) sysconf(_SC_NPROCESSORS_ONLN);
+        runAlgorithms(data, totalOpt, results, batched, &printer, runCheckpoint);
+    } else if (concurrent) {
+        runAlgorithmsConcurrently(data, totalOpt, results, b, threads, &printer, runCheckpoint);
+    } else {
+        runAlgorithms(data, totalOpt, results, b, &printer, runCheckpoint);
+    }
+    endPhase(timings, "algorithms", phaseStart, algCount * b.T, algCount * b.T * b.N, algCount * dataBytes);
+
+    // the metrics of the saved rounds go straight to the store, and count as the time the algorithms spent on them
+    phaseStart = startPhase(timings);
+    saveMetrics(&store, "opt", &optSource);
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            saveMetrics(&store, algorithms[id]->name, &sources[id]);
+            if (timings)
+                chargeTiming(timings, &timings->algs[id].derive, &phaseStart);
+        }
+    }
+
+    // from here on the time goes to saving the results, but for the replications and the plots
+    phaseStart = startPhase(timings);
+
+    RunningStats regretStats[ALG_COUNT] = {0};
+    RunningStats compRatioStats[ALG_COUNT] = {0};
+    if (replications) {
+        switchPhase(timings, "save", &phaseStart);
+        runReplications(data, totalOpt, b, replications, threads, regretStats, compRatioStats);
+        switchPhase(timings, "replications", &phaseStart);
     }
 
     if (plot && morePlot) {
+        switchPhase(timings, "save", &phaseStart);
         printf("Plotting prices...\n");
         plotData(data, b.T * b.N);
+        switchPhase(timings, "plot", &phaseStart);
     }
 
-    free(data);
-    free(totalOpt);
+    freeMemory(data);
+    free(b.sortedFirstRound);
 
     if (plot && morePlot) {
+        switchPhase(timings, "save", &phaseStart);
         printf("Plotting gains...\n");
-        plotAlgorithms("Average Gain", b, avgOpt, medianAvgGain, greedyAvgGain, eGreedyAvgGain, succElimAvgGain,
-                       ucb1AvgGain, ucb2AvgGain, exp3AvgGain, 0);
+        plotMetric("Average Gain", b, METRIC_AVG_GAIN, &optSource, sources, 0);
+        switchPhase(timings, "plot", &phaseStart);
     }
 
-    free(avgOpt);
-    free(medianAvgGain);
-    free(greedyAvgGain);
-    free(eGreedyAvgGain);
-    free(succElimAvgGain);
-    free(ucb1AvgGain);
-    free(ucb2AvgGain);
-    free(exp3AvgGain);
-
-    uint8_t noAlgs = !(b.median || b.greedy || b.eGreedy || b.succElim || b.ucb1 || b.ucb2 || b.exp3);
-
     if (!noAlgs) {
-        saveResults(filepath, b, "regret", medianAvgRegret, greedyAvgRegret, eGreedyAvgRegret, succElimAvgRegret,
-                    ucb1AvgRegret, ucb2AvgRegret, exp3AvgRegret);
-
-        saveResults(filepath, b, "compRatio", medianCompRatio, greedyCompRatio, eGreedyCompRatio, succElimCompRatio,
-                    ucb1CompRatio, ucb2CompRatio, exp3CompRatio);
+        saveReplicationResults(filepath, b, "regret", regretStats);
+        saveReplicationResults(filepath, b, "compRatio", compRatioStats);
     }
 
     if (!noAlgs && plot) {
+        switchPhase(timings, "save", &phaseStart);
         printf("Plotting regret...\n");
-        plotAlgorithms("Average Regret", b, nullptr, medianAvgRegret, greedyAvgRegret, eGreedyAvgRegret,
-                       succElimAvgRegret, ucb1AvgRegret, ucb2AvgRegret, exp3AvgRegret, 0);
+        plotMetric("Average Regret", b, METRIC_REGRET, nullptr, sources, 0);
+        switchPhase(timings, "plot", &phaseStart);
     }
 
+    if (!noAlgs && plot) {
+        switchPhase(timings, "save", &phaseStart);
+        printf("Plotting competitive ratio...\n");
+        plotMetric("Competitive Ratio", b, METRIC_COMP_RATIO, nullptr, sources, 1);
+        switchPhase(timings, "plot", &phaseStart);
+    }
 
-    free(medianAvgRegret);
-    free(greedyAvgRegret);
-    free(eGreedyAvgRegret);
-    free(succElimAvgRegret);
-    free(ucb1AvgRegret);
-    free(ucb2AvgRegret);
-    free(exp3AvgRegret);
+    if (replications && plot) {
+        switchPhase(timings, "save", &phaseStart);
+        printf("Plotting replications...\n");
+        plotReplications("Average Regret", b, regretStats, 0);
+        plotReplications("Competitive Ratio", b, compRatioStats, 1);
+        switchPhase(timings, "plot", &phaseStart);
+    }
 
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        freeRunningStats(&regretStats[id]);
+        freeRunningStats(&compRatioStats[id]);
+    }
 
     if (!noAlgs && plot) {
-        printf("Plotting competitive ratio...\n");
-        plotAlgorithms("Competitive Ratio", b, nullptr, medianCompRatio, greedyCompRatio, eGreedyCompRatio,
-                       succElimCompRatio, ucb1CompRatio, ucb2CompRatio, exp3CompRatio, 1);
-    }
-
-    free(medianCompRatio);
-    free(greedyCompRatio);
-    free(eGreedyCompRatio);
-    free(succElimCompRatio);
-    free(ucb1CompRatio);
-    free(ucb2CompRatio);
-    free(exp3CompRatio);
-
-    // if (!noAlgs && plot && !b.dualThres) {
-    //     printf("Plotting average threshold...\n");
-    //     plotAlgorithms("Average Threshold", b, optAvgLowThres, medianAvgThreshold, greedyAvgLowThres,
-    //     eGreedyAvgLowThres,
-    //                    succElimAvgLowThres, ucb1AvgLowThres, ucb2AvgLowThres, exp3AvgLowThres, 1);
-    // } else if (!noAlgs && plot) {
-    //     printf("Plotting average lower threshold...\n");
-    //     plotAlgorithms("Average Lower Threshold", b, optAvgLowThres, medianAvgThreshold, greedyAvgLowThres,
-    //     eGreedyAvgLowThres,
-    //                    succElimAvgLowThres, ucb1AvgLowThres, ucb2AvgLowThres, exp3AvgLowThres, 1);
-    //
-    //     printf("Plotting average higher threshold...\n");
-    //     plotAlgorithms("Average Higher Threshold", b, optAvgHighThres, medianAvgThreshold, greedyAvgHighThres,
-    //                    eGreedyAvgHighThres, succElimAvgHighThres, ucb1AvgHighThres, ucb2AvgHighThres,
-    //                    exp3AvgHighThres, 1);
-    // }
-    if (!noAlgs && plot) {
+        switchPhase(timings, "save", &phaseStart);
         printf("Plotting average thresholds...\n");
-        plotThresholds(b, optAvgLowThres, optAvgHighThres, medianAvgThreshold, greedyAvgLowThres, greedyAvgHighThres,
-                       eGreedyAvgLowThres, eGreedyAvgHighThres, succElimAvgLowThres, succElimAvgHighThres,
-                       ucb1AvgLowThres, ucb1AvgHighThres, ucb2AvgLowThres, ucb2AvgHighThres, exp3AvgLowThres,
-                       exp3AvgHighThres);
-    }
-
-    free(medianAvgThreshold);
-
-    free(optAvgLowThres);
-    free(greedyAvgLowThres);
-    free(eGreedyAvgLowThres);
-    free(succElimAvgLowThres);
-    free(ucb1AvgLowThres);
-    free(ucb2AvgLowThres);
-    free(exp3AvgLowThres);
-
-    free(optAvgHighThres);
-    free(greedyAvgHighThres);
-    free(eGreedyAvgHighThres);
-    free(succElimAvgHighThres);
-    free(ucb1AvgHighThres);
-    free(ucb2AvgHighThres);
-    free(exp3AvgHighThres);
+        plotThresholds(b, optAvgLowThres, optAvgHighThres, algAvgLowThres, algAvgHighThres);
+        switchPhase(timings, "plot", &phaseStart);
+    }
+
+    releaseResult(&store, "opt", "avgLowThreshold", optAvgLowThres);
+    releaseResult(&store, "opt", "avgHighThreshold", optAvgHighThres);
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            releaseResult(&store, algorithms[id]->name, "avgLowThreshold", algAvgLowThres[id]);
+            releaseResult(&store, algorithms[id]->name, "avgHighThreshold", algAvgHighThres[id]);
+        }
+    }
 
     if (plot && morePlot) {
+        switchPhase(timings, "save", &phaseStart);
         printf("Plotting average number of trades...\n");
-        plotAlgorithms("Average Number of Trades", b, optAvgTrades, medianAvgTrades, greedyAvgTrades, eGreedyAvgTrades,
-                       succElimAvgTrades, ucb1AvgTrades, ucb2AvgTrades, exp3AvgTrades, 0);
+        plotAlgorithms("Average Number of Trades", b, optAvgTrades, algAvgTrades, 0);
+        switchPhase(timings, "plot", &phaseStart);
     }
 
-    free(optAvgTrades);
-    free(medianAvgTrades);
-    free(greedyAvgTrades);
-    free(eGreedyAvgTrades);
-    free(succElimAvgTrades);
-    free(ucb1AvgTrades);
-    free(ucb2AvgTrades);
-    free(exp3AvgTrades);
-
     if (plot && morePlot) {
+        switchPhase(timings, "save", &phaseStart);
         printf("Plotting average gain per trade...\n");
-        plotAlgorithms("Average Gain per Trade", b, optAvgTradeGain, medianAvgTradeGain, greedyAvgTradeGain,
-                       eGreedyAvgTradeGain, succElimAvgTradeGain, ucb1AvgTradeGain, ucb2AvgTradeGain, exp3AvgTradeGain,
-                       0);
-    }
-
-    free(optAvgTradeGain);
-    free(medianAvgTradeGain);
-    free(greedyAvgTradeGain);
-    free(eGreedyAvgTradeGain);
-    free(succElimAvgTradeGain);
-    free(ucb1AvgTradeGain);
-    free(ucb2AvgTradeGain);
-    free(exp3AvgTradeGain);
+        plotMetric("Average Gain per Trade", b, METRIC_AVG_TRADE_GAIN, &optSource, sources, 0);
+        switchPhase(timings, "plot", &phaseStart);
+    }
+
+    // the sources of the metrics are only released once nothing is derived from them
+    releaseResult(&store, "opt", "totalGain", totalOpt);
+    releaseResult(&store, "opt", "avgTrades", optAvgTrades);
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            releaseResult(&store, algorithms[id]->name, "totalGain", algGain[id]);
+            releaseResult(&store, algorithms[id]->name, "avgTrades", algAvgTrades[id]);
+        }
+    }
+
+    closeResultStore(&store);
+    switchPhase(timings, "save", &phaseStart);
+    // the plots are drawn while the results are saved, the run ends once gnuplot has all of them
+    finishPlots();
+    switchPhase(timings, "plot", &phaseStart);
+
+    endPhase(timings, "total", runStart, b.T, b.T * b.N, 0);
+    finishTimings(timings, statsPath, filepath, b, &printer);
 
     return 0;
 }
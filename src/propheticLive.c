@@ -0,0 +1,359 @@
+#include <getopt.h>
+#include <gsl/gsl_rng.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <banditAlgs.h>
+#include <reporter.h>
+#include <session.h>
+#include <util.h>
+
+// prices per read from the feed
+#define FEED_BUFFER 4096
+// buckets 0 to 3 hold 0 to 3 ns, then every power of 2 is split in 4 buckets
+#define LATENCY_BUCKETS 256
+
+/**
+ * @typedef latencyHistogramStruct
+ * @brief The decision latencies of a session, in buckets about 19% wide
+ *
+ */
+typedef struct latencyHistogramStruct {
+    uint64_t count[LATENCY_BUCKETS];
+    uint64_t total;
+    uint64_t sum;
+    uint64_t max;
+} LatencyHistogram;
+
+void printHelp() {
+    printf("Usage:\n"
+           "    propheticLive [options] [-t <integer>] <file>\n"
+           "    propheticLive -h      # Display this help screen.\n\n"
+           "Replays the prices of <file> through a unix socket as a live feed, trades them\n"
+           "one at a time with a session of each chosen algorithm, and prints the latency\n"
+           "of the decisions.\n\n"
+           "Options:\n"
+           "    -t <integer>    Set the number of thresholds (default = 10).\n"
+           "    -d              Use two thresholds.\n"
+           "    -k              Keep items between rounds.\n"
+           "    -r <integer>    Send <integer> prices per second (default = 0, as fast\n"
+           "                    as possible).\n\n"
+           "    -g              Run the Greedy algorithm.\n"
+           "    -e              Run the Epsilon Greedy algorithm.\n"
+           "    -s              Run the Successive Elimination algorithm.\n"
+           "    -u              Run the UCB1 algorithm.\n"
+           "    -U              Run the UCB2 algorithm.\n"
+           "    -x              Run the EXP3 algorithm.\n"
+           "    -l              Run the Sliding Window UCB algorithm.\n"
+           "    -c              Run the Discounted UCB algorithm.\n");
+}
+
+static uint32_t latencyBucket(uint64_t ns) {
+    if (ns < 4) {
+        return ns;
+    }
+
+    uint32_t msb = 63 - __builtin_clzll(ns);
+    return 4 + (msb - 2) * 4 + ((ns >> (msb - 2)) & 3);
+}
+
+static uint64_t bucketUpperBound(uint32_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+
+    uint32_t msb = (bucket - 4) / 4 + 2;
+    uint32_t sub = (bucket - 4) % 4;
+    return ((5ull + sub) << (msb - 2)) - 1;
+}
+
+static void addLatency(LatencyHistogram *h, uint64_t ns) {
+    h->count[latencyBucket(ns)]++;
+    h->total++;
+    h->sum += ns;
+    if (ns > h->max) {
+        h->max = ns;
+    }
+}
+
+static uint64_t latencyPercentile(LatencyHistogram *h, double percentile) {
+    uint64_t rank = (uint64_t) ceil(percentile / 100 * (double) h->total);
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += h->count[bucket];
+        if (seen >= rank && seen) {
+            // the bucket's upper bound, but never more than the largest latency
+            uint64_t bound = bucketUpperBound(bucket);
+            return bound < h->max ? bound : h->max;
+        }
+    }
+
+    return h->max;
+}
+
+static void printLatencies(char *title, LatencyHistogram *h) {
+    if (!h->total) {
+        return;
+    }
+
+    printf("%s (%lu prices)\n", title, h->total);
+    printf("Mean: %.1lf ns\tp50: %lu ns\tp90: %lu ns\tp99: %lu ns\tp99.9: %lu ns\tMax: %lu ns\n",
+           (double) h->sum / (double) h->total, latencyPercentile(h, 50), latencyPercentile(h, 90),
+           latencyPercentile(h, 99), latencyPercentile(h, 99.9), h->max);
+    printf("Up to (ns)\tPrices\n");
+    for (uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        if (h->count[bucket]) {
+            printf("%-10lu\t%lu\n", bucketUpperBound(bucket), h->count[bucket]);
+        }
+    }
+}
+
+static uint64_t nanoseconds(struct timespec *time) {
+    return (uint64_t) time->tv_sec * 1000000000ull + (uint64_t) time->tv_nsec;
+}
+
+// writes the prices to the socket, rate of them per second, 0 for as fast as possible
+static int feedPrices(int socket, double *data, uint64_t count, uint64_t rate) {
+    struct timespec start, next;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint64_t i = 0; i < count;) {
+        uint64_t batch = count - i < FEED_BUFFER ? count - i : FEED_BUFFER;
+        if (rate) {
+            // one price at a time, each at its own time
+            batch = 1;
+            uint64_t at = nanoseconds(&start) + i * 1000000000ull / rate;
+            next.tv_sec = (time_t) (at / 1000000000ull);
+            next.tv_nsec = (long) (at % 1000000000ull);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+
+        char *bytes = (char *) &data[i];
+        size_t size = batch * sizeof(double);
+        while (size) {
+            ssize_t written = write(socket, bytes, size);
+            if (written <= 0) {
+                return 1;
+            }
+            bytes += written;
+            size -= written;
+        }
+        i += batch;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 1) {
+        printHelp();
+        return 0;
+    }
+
+    Bandit b = {.T = 0,
+                .N = 0,
+                .K = 10,
+                .thresholds = 10,
+                .ucb2Alpha = DEFAULT_UCB2_ALPHA,
+                .eGreedyScale = DEFAULT_EGREEDY_SCALE};
+    uint64_t rate = 0;
+
+    int opt;
+    opterr = 0;
+
+    while ((opt = getopt(argc, argv, ":hdkgesuUxlct:r:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printHelp();
+                return 0;
+            case 't':
+                b.K = atoi(optarg);
+                b.thresholds = b.K;
+                break;
+            case 'r':
+                rate = strtoull(optarg, nullptr, 10);
+                break;
+            case 'd':
+                b.dualThres = 1;
+                break;
+            case 'k':
+                b.keepItems = 1;
+                break;
+            case 'g':
+                b.algs[ALG_GREEDY] = 1;
+                break;
+            case 'e':
+                b.algs[ALG_EGREEDY] = 1;
+                break;
+            case 's':
+                b.algs[ALG_SUCCELIM] = 1;
+                break;
+            case 'u':
+                b.algs[ALG_UCB1] = 1;
+                break;
+            case 'U':
+                b.algs[ALG_UCB2] = 1;
+                break;
+            case 'x':
+                b.algs[ALG_EXP3] = 1;
+                break;
+            case 'l':
+                b.algs[ALG_SWUCB] = 1;
+                break;
+            case 'c':
+                b.algs[ALG_DUCB] = 1;
+                break;
+            case '?':
+                if (optopt == 't' || optopt == 'r')
+                    fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+                break;
+            default:
+                abort();
+        }
+    }
+
+    if (optind >= argc) {
+        printf("Error: No filename provided\n");
+        return 1;
+    }
+
+    char *filepath = argv[optind];
+    double *data;
+    uint64_t totalRounds, pricesPerRound;
+    if (loadPrices(filepath, &data, &totalRounds, &pricesPerRound, nullptr, 0)) {
+        printf("Error while importing file\n");
+        return 1;
+    }
+
+    b.T = totalRounds;
+    b.N = pricesPerRound;
+    if (b.dualThres) {
+        b.thresholds = b.K;
+        b.K = b.K * (b.K + 1) / 2;
+    }
+
+    if ((b.dualThres && b.K <= 2) || b.K < 1) {
+        printf("Error: Too few thresholds\n");
+        freeMemory(data);
+        return 1;
+    }
+
+    // the feed is normalized with the bounds of the whole file, like an offline run, so their gains can be compared
+    double dataMin, dataMax;
+    getPriceRange(data, b.T * b.N, &dataMin, &dataMax);
+
+    gsl_rng_env_setup();
+    b.seed = time(nullptr);
+
+    Reporter printer = {writeToStream, stdout};
+    Session sessions[ALG_COUNT];
+    uint32_t ids[ALG_COUNT];
+    uint32_t sessionCount = 0;
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (!b.algs[id])
+            continue;
+
+        if (initSession(&sessions[sessionCount], id, b, dataMin, dataMax, &printer)) {
+            for (uint32_t i = 0; i < sessionCount; i++) {
+                freeSession(&sessions[i]);
+            }
+            freeMemory(data);
+            return 1;
+        }
+        ids[sessionCount++] = id;
+    }
+
+    if (!sessionCount) {
+        printf("Error: No algorithm chosen\n");
+        freeMemory(data);
+        return 1;
+    }
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets)) {
+        printf("Error: Couldn't create the feed socket\n");
+        for (uint32_t i = 0; i < sessionCount; i++) {
+            freeSession(&sessions[i]);
+        }
+        freeMemory(data);
+        return 1;
+    }
+
+    pid_t feeder = fork();
+    if (feeder == 0) {
+        close(sockets[0]);
+        int error = feedPrices(sockets[1], data, b.T * b.N, rate);
+        close(sockets[1]);
+        freeMemory(data);
+        _exit(error);
+    }
+    close(sockets[1]);
+    freeMemory(data);
+
+    printf("Replaying %lu prices...\n", b.T * b.N);
+
+    // within a round and at the end of a round, where the algorithm is updated
+    LatencyHistogram *priceLatency = calloc(sessionCount, sizeof(LatencyHistogram));
+    LatencyHistogram *roundLatency = calloc(sessionCount, sizeof(LatencyHistogram));
+    uint64_t (*actions)[3] = calloc(sessionCount, sizeof(uint64_t[3]));
+
+    double buffer[FEED_BUFFER];
+    size_t buffered = 0;
+    ssize_t received;
+    while ((received = read(sockets[0], (char *) buffer + buffered, sizeof(buffer) - buffered)) > 0) {
+        buffered += received;
+        size_t prices = buffered / sizeof(double);
+
+        for (size_t p = 0; p < prices; p++) {
+            for (uint32_t i = 0; i < sessionCount; i++) {
+                Session *session = &sessions[i];
+                uint8_t endsRound = session->price == b.N - 1;
+
+                struct timespec before, after;
+                clock_gettime(CLOCK_MONOTONIC, &before);
+                uint8_t action = observe(session, buffer[p]);
+                clock_gettime(CLOCK_MONOTONIC, &after);
+
+                addLatency(endsRound ? &roundLatency[i] : &priceLatency[i], nanoseconds(&after) - nanoseconds(&before));
+                actions[i][action]++;
+            }
+        }
+
+        // a price split between two reads is kept for the next one
+        buffered -= prices * sizeof(double);
+        memmove(buffer, (char *) buffer + prices * sizeof(double), buffered);
+    }
+    close(sockets[0]);
+
+    int status;
+    waitpid(feeder, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+        printf("Error: The feed stopped early\n");
+    }
+
+    for (uint32_t i = 0; i < sessionCount; i++) {
+        Session *session = &sessions[i];
+        printf("\n");
+        printf("%s\n", algorithms[ids[i]]->title);
+        printf("Rounds: %lu\n", session->round);
+        printf("Buys: %lu\tSells: %lu\tHolds: %lu\n", actions[i][TRADE_BUY], actions[i][TRADE_SELL],
+               actions[i][TRADE_HOLD]);
+        printf("Total Gain: %lf\n", session->totalGain);
+        printLatencies("Latency within a round", &priceLatency[i]);
+        printLatencies("Latency at the end of a round", &roundLatency[i]);
+        freeSession(session);
+    }
+
+    free(priceLatency);
+    free(roundLatency);
+    free(actions);
+
+    return 0;
+}
@@ -0,0 +1,912 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <banditAlgs.h>
+#include <priceModel.h>
+#include <resultStore.h>
+#include <util.h>
+
+// the most values of a line of the manifest, and the most words of its options
+#define MAX_VALUES 256
+// the paths of the units, of their locks and of the files inside their results
+#define PATH_SIZE 1024
+// the directory every manifest keeps its units in
+#define SHARD_ROOT "prophetResults/shards/"
+
+void printHelp() {
+    printf("Usage:\n"
+           "    propheticShard [options] <manifest>\n"
+           "    propheticShard -m <manifest>    # Merge the results of the units.\n"
+           "    propheticShard -h               # Display this help screen.\n\n"
+           "    # The manifest is a text file of lines \"<key> <value> <value> ...\", and\n"
+           "    # anything after a # is a comment:\n"
+           "    #     data <file> ...        the .dat files of the prices\n"
+           "    #     model <model> ...      models of --model, the seed added if left out\n"
+           "    #     K <integer> ...        the numbers of thresholds (default = 10)\n"
+           "    #     algs <letters> ...     groups of algorithm flags run together, e.g. gus U\n"
+           "    #     replications <count> [<per unit>]\n"
+           "    #                            runs of each stochastic algorithm, split in\n"
+           "    #                            units of <per unit> (default = <count>)\n"
+           "    #     seed <integer>         the seed of the algorithms (default = 0)\n"
+           "    #     options <option> ...   more options of propheticBandits, e.g. -d -j 4\n"
+           "    # Every combination of data, K, algs and replication units is a unit, run by\n"
+           "    # one propheticBandits in prophetResults/shards/<manifest name>/<unit>/.\n\n"
+           "Options:\n"
+           "    -p <integer>    Run <integer> shards in parallel on this machine (default = 1).\n"
+           "                    More shards, here or on other machines sharing the directory,\n"
+           "                    can be started at any time and take the units left.\n"
+           "    -b <file>       Run the units with the propheticBandits binary <file>, instead\n"
+           "                    of the one next to propheticShard.\n"
+           "    -s              Print which units are done, running or left, and exit.\n"
+           "    -m              Merge the results of every unit into prophetResults/, once they\n"
+           "                    are all done: the result stores of each run and the mean and\n"
+           "                    variance of all the replications.\n");
+}
+
+/**
+ * @typedef manifestStruct
+ * @brief The grid of an experiment, every combination of its values a unit
+ *
+ */
+typedef struct manifestStruct {
+    // the name of the manifest file, without its directory and extension
+    char name[256];
+    // the absolute paths of the files, and the models with their seeds
+    char *data[MAX_VALUES];
+    char dataName[MAX_VALUES][192];
+    uint8_t isModel[MAX_VALUES];
+    uint32_t dataCount;
+    uint32_t K[MAX_VALUES];
+    uint32_t KCount;
+    char *algs[MAX_VALUES];
+    uint8_t stochastic[MAX_VALUES];
+    uint32_t algCount;
+    uint32_t replications;
+    uint32_t perUnit;
+    uint64_t seed;
+    char *options[MAX_VALUES];
+    uint32_t optionCount;
+} Manifest;
+
+/**
+ * @typedef shardUnitStruct
+ * @brief One run of propheticBandits, and the part of the grid it covers
+ *
+ */
+typedef struct shardUnitStruct {
+    char name[256];
+    uint32_t data;
+    uint32_t K;
+    uint32_t algs;
+    // the first replication of the unit and how many it runs, 0 without replications
+    uint32_t firstReplication;
+    uint32_t replications;
+} ShardUnit;
+
+/**
+ * @typedef mergeEntryStruct
+ * @brief A file of the merged results, and the files of the units it is made of
+ *
+ */
+typedef struct mergeEntryStruct {
+    // the path inside prophetResults/, for the replications without the R<count>.txt
+    char path[PATH_SIZE];
+    char **sources;
+    uint32_t sourceCount;
+} MergeEntry;
+
+/**
+ * @typedef mergeListStruct
+ * @brief Every file of the merged results, by kind
+ *
+ */
+typedef struct mergeListStruct {
+    MergeEntry *stores;
+    uint32_t storeCount;
+    MergeEntry *replications;
+    uint32_t replicationCount;
+    MergeEntry *files;
+    uint32_t fileCount;
+} MergeList;
+
+// the letters of the algorithms, the same as the flags of propheticBandits
+static const char algLetters[ALG_COUNT] = {
+        [ALG_MEDIAN] = 'm', [ALG_GREEDY] = 'g', [ALG_EGREEDY] = 'e', [ALG_SUCCELIM] = 's', [ALG_UCB1] = 'u',
+        [ALG_UCB2] = 'U',   [ALG_EXP3] = 'x',   [ALG_HOO] = 'z',     [ALG_SWUCB] = 'l',   [ALG_DUCB] = 'c'};
+
+// returns 0 if every letter is an algorithm, or a for all of them, and sets stochastic if any of them is
+static uint8_t parseAlgs(char *letters, uint8_t *stochastic) {
+    *stochastic = 0;
+    for (char *c = letters; *c; c++) {
+        uint8_t found = 0;
+        for (uint32_t id = 0; id < ALG_COUNT; id++) {
+            if (*c == 'a' || *c == algLetters[id]) {
+                *stochastic |= algorithms[id]->stochastic;
+                found = 1;
+            }
+        }
+        if (!found) {
+            return 1;
+        }
+    }
+
+    return !*letters;
+}
+
+static uint8_t addData(Manifest *manifest, char *value, uint8_t isModel) {
+    if (manifest->dataCount == MAX_VALUES) {
+        printf("Error: A manifest can have up to %u data files and models\n", MAX_VALUES);
+        return 1;
+    }
+    uint32_t d = manifest->dataCount;
+
+    if (isModel) {
+        PriceModel model = {0};
+        char spec[256];
+        snprintf(spec, sizeof(spec), "%s", value);
+        if (parsePriceModel(spec, &model)) {
+            printf("Error: Invalid model %s\n", value);
+            return 1;
+        }
+        getPriceModelName(&model, manifest->dataName[d], sizeof(manifest->dataName[d]));
+
+        // every unit has to generate the same prices, so a model without a seed gets the one of the manifest
+        uint32_t commas = 0;
+        for (char *c = value; *c; c++) {
+            commas += *c == ',';
+        }
+        snprintf(spec, sizeof(spec), commas == 2 ? "%s,%lu" : "%s", value, manifest->seed);
+        manifest->data[d] = strdup(spec);
+    } else {
+        // the units run in their own directories, so they get the absolute path of the file
+        char path[PATH_MAX];
+        if (!realpath(value, path)) {
+            printf("Error: Couldn't find %s\n", value);
+            return 1;
+        }
+        snprintf(manifest->dataName[d], sizeof(manifest->dataName[d]), "%s", basename(value));
+        char *dot = strrchr(manifest->dataName[d], '.');
+        if (dot)
+            *dot = '\0';
+        manifest->data[d] = strdup(path);
+    }
+
+    manifest->isModel[d] = isModel;
+    manifest->dataCount++;
+    return 0;
+}
+
+static void freeManifest(Manifest *manifest) {
+    for (uint32_t d = 0; d < manifest->dataCount; d++) {
+        free(manifest->data[d]);
+    }
+    for (uint32_t a = 0; a < manifest->algCount; a++) {
+        free(manifest->algs[a]);
+    }
+    for (uint32_t o = 0; o < manifest->optionCount; o++) {
+        free(manifest->options[o]);
+    }
+}
+
+/**
+ * @typedef pendingValueStruct
+ * @brief A data file or model of the manifest, only added once the seed of the manifest is known
+ *
+ */
+typedef struct pendingValueStruct {
+    char *value;
+    uint8_t isModel;
+} PendingValue;
+
+static uint8_t loadManifest(char *path, Manifest *manifest) {
+    *manifest = (Manifest) {0};
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("Error opening file %s\n", path);
+        return 1;
+    }
+
+    char temp[PATH_SIZE];
+    snprintf(temp, sizeof(temp), "%s", path);
+    snprintf(manifest->name, sizeof(manifest->name), "%s", basename(temp));
+    char *dot = strrchr(manifest->name, '.');
+    if (dot && dot != manifest->name)
+        *dot = '\0';
+
+    // the data is only added at the end, since a model takes the seed of the manifest, wherever it is set
+    PendingValue pending[MAX_VALUES];
+    uint32_t pendingCount = 0;
+    uint8_t error = 0;
+    char line[4096];
+    uint32_t lineNumber = 0;
+    while (!error && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char *comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char *save;
+        char *key = strtok_r(line, " \t\r\n", &save);
+        if (!key) {
+            continue;
+        }
+        char *values[MAX_VALUES];
+        uint32_t valueCount = 0;
+        for (char *value = strtok_r(nullptr, " \t\r\n", &save); value && valueCount < MAX_VALUES;
+             value = strtok_r(nullptr, " \t\r\n", &save)) {
+            values[valueCount++] = value;
+        }
+
+        if (!valueCount) {
+            printf("Error: Line %u of the manifest has no values\n", lineNumber);
+            error = 1;
+        } else if (!strcmp(key, "data") || !strcmp(key, "model")) {
+            for (uint32_t v = 0; v < valueCount && !error; v++) {
+                if (pendingCount == MAX_VALUES) {
+                    printf("Error: A manifest can have up to %u data files and models\n", MAX_VALUES);
+                    error = 1;
+                    break;
+                }
+                pending[pendingCount++] = (PendingValue) {strdup(values[v]), key[0] == 'm'};
+            }
+        } else if (!strcmp(key, "K")) {
+            for (uint32_t v = 0; v < valueCount && !error && manifest->KCount < MAX_VALUES; v++) {
+                manifest->K[manifest->KCount] = strtoul(values[v], nullptr, 10);
+                if (!manifest->K[manifest->KCount++]) {
+                    printf("Error: Invalid K %s\n", values[v]);
+                    error = 1;
+                }
+            }
+        } else if (!strcmp(key, "algs")) {
+            for (uint32_t v = 0; v < valueCount && !error && manifest->algCount < MAX_VALUES; v++) {
+                uint32_t a = manifest->algCount++;
+                manifest->algs[a] = strdup(values[v]);
+                if (parseAlgs(values[v], &manifest->stochastic[a])) {
+                    printf("Error: Invalid algorithms %s\n", values[v]);
+                    error = 1;
+                }
+            }
+        } else if (!strcmp(key, "replications") && valueCount <= 2) {
+            manifest->replications = strtoul(values[0], nullptr, 10);
+            manifest->perUnit = valueCount == 2 ? strtoul(values[1], nullptr, 10) : manifest->replications;
+            if (!manifest->replications || !manifest->perUnit) {
+                printf("Error: Invalid replications on line %u of the manifest\n", lineNumber);
+                error = 1;
+            }
+        } else if (!strcmp(key, "seed") && valueCount == 1) {
+            manifest->seed = strtoull(values[0], nullptr, 10);
+        } else if (!strcmp(key, "options")) {
+            for (uint32_t v = 0; v < valueCount && manifest->optionCount < MAX_VALUES; v++) {
+                manifest->options[manifest->optionCount++] = strdup(values[v]);
+            }
+        } else {
+            printf("Error: Unknown line %u of the manifest, \"%s\"\n", lineNumber, key);
+            error = 1;
+        }
+    }
+    fclose(file);
+
+    for (uint32_t p = 0; p < pendingCount; p++) {
+        error = error || addData(manifest, pending[p].value, pending[p].isModel);
+        free(pending[p].value);
+    }
+    if (!error && !manifest->dataCount) {
+        printf("Error: The manifest has no data or model\n");
+        error = 1;
+    } else if (!error && !manifest->algCount) {
+        printf("Error: The manifest has no algs\n");
+        error = 1;
+    }
+    if (!manifest->KCount) {
+        manifest->K[manifest->KCount++] = 10;
+    }
+
+    if (error) {
+        freeManifest(manifest);
+    }
+    return error;
+}
+
+/**
+ * @brief Lists the units of the manifest, in the same order for every shard
+ *
+ * The replications of a group with a stochastic algorithm are split in units of perUnit runs, while a group of
+ * deterministic algorithms has a single unit.
+ *
+ * @returns The units, count set to their number
+ */
+static ShardUnit *listUnits(Manifest *manifest, uint32_t *count) {
+    uint32_t blocks = manifest->replications ? (manifest->replications + manifest->perUnit - 1) / manifest->perUnit : 1;
+    ShardUnit *units = malloc(manifest->dataCount * manifest->KCount * manifest->algCount * blocks * sizeof(ShardUnit));
+    *count = 0;
+
+    for (uint32_t d = 0; d < manifest->dataCount; d++) {
+        for (uint32_t k = 0; k < manifest->KCount; k++) {
+            for (uint32_t a = 0; a < manifest->algCount; a++) {
+                uint32_t groupBlocks = manifest->stochastic[a] ? blocks : 1;
+                for (uint32_t block = 0; block < groupBlocks; block++) {
+                    ShardUnit *unit = &units[(*count)++];
+                    unit->data = d;
+                    unit->K = k;
+                    unit->algs = a;
+                    unit->firstReplication = 0;
+                    unit->replications = 0;
+                    if (manifest->replications && manifest->stochastic[a]) {
+                        unit->firstReplication = block * manifest->perUnit;
+                        uint32_t left = manifest->replications - unit->firstReplication;
+                        unit->replications = left < manifest->perUnit ? left : manifest->perUnit;
+                    }
+                    snprintf(unit->name, sizeof(unit->name), "%s_K%u_%s_b%u", manifest->dataName[d],
+                             manifest->K[k], manifest->algs[a], block);
+                }
+            }
+        }
+    }
+
+    return units;
+}
+
+static uint8_t fileExists(char *path) {
+    struct stat fileStat;
+    return !stat(path, &fileStat);
+}
+
+// creates the file only if it doesn't exist, atomically even on a shared filesystem, with text in it
+static uint8_t createExclusive(char *path, char *text) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return 1;
+    }
+    uint8_t error = write(fd, text, strlen(text)) != (ssize_t) strlen(text);
+    return close(fd) || error;
+}
+
+// reads the host and the pid of the shard that holds the lock at path
+static uint8_t readLock(char *path, char *lockHost, int *lockPid) {
+    FILE *lock = fopen(path, "r");
+    if (!lock) {
+        return 1;
+    }
+    uint8_t parsed = fscanf(lock, "%255s %d", lockHost, lockPid) == 2;
+    fclose(lock);
+    return !parsed;
+}
+
+/**
+ * @brief Claims a unit for this shard, with the lock file <unit>.lock holding the host and the pid of the shard
+ *
+ * A lock left by a shard of this host that no longer runs is taken over, through the file <unit>.lock.<pid>, which
+ * only the first shard to find the dead lock can create, and which is removed once the lock is replaced. The locks of
+ * other hosts are never taken over, their shards can't be checked.
+ *
+ * @returns 1 if the unit is claimed, 0 if it is done or another shard has it
+ */
+static uint8_t claimUnit(char *shardPath, ShardUnit *unit, char *host) {
+    char path[PATH_SIZE];
+    snprintf(path, sizeof(path), "%s%s.done", shardPath, unit->name);
+    if (fileExists(path)) {
+        return 0;
+    }
+
+    char owner[512];
+    snprintf(owner, sizeof(owner), "%s %d\n", host, getpid());
+    snprintf(path, sizeof(path), "%s%s.lock", shardPath, unit->name);
+    if (!createExclusive(path, owner)) {
+        return 1;
+    }
+
+    char lockHost[256];
+    int lockPid;
+    if (readLock(path, lockHost, &lockPid) || strcmp(lockHost, host) || !kill(lockPid, 0) || errno != ESRCH) {
+        return 0;
+    }
+
+    char takeover[PATH_SIZE];
+    snprintf(takeover, sizeof(takeover), "%s%s.lock.%d", shardPath, unit->name, lockPid);
+    if (createExclusive(takeover, owner)) {
+        return 0;
+    }
+    // a shard that read the dead lock before it was replaced may only get here once the takeover file is gone, so
+    // the lock has to still be the dead one
+    char currentHost[256];
+    int currentPid;
+    uint8_t claimed = 0;
+    if (!readLock(path, currentHost, &currentPid) && !strcmp(currentHost, lockHost) && currentPid == lockPid) {
+        unlink(path);
+        claimed = !createExclusive(path, owner);
+    }
+    // the takeover file is only needed while the lock is replaced, and left behind it would stop a later takeover of
+    // a lock by a shard with the same pid
+    unlink(takeover);
+    return claimed;
+}
+
+/**
+ * @brief Runs propheticBandits on the unit, in its directory, and marks it done if it succeeds
+ *
+ * @returns 0 on success, 1 if the run failed
+ */
+static uint8_t runUnit(Manifest *manifest, ShardUnit *unit, char *shardPath, char *binary) {
+    char unitPath[PATH_SIZE];
+    snprintf(unitPath, sizeof(unitPath), "%s%s/", shardPath, unit->name);
+    mkdir_p(unitPath);
+
+    char K[16], flags[64], replications[16], seed[32];
+    snprintf(K, sizeof(K), "%u", manifest->K[unit->K]);
+    snprintf(flags, sizeof(flags), "-%s", manifest->algs[unit->algs]);
+    snprintf(replications, sizeof(replications), "%u", unit->replications);
+    // replication i of the experiment has the seed + i, whichever unit runs it
+    snprintf(seed, sizeof(seed), "%lu", manifest->seed + unit->firstReplication);
+
+    char *args[MAX_VALUES + 16];
+    uint32_t argCount = 0;
+    args[argCount++] = binary;
+    for (uint32_t o = 0; o < manifest->optionCount; o++) {
+        args[argCount++] = manifest->options[o];
+    }
+    args[argCount++] = "-n";
+    args[argCount++] = "-t";
+    args[argCount++] = K;
+    args[argCount++] = flags;
+    if (unit->replications) {
+        args[argCount++] = "-R";
+        args[argCount++] = replications;
+    }
+    args[argCount++] = "--seed";
+    args[argCount++] = seed;
+    if (manifest->isModel[unit->data]) {
+        args[argCount++] = "--model";
+    }
+    args[argCount++] = manifest->data[unit->data];
+    args[argCount] = nullptr;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        return 1;
+    } else if (!pid) {
+        // the results go to prophetResults/ inside the directory of the unit, and the output to its log
+        char logPath[PATH_SIZE + 16];
+        snprintf(logPath, sizeof(logPath), "%slog.txt", unitPath);
+        int log = open(logPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log < 0 || chdir(unitPath)) {
+            _exit(127);
+        }
+        dup2(log, STDOUT_FILENO);
+        dup2(log, STDERR_FILENO);
+        close(log);
+        execv(binary, args);
+        _exit(127);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+        return 1;
+    }
+
+    char donePath[PATH_SIZE];
+    snprintf(donePath, sizeof(donePath), "%s%s.done", shardPath, unit->name);
+    return createExclusive(donePath, "");
+}
+
+// goes through the units once, running every one it claims, returns 1 if any of them failed
+static uint8_t runShard(Manifest *manifest, ShardUnit *units, uint32_t unitCount, char *shardPath, char *binary) {
+    char host[256];
+    if (gethostname(host, sizeof(host))) {
+        strcpy(host, "localhost");
+    }
+    host[sizeof(host) - 1] = '\0';
+
+    uint8_t error = 0;
+    for (uint32_t u = 0; u < unitCount; u++) {
+        if (!claimUnit(shardPath, &units[u], host)) {
+            continue;
+        }
+
+        printf("Shard %d: running %s...\n", getpid(), units[u].name);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (runUnit(manifest, &units[u], shardPath, binary)) {
+            // the unit is left to the next shard that is started
+            printf("Error: %s failed, see %s%s/log.txt\n", units[u].name, shardPath, units[u].name);
+            char lockPath[PATH_SIZE];
+            snprintf(lockPath, sizeof(lockPath), "%s%s.lock", shardPath, units[u].name);
+            unlink(lockPath);
+            error = 1;
+            continue;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("Shard %d: finished %s in %.2lf s\n", getpid(), units[u].name,
+               (double) (end.tv_sec - start.tv_sec) + (double) (end.tv_nsec - start.tv_nsec) / 1e9);
+    }
+
+    return error;
+}
+
+static void printStatus(ShardUnit *units, uint32_t unitCount, char *shardPath) {
+    uint32_t done = 0, running = 0;
+    for (uint32_t u = 0; u < unitCount; u++) {
+        char path[PATH_SIZE];
+        snprintf(path, sizeof(path), "%s%s.done", shardPath, units[u].name);
+        char *state = "left";
+        if (fileExists(path)) {
+            state = "done";
+            done++;
+        } else {
+            snprintf(path, sizeof(path), "%s%s.lock", shardPath, units[u].name);
+            if (fileExists(path)) {
+                state = "running";
+                running++;
+            }
+        }
+        printf("%-64s\t%s\n", units[u].name, state);
+    }
+    printf("\n%u units: %u done, %u running, %u left\n", unitCount, done, running, unitCount - done - running);
+}
+
+static void addSource(MergeEntry **entries, uint32_t *count, char *path, char *source) {
+    uint32_t e = 0;
+    while (e < *count && strcmp((*entries)[e].path, path)) {
+        e++;
+    }
+    if (e == *count) {
+        *entries = realloc(*entries, (*count + 1) * sizeof(MergeEntry));
+        (*entries)[e] = (MergeEntry) {0};
+        snprintf((*entries)[e].path, PATH_SIZE, "%s", path);
+        (*count)++;
+    }
+
+    MergeEntry *entry = &(*entries)[e];
+    entry->sources = realloc(entry->sources, (entry->sourceCount + 1) * sizeof(char *));
+    entry->sources[entry->sourceCount++] = strdup(source);
+}
+
+static void freeEntries(MergeEntry *entries, uint32_t count) {
+    for (uint32_t e = 0; e < count; e++) {
+        for (uint32_t s = 0; s < entries[e].sourceCount; s++) {
+            free(entries[e].sources[s]);
+        }
+        free(entries[e].sources);
+    }
+    free(entries);
+}
+
+/**
+ * @brief Adds every file under the results of a unit to the list, path being its place inside prophetResults/
+ *
+ * Every unit of a group has the same result store, only the replications differ, so only the first unit of each
+ * group adds the files that aren't replications.
+ */
+static void collectResults(MergeList *list, char *unitResults, char *path, uint8_t firstUnit) {
+    char directory[PATH_SIZE];
+    snprintf(directory, sizeof(directory), "%s%s", unitResults, path);
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        char child[PATH_SIZE], source[PATH_SIZE];
+        snprintf(child, sizeof(child), "%s%s", path, entry->d_name);
+        snprintf(source, sizeof(source), "%s%s", unitResults, child);
+
+        struct stat fileStat;
+        if (stat(source, &fileStat)) {
+            continue;
+        } else if (S_ISDIR(fileStat.st_mode)) {
+            strcat(child, "/");
+            collectResults(list, unitResults, child, firstUnit);
+            continue;
+        }
+
+        // the replications, <type>R<count>.txt, are keyed by their path without the count
+        uint64_t runs;
+        char end[8] = "";
+        if ((sscanf(entry->d_name, "regretR%lu%7s", &runs, end) == 2 ||
+             sscanf(entry->d_name, "compRatioR%lu%7s", &runs, end) == 2) &&
+            !strcmp(end, ".txt")) {
+            *strrchr(child, 'R') = '\0';
+            addSource(&list->replications, &list->replicationCount, child, source);
+        } else if (!firstUnit) {
+            continue;
+        } else if (!strcmp(entry->d_name, "results.bin")) {
+            addSource(&list->stores, &list->storeCount, child, source);
+        } else {
+            addSource(&list->files, &list->fileCount, child, source);
+        }
+    }
+    closedir(dir);
+}
+
+// reads a file of saveReplicationResults, a "<round> <mean> <variance>" line per round, count being its runs
+static uint8_t readReplications(char *path, uint64_t count, RunningStats *stats, uint64_t *rounds) {
+    *stats = (RunningStats) {0};
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return 1;
+    }
+
+    uint64_t capacity = 1024;
+    *stats = (RunningStats) {count, malloc(capacity * sizeof(double)), malloc(capacity * sizeof(double))};
+    *rounds = 0;
+    uint64_t round;
+    double mean, variance;
+    while (fscanf(file, "%lu %lf %lf", &round, &mean, &variance) == 3) {
+        if (round != *rounds) {
+            break;
+        }
+        if (*rounds == capacity) {
+            capacity *= 2;
+            stats->mean = realloc(stats->mean, capacity * sizeof(double));
+            stats->m2 = realloc(stats->m2, capacity * sizeof(double));
+        }
+        // the file has the sample variance, the stats the sum of squared differences it is made of
+        stats->mean[*rounds] = mean;
+        stats->m2[*rounds] = count > 1 ? variance * (double) (count - 1) : 0;
+        (*rounds)++;
+    }
+    uint8_t error = !feof(file) || !*rounds;
+    fclose(file);
+    return error;
+}
+
+// pools the replications of every unit of a file into prophetResults/<path>R<total>.txt
+static uint8_t mergeReplications(MergeEntry *entry) {
+    RunningStats total = {0};
+    uint64_t totalRounds = 0;
+    uint8_t error = 0;
+    for (uint32_t s = 0; s < entry->sourceCount && !error; s++) {
+        uint64_t runs;
+        sscanf(strrchr(entry->sources[s], 'R'), "R%lu", &runs);
+
+        RunningStats stats;
+        uint64_t rounds;
+        error = readReplications(entry->sources[s], runs, &stats, &rounds);
+        if (!error && !s) {
+            total = stats;
+            totalRounds = rounds;
+            continue;
+        }
+        error = error || rounds != totalRounds;
+        if (!error) {
+            mergeRunningStats(&total, &stats, totalRounds);
+        }
+        freeRunningStats(&stats);
+    }
+
+    if (!error) {
+        char path[PATH_SIZE + 64];
+        snprintf(path, sizeof(path), "prophetResults/%s", entry->path);
+        char *slash = strrchr(path, '/');
+        *slash = '\0';
+        mkdir_p(path);
+        *slash = '/';
+        snprintf(path + strlen(path), 64, "R%lu.txt", total.count);
+
+        FILE *file = fopen(path, "w");
+        if (!file) {
+            error = 1;
+        } else {
+            for (uint64_t t = 0; t < totalRounds; t++) {
+                fprintf(file, "%lu %lf %lf\n", t, total.mean[t], getVariance(&total, t));
+            }
+            error = fclose(file) != 0;
+        }
+    }
+    freeRunningStats(&total);
+    return error;
+}
+
+static uint8_t copyFile(char *from, char *to) {
+    FILE *in = fopen(from, "rb");
+    FILE *out = in ? fopen(to, "wb") : nullptr;
+    uint8_t error = !out;
+    char buffer[1 << 16];
+    size_t bytes;
+    while (!error && (bytes = fread(buffer, 1, sizeof(buffer), in))) {
+        error = fwrite(buffer, 1, bytes, out) != bytes;
+    }
+    if (in)
+        fclose(in);
+    if (out)
+        error |= fclose(out) != 0;
+    return error;
+}
+
+static uint8_t mergeUnits(ShardUnit *units, uint32_t unitCount, char *shardPath) {
+    uint32_t left = 0;
+    for (uint32_t u = 0; u < unitCount; u++) {
+        char path[PATH_SIZE + 16];
+        snprintf(path, sizeof(path), "%s%s.done", shardPath, units[u].name);
+        if (!fileExists(path)) {
+            printf("%s isn't done\n", units[u].name);
+            left++;
+        }
+    }
+    if (left) {
+        printf("Error: %u of %u units aren't done, the results are merged once they all are\n", left, unitCount);
+        return 1;
+    }
+
+    MergeList list = {0};
+    for (uint32_t u = 0; u < unitCount; u++) {
+        char unitResults[PATH_SIZE + 32];
+        snprintf(unitResults, sizeof(unitResults), "%s%s/prophetResults/", shardPath, units[u].name);
+        collectResults(&list, unitResults, "", !units[u].firstReplication);
+    }
+
+    uint8_t error = 0;
+    char path[PATH_SIZE + 32];
+    for (uint32_t e = 0; e < list.storeCount; e++) {
+        snprintf(path, sizeof(path), "prophetResults/%s", list.stores[e].path);
+        *strrchr(path, '/') = '\0';
+        mkdir_p(path);
+        snprintf(path, sizeof(path), "prophetResults/%s", list.stores[e].path);
+        if (mergeResultStores(path, list.stores[e].sources, list.stores[e].sourceCount)) {
+            printf("Error: Couldn't merge the result stores of %s\n", path);
+            error = 1;
+        }
+    }
+    for (uint32_t e = 0; e < list.replicationCount; e++) {
+        if (mergeReplications(&list.replications[e])) {
+            printf("Error: Couldn't merge the replications of prophetResults/%s\n", list.replications[e].path);
+            error = 1;
+        }
+    }
+    // anything else is the same in every unit that has it
+    for (uint32_t e = 0; e < list.fileCount; e++) {
+        snprintf(path, sizeof(path), "prophetResults/%s", list.files[e].path);
+        *strrchr(path, '/') = '\0';
+        mkdir_p(path);
+        snprintf(path, sizeof(path), "prophetResults/%s", list.files[e].path);
+        if (copyFile(list.files[e].sources[0], path)) {
+            printf("Error: Couldn't copy %s\n", list.files[e].sources[0]);
+            error = 1;
+        }
+    }
+
+    printf("Merged %u result stores, %u replication files and %u other files of %u units into prophetResults/\n",
+           list.storeCount, list.replicationCount, list.fileCount, unitCount);
+    freeEntries(list.stores, list.storeCount);
+    freeEntries(list.replications, list.replicationCount);
+    freeEntries(list.files, list.fileCount);
+    return error;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        printHelp();
+        return 0;
+    }
+
+    uint32_t processes = 1;
+    char *binary = nullptr;
+    uint8_t status = 0;
+    uint8_t merging = 0;
+
+    int opt;
+
+    opterr = 0;
+
+    while ((opt = getopt(argc, argv, "hsmp:b:")) != -1) {
+        switch (opt) {
+            case 'h':
+                printHelp();
+                return 0;
+            case 'p':
+                processes = atoi(optarg);
+                break;
+            case 'b':
+                binary = optarg;
+                break;
+            case 's':
+                status = 1;
+                break;
+            case 'm':
+                merging = 1;
+                break;
+            case '?':
+                if (optopt == 'p' || optopt == 'b')
+                    fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+                break;
+            default:
+                abort();
+        }
+    }
+
+    if (optind >= argc) {
+        printf("Error: No manifest provided\n");
+        return 1;
+    }
+    if (!processes) {
+        printf("Error: A shard needs at least 1 process\n");
+        return 1;
+    }
+
+    // propheticBandits is expected next to this binary, unless it is given
+    char binaryPath[PATH_MAX];
+    if (binary) {
+        if (!realpath(binary, binaryPath)) {
+            printf("Error: Couldn't find %s\n", binary);
+            return 1;
+        }
+    } else {
+        ssize_t length = readlink("/proc/self/exe", binaryPath, sizeof(binaryPath) - 1);
+        if (length < 0) {
+            printf("Error: Couldn't find propheticBandits, give it with -b\n");
+            return 1;
+        }
+        binaryPath[length] = '\0';
+        strcpy(strrchr(binaryPath, '/') + 1, "propheticBandits");
+    }
+    if (access(binaryPath, X_OK) && !status && !merging) {
+        printf("Error: %s isn't executable\n", binaryPath);
+        return 1;
+    }
+
+    Manifest manifest;
+    if (loadManifest(argv[optind], &manifest)) {
+        return 1;
+    }
+    uint32_t unitCount;
+    ShardUnit *units = listUnits(&manifest, &unitCount);
+
+    char shardPath[PATH_SIZE];
+    snprintf(shardPath, sizeof(shardPath), SHARD_ROOT "%s/", manifest.name);
+    mkdir_p(shardPath);
+
+    uint8_t error = 0;
+    if (status) {
+        printStatus(units, unitCount, shardPath);
+    } else if (merging) {
+        error = mergeUnits(units, unitCount, shardPath);
+    } else if (processes == 1) {
+        error = runShard(&manifest, units, unitCount, shardPath, binaryPath);
+    } else {
+        // every process is a shard of its own, the locks keep them from running the same unit
+        printf("Starting %u shards for %u units...\n", processes, unitCount);
+        fflush(stdout);
+        for (uint32_t p = 0; p < processes; p++) {
+            pid_t pid = fork();
+            if (!pid) {
+                exit(runShard(&manifest, units, unitCount, shardPath, binaryPath));
+            } else if (pid < 0) {
+                printf("Error: Couldn't start shard %u\n", p);
+                error = 1;
+            }
+        }
+        int childStatus;
+        pid_t child;
+        while ((child = wait(&childStatus)) > 0 || errno == EINTR) {
+            if (child > 0)
+                error |= !WIFEXITED(childStatus) || WEXITSTATUS(childStatus);
+        }
+    }
+
+    if (!status && !merging) {
+        printf("\n");
+        printStatus(units, unitCount, shardPath);
+    }
+
+    free(units);
+    freeManifest(&manifest);
+    return error;
+}
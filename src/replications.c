@@ -0,0 +1,115 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <banditAlgs.h>
+#include <engine.h>
+#include <replications.h>
+#include <threadPool.h>
+#include <util.h>
+
+/**
+ * @typedef replicationTaskStruct
+ * @brief The arguments shared by every replication task
+ *
+ */
+typedef struct replicationTaskStruct {
+    double *data;
+    double *totalOpt;
+    Bandit b;
+    uint32_t replications;
+    uint32_t ids[ALG_COUNT];
+    RunningStats *regret;
+    RunningStats *compRatio;
+    // one lock per algorithm, held while a run is added to its stats
+    pthread_mutex_t locks[ALG_COUNT];
+} ReplicationTask;
+
+static void runReplication(void *arg, uint32_t i) {
+    ReplicationTask *task = arg;
+    uint32_t id = task->ids[i / task->replications];
+    uint64_t replication = i % task->replications;
+
+    Bandit b = task->b;
+    for (uint32_t other = 0; other < ALG_COUNT; other++) {
+        b.algs[other] = other == id;
+    }
+    b.seed = task->b.seed + replication;
+
+    AlgResults results[ALG_COUNT] = {0};
+    results[id].totalGain = malloc(b.T * sizeof(double));
+    results[id].avgLowThreshold = malloc(b.T * sizeof(double));
+    results[id].avgHighThreshold = malloc(b.T * sizeof(double));
+    results[id].avgTrades = malloc(b.T * sizeof(double));
+
+    runAlgorithms(task->data, task->totalOpt, results, b, nullptr, nullptr);
+
+    // Welford's update, with the regret and competitive ratio calculated on the fly
+    pthread_mutex_lock(&task->locks[id]);
+    RunningStats *regret = &task->regret[id];
+    RunningStats *compRatio = &task->compRatio[id];
+    regret->count++;
+    compRatio->count++;
+    for (uint64_t t = 0; t < b.T; t++) {
+        double value = (task->totalOpt[t] - results[id].totalGain[t]) / (double) (t + 1);
+        double delta = value - regret->mean[t];
+        regret->mean[t] += delta / (double) regret->count;
+        regret->m2[t] += delta * (value - regret->mean[t]);
+
+        value = results[id].totalGain[t] / task->totalOpt[t];
+        delta = value - compRatio->mean[t];
+        compRatio->mean[t] += delta / (double) compRatio->count;
+        compRatio->m2[t] += delta * (value - compRatio->mean[t]);
+    }
+    pthread_mutex_unlock(&task->locks[id]);
+
+    free(results[id].totalGain);
+    free(results[id].avgLowThreshold);
+    free(results[id].avgHighThreshold);
+    free(results[id].avgTrades);
+}
+
+void runReplications(double *data, double *totalOpt, Bandit b, uint32_t replications, uint32_t threads,
+                     RunningStats *regret, RunningStats *compRatio) {
+    ReplicationTask task = {data, totalOpt, b, replications};
+    task.regret = regret;
+    task.compRatio = compRatio;
+    uint32_t algCount = 0;
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        regret[id] = (RunningStats) {0};
+        compRatio[id] = (RunningStats) {0};
+
+        if (b.algs[id] && algorithms[id]->stochastic) {
+            task.ids[algCount++] = id;
+            initRunningStats(&regret[id], b.T);
+            initRunningStats(&compRatio[id], b.T);
+            pthread_mutex_init(&task.locks[id], nullptr);
+        }
+    }
+
+    if (!algCount) {
+        return;
+    }
+
+    printf("Running %u replications of each stochastic algorithm...\n", replications);
+    runTasks(algCount * replications, threads, runReplication, &task);
+
+    printf("\n");
+    printf("----------------------------------REPLICATIONS-----------------------"
+           "-----------\n");
+    printf("Algorithm\t\tRuns\tAverage Regret\t\tCompetitive Ratio\n");
+    for (uint32_t i = 0; i < algCount; i++) {
+        uint32_t id = task.ids[i];
+        double regretWidth = 1.96 * sqrt(getVariance(&regret[id], b.T - 1) / (double) regret[id].count);
+        double compRatioWidth = 1.96 * sqrt(getVariance(&compRatio[id], b.T - 1) / (double) compRatio[id].count);
+        printf("%-16s\t%-4lu\t%-.6lf +- %-.6lf\t%-.6lf +- %-.6lf\n", algorithms[id]->title, regret[id].count,
+               regret[id].mean[b.T - 1], regretWidth, compRatio[id].mean[b.T - 1], compRatioWidth);
+        pthread_mutex_destroy(&task.locks[id]);
+    }
+    printf("---------------------------------------------------------------------"
+           "-----------\n");
+    printf("(+- is the 95%% confidence interval of the mean)\n\n");
+}
@@ -0,0 +1,33 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <reporter.h>
+
+void reportf(Reporter *reporter, const char *format, ...) {
+    if (!reporter)
+        return;
+
+    va_list args, argsCopy;
+    va_start(args, format);
+    va_copy(argsCopy, args);
+
+    // most messages fit on the stack, longer ones are formatted again into a buffer of the right size
+    char buffer[256];
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    if (length >= (int) sizeof(buffer)) {
+        char *text = malloc(length + 1);
+        vsnprintf(text, length + 1, format, argsCopy);
+        reporter->write(reporter->context, text);
+        free(text);
+    } else if (length >= 0) {
+        reporter->write(reporter->context, buffer);
+    }
+
+    va_end(argsCopy);
+    va_end(args);
+}
+
+void writeToStream(void *stream, const char *text) {
+    fputs(text, stream);
+}
@@ -0,0 +1,398 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <memoryPolicy.h>
+#include <metrics.h>
+#include <resultStore.h>
+#include <util.h>
+
+// the first bytes of every result store, "PBRS"
+#define RESULT_STORE_MAGIC 0x53524250u
+#define RESULT_STORE_VERSION 1u
+// columns start on a page of their own
+#define RESULT_COLUMN_ALIGN 4096u
+
+static uint64_t alignColumn(uint64_t offset) {
+    return (offset + RESULT_COLUMN_ALIGN - 1) / RESULT_COLUMN_ALIGN * RESULT_COLUMN_ALIGN;
+}
+
+static uint64_t storedRound(ResultStoreHeader *header, uint64_t row) {
+    uint64_t round = (row + 1) * header->decimation - 1;
+    return round < header->T ? round : header->T - 1;
+}
+
+static void mapStore(ResultStore *store, uint8_t *map, size_t size) {
+    store->map = map;
+    store->size = size;
+    store->header = (ResultStoreHeader *) map;
+    store->columns = (ResultColumn *) (map + sizeof(ResultStoreHeader));
+}
+
+// the derived metrics are calculated straight into their columns, by saveMetrics, name can be the metric alone
+static uint8_t isMetricColumn(const char *name) {
+    const char *slash = strchr(name, '/');
+    const char *metric = slash ? slash + 1 : name;
+    for (uint32_t m = 0; m < METRIC_COUNT; m++) {
+        if (!strcmp(metric, metricNames[m])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// the part of the arena of a column, only the columns that aren't metrics have one
+static uint32_t arenaSlot(ResultStore *store, uint32_t column) {
+    uint32_t slot = 0;
+    for (uint32_t c = 0; c < column; c++) {
+        slot += !isMetricColumn(store->columns[c].name);
+    }
+    return slot;
+}
+
+// every round of the columns that aren't metrics, in a single anonymous mapping
+static void createArena(ResultStore *store, Bandit b, uint32_t columnCount) {
+    uint32_t slots = arenaSlot(store, columnCount);
+    if (!slots) {
+        return;
+    }
+    uint64_t columnBytes = alignColumn(b.T * sizeof(double));
+    size_t size = slots * columnBytes;
+    // the arena is on transparent huge pages unless the policy asks for others, and it is never written before the
+    // algorithms run, so with PLACE_WORKERS each column is first written by the worker of its algorithm
+    MemoryPolicy policy = b.memory;
+    if (policy.pages == PAGES_DEFAULT) {
+        policy.pages = PAGES_TRANSPARENT;
+    }
+    if (policy.placement == PLACE_WORKERS) {
+        policy.placement = PLACE_DEFAULT;
+    }
+    // the memory is zeroed by the kernel, and its pages are only given memory once they are written
+    void *arena = allocMemory(&policy, size, 0);
+    if (!arena) {
+        return;
+    }
+
+    store->arena = arena;
+    store->arenaSize = size;
+    store->arenaStride = columnBytes / sizeof(double);
+}
+
+uint8_t createResultStore(ResultStore *store, char *path, Bandit b, uint64_t decimation, char **names,
+                          uint32_t columnCount) {
+    store->map = nullptr;
+    store->arena = nullptr;
+    if (!decimation) {
+        decimation = 1;
+    }
+
+    for (uint32_t c = 0; c < columnCount; c++) {
+        if (strlen(names[c]) >= RESULT_NAME_SIZE) {
+            return 1;
+        }
+    }
+
+    uint64_t rows = (b.T + decimation - 1) / decimation;
+    uint64_t columnStart = alignColumn(sizeof(ResultStoreHeader) + columnCount * sizeof(ResultColumn));
+    uint64_t columnBytes = alignColumn(rows * sizeof(double));
+    size_t size = columnStart + columnCount * columnBytes;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return 1;
+    }
+    // the file is extended with zeroes, which are only given disk space once they are written
+    if (ftruncate(fd, (off_t) size)) {
+        close(fd);
+        return 1;
+    }
+    uint8_t *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 1;
+    }
+    mapStore(store, map, size);
+
+    ResultStoreHeader *header = store->header;
+    header->magic = RESULT_STORE_MAGIC;
+    header->version = RESULT_STORE_VERSION;
+    header->T = b.T;
+    header->N = b.N;
+    header->K = b.K;
+    header->thresholds = b.thresholds;
+    header->dualThres = b.dualThres;
+    header->dynamicThres = b.dynamicThres;
+    header->keepItems = b.keepItems;
+    header->medianOpt = b.medianOpt;
+    header->bestHandOpt = b.bestHandOpt;
+    header->decimation = decimation;
+    header->rows = rows;
+    header->columnCount = columnCount;
+    header->columnSize = sizeof(ResultColumn);
+
+    for (uint32_t c = 0; c < columnCount; c++) {
+        strcpy(store->columns[c].name, names[c]);
+        store->columns[c].offset = columnStart + c * columnBytes;
+    }
+
+    // with decimation the results are calculated in memory, and only their stored rows are copied to the file
+    if (decimation > 1) {
+        createArena(store, b, columnCount);
+    }
+
+    return 0;
+}
+
+uint8_t openResultStore(ResultStore *store, char *path) {
+    store->map = nullptr;
+    store->arena = nullptr;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    if (size < (off_t) sizeof(ResultStoreHeader)) {
+        close(fd);
+        return 1;
+    }
+    uint8_t *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 1;
+    }
+    mapStore(store, map, size);
+
+    // every column has to be inside the file
+    ResultStoreHeader *header = store->header;
+    uint8_t valid = header->magic == RESULT_STORE_MAGIC && header->version == RESULT_STORE_VERSION &&
+                    header->columnSize == sizeof(ResultColumn) && header->decimation && header->T &&
+                    sizeof(ResultStoreHeader) + header->columnCount * sizeof(ResultColumn) <= (size_t) size;
+    for (uint32_t c = 0; valid && c < header->columnCount; c++) {
+        valid = store->columns[c].offset + header->rows * sizeof(double) <= (size_t) size &&
+                memchr(store->columns[c].name, '\0', RESULT_NAME_SIZE);
+    }
+    if (!valid) {
+        closeResultStore(store);
+        return 1;
+    }
+
+    return 0;
+}
+
+// returns the index of the column, or columnCount if the store has no such column
+static uint32_t findColumn(ResultStore *store, const char *alg, const char *metric) {
+    char name[RESULT_NAME_SIZE];
+    snprintf(name, sizeof(name), "%s/%s", alg, metric);
+    uint32_t c = 0;
+    while (c < store->header->columnCount && strcmp(store->columns[c].name, name)) {
+        c++;
+    }
+
+    return c;
+}
+
+double *getResultColumn(ResultStore *store, char *alg, char *metric) {
+    if (!store->map) {
+        return nullptr;
+    }
+
+    uint32_t c = findColumn(store, alg, metric);
+    return c < store->header->columnCount ? (double *) (store->map + store->columns[c].offset) : nullptr;
+}
+
+static uint8_t inArena(ResultStore *store, double *values) {
+    return store->arena && values >= store->arena && (uint8_t *) values < (uint8_t *) store->arena + store->arenaSize;
+}
+
+double *allocResult(ResultStore *store, char *alg, char *metric, uint64_t size) {
+    double *column = getResultColumn(store, alg, metric);
+    if (column && store->header->decimation == 1) {
+        return column;
+    }
+
+    if (column && store->arena && size <= store->arenaStride && !isMetricColumn(metric)) {
+        return store->arena + arenaSlot(store, findColumn(store, alg, metric)) * store->arenaStride;
+    }
+
+    return calloc(size, sizeof(double));
+}
+
+void releaseResult(ResultStore *store, char *alg, char *metric, double *values) {
+    double *column = getResultColumn(store, alg, metric);
+    if (!values || values == column) {
+        return;
+    }
+
+    if (column) {
+        for (uint64_t row = 0; row < store->header->rows; row++) {
+            column[row] = values[storedRound(store->header, row)];
+        }
+    }
+    // the arena is only unmapped with the store
+    if (!inArena(store, values)) {
+        free(values);
+    }
+}
+
+void saveMetrics(ResultStore *store, char *alg, const MetricSource *source) {
+    if (!store->map) {
+        return;
+    }
+
+    double *columns[METRIC_COUNT];
+    for (uint32_t m = 0; m < METRIC_COUNT; m++) {
+        uint32_t c = findColumn(store, alg, metricNames[m]);
+        columns[m] = c < store->header->columnCount ? (double *) (store->map + store->columns[c].offset) : nullptr;
+    }
+
+    ResultStoreHeader *header = store->header;
+    if (header->decimation == 1) {
+        getMetrics(source, 0, header->T, columns);
+        return;
+    }
+
+    // only the stored rounds are calculated
+    for (uint64_t row = 0; row < header->rows; row++) {
+        uint64_t round = storedRound(header, row);
+        for (uint32_t m = 0; m < METRIC_COUNT; m++) {
+            if (columns[m])
+                columns[m][row] = getMetric(source, m, round);
+        }
+    }
+}
+
+void closeResultStore(ResultStore *store) {
+    if (store->map) {
+        munmap(store->map, store->size);
+        store->map = nullptr;
+    }
+    if (store->arena) {
+        freeMemory(store->arena);
+        store->arena = nullptr;
+    }
+}
+
+// the fields of the header that describe the run, everything but the columns
+static uint8_t isSameRun(ResultStoreHeader *a, ResultStoreHeader *b) {
+    return a->T == b->T && a->N == b->N && a->K == b->K && a->thresholds == b->thresholds &&
+           a->dualThres == b->dualThres && a->dynamicThres == b->dynamicThres && a->keepItems == b->keepItems &&
+           a->medianOpt == b->medianOpt && a->bestHandOpt == b->bestHandOpt && a->decimation == b->decimation &&
+           a->rows == b->rows;
+}
+
+uint8_t mergeResultStores(char *path, char **sources, uint32_t sourceCount) {
+    if (!sourceCount) {
+        return 1;
+    }
+
+    ResultStore *stores = calloc(sourceCount, sizeof(ResultStore));
+    uint8_t error = 0;
+    uint32_t opened = 0;
+    for (; opened < sourceCount && !error; opened++) {
+        error = openResultStore(&stores[opened], sources[opened]) ||
+                !isSameRun(stores[0].header, stores[opened].header);
+    }
+
+    // every name once, in the order of the sources, with the store and the column it is copied from
+    uint32_t maxColumns = 0;
+    for (uint32_t s = 0; s < opened && !error; s++) {
+        maxColumns += stores[s].header->columnCount;
+    }
+    char **names = malloc((maxColumns ? maxColumns : 1) * sizeof(char *));
+    double **rows = malloc((maxColumns ? maxColumns : 1) * sizeof(double *));
+    uint32_t columnCount = 0;
+    for (uint32_t s = 0; s < opened && !error; s++) {
+        for (uint32_t c = 0; c < stores[s].header->columnCount; c++) {
+            char *name = stores[s].columns[c].name;
+            uint32_t found = 0;
+            while (found < columnCount && strcmp(names[found], name)) {
+                found++;
+            }
+            if (found == columnCount) {
+                names[columnCount] = name;
+                rows[columnCount++] = (double *) (stores[s].map + stores[s].columns[c].offset);
+            }
+        }
+    }
+
+    if (!error) {
+        ResultStoreHeader *header = stores[0].header;
+        Bandit b = {.T = header->T,
+                    .N = header->N,
+                    .K = header->K,
+                    .thresholds = header->thresholds,
+                    .dualThres = header->dualThres,
+                    .dynamicThres = header->dynamicThres,
+                    .keepItems = header->keepItems,
+                    .medianOpt = header->medianOpt,
+                    .bestHandOpt = header->bestHandOpt};
+        ResultStore merged;
+        error = createResultStore(&merged, path, b, header->decimation, names, columnCount);
+        for (uint32_t c = 0; c < columnCount && !error; c++) {
+            memcpy(merged.map + merged.columns[c].offset, rows[c], header->rows * sizeof(double));
+        }
+        if (!error) {
+            closeResultStore(&merged);
+        }
+    }
+
+    for (uint32_t s = 0; s < opened; s++) {
+        closeResultStore(&stores[s]);
+    }
+    free(names);
+    free(rows);
+    free(stores);
+    return error;
+}
+
+uint8_t exportResultStore(char *path) {
+    ResultStore store;
+    if (openResultStore(&store, path)) {
+        return 1;
+    }
+
+    // the text files go next to the store, in the directories of the algorithms
+    char directory[256];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char *slash = strrchr(directory, '/');
+    if (slash) {
+        slash[1] = '\0';
+    } else {
+        directory[0] = '\0';
+    }
+
+    uint8_t error = 0;
+    for (uint32_t c = 0; c < store.header->columnCount && !error; c++) {
+        char alg[RESULT_NAME_SIZE];
+        strcpy(alg, store.columns[c].name);
+        char *metric = strchr(alg, '/');
+        if (!metric) {
+            continue;
+        }
+        *metric++ = '\0';
+
+        char filePath[512];
+        snprintf(filePath, sizeof(filePath), "%s%s", directory, alg);
+        mkdir_p(filePath);
+        snprintf(filePath, sizeof(filePath), "%s%s/%s.txt", directory, alg, metric);
+
+        FILE *file = fopen(filePath, "w");
+        if (!file) {
+            error = 1;
+            break;
+        }
+        double *column = (double *) (store.map + store.columns[c].offset);
+        for (uint64_t row = 0; row < store.header->rows; row++) {
+            fprintf(file, "%lu %lf\n", storedRound(store.header, row), column[row]);
+        }
+        error = fclose(file) != 0;
+    }
+
+    closeResultStore(&store);
+    return error;
+}
@@ -0,0 +1,326 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_rng.h>
+#include <sampler.h>
+
+// the samples drawn together, whose random bits are kept on the stack
+#define SAMPLER_BLOCK 512
+#define ZIGGURAT_LAYERS 256
+
+// where the tail starts and the area of every layer, for 256 layers
+#define NORMAL_TAIL 3.6541528853610088
+#define NORMAL_AREA 4.92867323399e-3
+#define EXP_TAIL 7.69711747013104972
+#define EXP_AREA 3.949659822581572e-3
+
+/**
+ * @typedef zigguratStruct
+ * @brief The layers of equal area a density is covered with, from the base, which holds the tail, to the top
+ *
+ */
+typedef struct zigguratStruct {
+    // the right edge of every layer, except x[0], the width of a rectangle with the area of the base layer
+    double x[ZIGGURAT_LAYERS + 1];
+    // the density at each edge
+    double f[ZIGGURAT_LAYERS + 1];
+    // the part of each layer that is under the density all the way up, x[i + 1] / x[i]
+    double inner[ZIGGURAT_LAYERS];
+} Ziggurat;
+
+static Ziggurat normalZiggurat;
+static Ziggurat expZiggurat;
+static pthread_once_t zigguratsBuilt = PTHREAD_ONCE_INIT;
+
+static double normalDensity(double x) {
+    return exp(-0.5 * x * x);
+}
+
+static double normalInverse(double y) {
+    return sqrt(-2 * log(y));
+}
+
+static double expDensity(double x) {
+    return exp(-x);
+}
+
+static double expInverse(double y) {
+    return -log(y);
+}
+
+static void buildZiggurat(Ziggurat *z, double tail, double area, double (*density)(double),
+                          double (*inverse)(double)) {
+    z->x[0] = area / density(tail);
+    z->x[1] = tail;
+    for (uint32_t i = 2; i < ZIGGURAT_LAYERS; i++) {
+        z->x[i] = inverse(area / z->x[i - 1] + density(z->x[i - 1]));
+    }
+    z->x[ZIGGURAT_LAYERS] = 0;
+
+    for (uint32_t i = 0; i <= ZIGGURAT_LAYERS; i++) {
+        z->f[i] = density(z->x[i]);
+    }
+    for (uint32_t i = 0; i < ZIGGURAT_LAYERS; i++) {
+        z->inner[i] = z->x[i + 1] / z->x[i];
+    }
+}
+
+static void buildZiggurats() {
+    buildZiggurat(&normalZiggurat, NORMAL_TAIL, NORMAL_AREA, normalDensity, normalInverse);
+    buildZiggurat(&expZiggurat, EXP_TAIL, EXP_AREA, expDensity, expInverse);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void initSampler(Sampler *sampler, uint64_t seed) {
+    pthread_once(&zigguratsBuilt, buildZiggurats);
+
+    for (uint32_t l = 0; l < SAMPLER_LANES; l++) {
+        for (uint32_t w = 0; w < 4; w++) {
+            sampler->state[w][l] = splitmix64(&seed);
+        }
+    }
+    for (uint32_t w = 0; w < 4; w++) {
+        sampler->single[w] = splitmix64(&seed);
+    }
+    sampler->reference = nullptr;
+}
+
+void initSamplerStream(Sampler *sampler, uint64_t seed, uint64_t stream) {
+    // the stream is mixed into the seed, so the splitmix64 sequences of two streams don't overlap
+    initSampler(sampler, seed ^ splitmix64(&stream));
+}
+
+void initReferenceSampler(Sampler *sampler, gsl_rng *rng) {
+    memset(sampler, 0, sizeof(Sampler));
+    sampler->reference = rng;
+}
+
+// a word of every lane, which the compiler maps onto the widest vector registers the target has
+typedef uint64_t LaneWords __attribute__((vector_size(SAMPLER_LANES * sizeof(uint64_t))));
+
+/**
+ * @brief Fills bits with size random words, rounded up to a multiple of SAMPLER_LANES, every lane giving one word of
+ * each group of SAMPLER_LANES
+ */
+static void nextBits(Sampler *sampler, uint64_t *bits, uint64_t size) {
+    LaneWords s0, s1, s2, s3;
+    memcpy(&s0, sampler->state[0], sizeof(s0));
+    memcpy(&s1, sampler->state[1], sizeof(s1));
+    memcpy(&s2, sampler->state[2], sizeof(s2));
+    memcpy(&s3, sampler->state[3], sizeof(s3));
+
+    // a step of xoshiro256++ in every lane at once
+    for (uint64_t k = 0; k < size; k += SAMPLER_LANES) {
+        LaneWords sum = s0 + s3;
+        LaneWords words = ((sum << 23) | (sum >> 41)) + s0;
+        memcpy(&bits[k], &words, sizeof(words));
+
+        LaneWords t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = (s3 << 45) | (s3 >> 19);
+    }
+
+    memcpy(sampler->state[0], &s0, sizeof(s0));
+    memcpy(sampler->state[1], &s1, sizeof(s1));
+    memcpy(sampler->state[2], &s2, sizeof(s2));
+    memcpy(sampler->state[3], &s3, sizeof(s3));
+}
+
+static uint64_t nextSingle(Sampler *sampler) {
+    uint64_t *s = sampler->single;
+    uint64_t bits = rotl(s[0] + s[3], 23) + s[0];
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return bits;
+}
+
+// the high 52 bits become the mantissa of a double in [1,2) or [2,4), which needs no conversion of an integer
+static inline double unitFromBits(uint64_t bits) {
+    uint64_t word = bits >> 12 | 0x3ff0000000000000ull;
+    double value;
+    memcpy(&value, &word, sizeof(value));
+    return value - 1;
+}
+
+static inline double signedUnitFromBits(uint64_t bits) {
+    uint64_t word = bits >> 12 | 0x4000000000000000ull;
+    double value;
+    memcpy(&value, &word, sizeof(value));
+    return value - 3;
+}
+
+/**
+ * @brief Finishes a normal sample whose bits the fast path rejected, with the bits' layer and position first
+ *
+ * The low 8 bits are the layer and the high 52 bits the position in it, so they don't overlap.
+ */
+static double normalFrom(Sampler *sampler, uint64_t bits) {
+    const Ziggurat *z = &normalZiggurat;
+    while (1) {
+        uint32_t layer = bits & 0xff;
+        double u = signedUnitFromBits(bits);
+        double x = u * z->x[layer];
+        if (fabs(u) < z->inner[layer]) {
+            return x;
+        }
+
+        if (layer == 0) {
+            // the tail beyond NORMAL_TAIL, with Marsaglia's method
+            double tailX, tailY;
+            do {
+                tailX = -log(1 - unitFromBits(nextSingle(sampler))) / NORMAL_TAIL;
+                tailY = -log(1 - unitFromBits(nextSingle(sampler)));
+            } while (tailY + tailY < tailX * tailX);
+            return u < 0 ? -(NORMAL_TAIL + tailX) : NORMAL_TAIL + tailX;
+        }
+
+        // the wedge between the layer's inner part and the density
+        double y = z->f[layer] + unitFromBits(nextSingle(sampler)) * (z->f[layer + 1] - z->f[layer]);
+        if (y < normalDensity(x)) {
+            return x;
+        }
+        bits = nextSingle(sampler);
+    }
+}
+
+static double exponentialFrom(Sampler *sampler, uint64_t bits) {
+    const Ziggurat *z = &expZiggurat;
+    while (1) {
+        uint32_t layer = bits & 0xff;
+        double u = unitFromBits(bits);
+        double x = u * z->x[layer];
+        if (u < z->inner[layer]) {
+            return x;
+        }
+
+        if (layer == 0) {
+            // the exponential has no memory, so the tail is the distribution again, moved by EXP_TAIL
+            return EXP_TAIL - log(1 - unitFromBits(nextSingle(sampler)));
+        }
+
+        double y = z->f[layer] + unitFromBits(nextSingle(sampler)) * (z->f[layer + 1] - z->f[layer]);
+        if (y < expDensity(x)) {
+            return x;
+        }
+        bits = nextSingle(sampler);
+    }
+}
+
+void fillUniform(Sampler *sampler, double *values, uint64_t size) {
+    if (sampler->reference) {
+        for (uint64_t i = 0; i < size; i++) {
+            values[i] = gsl_rng_uniform(sampler->reference);
+        }
+        return;
+    }
+
+    uint64_t bits[SAMPLER_BLOCK];
+    for (uint64_t start = 0; start < size; start += SAMPLER_BLOCK) {
+        uint64_t count = size - start < SAMPLER_BLOCK ? size - start : SAMPLER_BLOCK;
+        nextBits(sampler, bits, count);
+        for (uint64_t i = 0; i < count; i++) {
+            values[start + i] = unitFromBits(bits[i]);
+        }
+    }
+}
+
+void fillNormal(Sampler *sampler, double *values, uint64_t size) {
+    if (sampler->reference) {
+        for (uint64_t i = 0; i < size; i++) {
+            values[i] = gsl_ran_gaussian(sampler->reference, 1);
+        }
+        return;
+    }
+
+    const Ziggurat *z = &normalZiggurat;
+    uint64_t bits[SAMPLER_BLOCK];
+    uint32_t rejected[SAMPLER_BLOCK];
+    for (uint64_t start = 0; start < size; start += SAMPLER_BLOCK) {
+        uint64_t count = size - start < SAMPLER_BLOCK ? size - start : SAMPLER_BLOCK;
+        nextBits(sampler, bits, count);
+
+        // the fast path for every sample, the rejected ones are only noted
+        uint32_t rejectedCount = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            uint32_t layer = bits[i] & 0xff;
+            double u = signedUnitFromBits(bits[i]);
+            values[start + i] = u * z->x[layer];
+            rejected[rejectedCount] = i;
+            rejectedCount += !(fabs(u) < z->inner[layer]);
+        }
+
+        for (uint32_t r = 0; r < rejectedCount; r++) {
+            values[start + rejected[r]] = normalFrom(sampler, bits[rejected[r]]);
+        }
+    }
+}
+
+void fillExponential(Sampler *sampler, double *values, uint64_t size) {
+    if (sampler->reference) {
+        for (uint64_t i = 0; i < size; i++) {
+            values[i] = gsl_ran_exponential(sampler->reference, 1);
+        }
+        return;
+    }
+
+    const Ziggurat *z = &expZiggurat;
+    uint64_t bits[SAMPLER_BLOCK];
+    uint32_t rejected[SAMPLER_BLOCK];
+    for (uint64_t start = 0; start < size; start += SAMPLER_BLOCK) {
+        uint64_t count = size - start < SAMPLER_BLOCK ? size - start : SAMPLER_BLOCK;
+        nextBits(sampler, bits, count);
+
+        uint32_t rejectedCount = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            uint32_t layer = bits[i] & 0xff;
+            double u = unitFromBits(bits[i]);
+            values[start + i] = u * z->x[layer];
+            rejected[rejectedCount] = i;
+            rejectedCount += !(u < z->inner[layer]);
+        }
+
+        for (uint32_t r = 0; r < rejectedCount; r++) {
+            values[start + rejected[r]] = exponentialFrom(sampler, bits[rejected[r]]);
+        }
+    }
+}
+
+double sampleUniform(Sampler *sampler) {
+    if (sampler->reference)
+        return gsl_rng_uniform(sampler->reference);
+    return unitFromBits(nextSingle(sampler));
+}
+
+double sampleNormal(Sampler *sampler) {
+    if (sampler->reference)
+        return gsl_ran_gaussian(sampler->reference, 1);
+    return normalFrom(sampler, nextSingle(sampler));
+}
+
+double sampleExponential(Sampler *sampler) {
+    if (sampler->reference)
+        return gsl_ran_exponential(sampler->reference, 1);
+    return exponentialFrom(sampler, nextSingle(sampler));
+}
@@ -0,0 +1,86 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include <armSpace.h>
+#include <banditAlgs.h>
+#include <reporter.h>
+#include <session.h>
+#include <util.h>
+
+static void startRound(Session *session) {
+    session->th = session->alg->select(session->state, &session->arms, session->b, session->round);
+    uint32_t slot = playArm(&session->arms, session->th);
+    session->low = session->arms.played[slot].low;
+    session->high = session->arms.played[slot].high;
+}
+
+static void endRound(Session *session) {
+    // the same statistics runRound keeps
+    addReward(&session->arms.played[armSlot(&session->arms, session->th)], session->roundGain);
+    if (session->alg->update)
+        session->alg->update(session->state, &session->arms, session->b, session->th, session->roundGain,
+                             session->round);
+
+    session->totalGain += session->roundGain;
+    session->roundGain = 0;
+    session->price = 0;
+    session->round++;
+    startRound(session);
+}
+
+uint8_t initSession(Session *session, uint32_t id, Bandit b, double priceMin, double priceMax, Reporter *reporter) {
+    if (id >= ALG_COUNT || !algorithms[id]->online) {
+        reportf(reporter, "Error: %s can't run on a live feed\n",
+                id < ALG_COUNT ? algorithms[id]->title : "The algorithm");
+        return 1;
+    } else if (b.dynamicThres) {
+        reportf(reporter,
+                "Error: Dynamic thresholds need the prices of the first round before the feed starts\n");
+        return 1;
+    } else if (!b.T || !b.N || !b.K || priceMax <= priceMin) {
+        reportf(reporter,
+                "Error: A session needs a horizon, prices per round, thresholds and a range of prices\n");
+        return 1;
+    }
+
+    session->alg = algorithms[id];
+    session->b = b;
+    session->priceMin = priceMin;
+    session->priceMax = priceMax;
+    session->round = 0;
+    session->price = 0;
+    session->roundGain = 0;
+    session->totalGain = 0;
+    session->heldItems = 0;
+    session->heldItemValue = 0;
+
+    // without dynamic thresholds the arm space and the algorithms never look at the data
+    initArmSpace(&session->arms, b, nullptr, session->alg->armStateSize);
+    reserveArms(&session->arms, b.K);
+    session->state = session->alg->init(&session->arms, b, nullptr);
+    startRound(session);
+
+    return 0;
+}
+
+uint8_t observe(Session *session, double price) {
+    // the same normalization as normalizePrices, so a replayed file is traded exactly like the offline run
+    double normalized = (price - session->priceMin) / (session->priceMax - session->priceMin);
+    uint8_t lastPrice = session->price == session->b.N - 1 &&
+                        (!session->b.keepItems || session->round == session->b.T - 1);
+
+    uint8_t action = tradePrice(normalized, session->low, session->high, lastPrice, &session->heldItems,
+                                &session->heldItemValue, &session->roundGain);
+
+    if (++session->price == session->b.N) {
+        endRound(session);
+    }
+
+    return action;
+}
+
+void freeSession(Session *session) {
+    if (session->alg->free)
+        session->alg->free(session->state);
+    freeArmSpace(&session->arms);
+}
@@ -0,0 +1,372 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <banditAlgs.h>
+#include <engine.h>
+#include <metrics.h>
+#include <output.h>
+#include <reporter.h>
+#include <resultStore.h>
+#include <sweep.h>
+#include <threadPool.h>
+#include <util.h>
+
+/**
+ * @typedef sweepPointStruct
+ * @brief One combination of the swept values, and what running it produced
+ *
+ */
+typedef struct sweepPointStruct {
+    Bandit b;
+    // the number of thresholds before it is turned into pairs by -d
+    uint32_t thresholds;
+    // the error that keeps the point from running, nullptr if it is valid
+    char *error;
+    // roughly proportional to the time the point takes to run
+    uint64_t cost;
+    char *report;
+    size_t reportSize;
+    double finalRegret[ALG_COUNT];
+    double finalCompRatio[ALG_COUNT];
+} SweepPoint;
+
+/**
+ * @typedef sweepTaskStruct
+ * @brief The arguments shared by every sweep task
+ *
+ */
+typedef struct sweepTaskStruct {
+    double *data;
+    // nullptr if every point calculates its own OPT
+    double *totalOpt;
+    char *filepath;
+    uint64_t decimation;
+    // the points in the order they are run
+    SweepPoint **order;
+} SweepTask;
+
+static uint8_t addValues(char *values, double **array, uint32_t *count) {
+    char *save;
+    for (char *value = strtok_r(values, ",", &save); value; value = strtok_r(nullptr, ",", &save)) {
+        char *end;
+        double number = strtod(value, &end);
+        if (end == value || *end != '\0' || number <= 0) {
+            printf("Error: Invalid sweep value \"%s\"\n", value);
+            return 1;
+        }
+
+        *array = realloc(*array, (*count + 1) * sizeof(double));
+        (*array)[(*count)++] = number;
+    }
+
+    return 0;
+}
+
+uint8_t addSweepParam(Sweep *sweep, char *param) {
+    char *values = strchr(param, '=');
+    if (!values) {
+        printf("Error: Sweep parameters are given as <name>=<value>,<value>,...\n");
+        return 1;
+    }
+    *values++ = '\0';
+
+    if (!strcmp(param, "K")) {
+        double *K = nullptr;
+        uint32_t count = 0;
+        if (addValues(values, &K, &count)) {
+            free(K);
+            return 1;
+        }
+
+        sweep->K = realloc(sweep->K, (sweep->KCount + count) * sizeof(uint32_t));
+        for (uint32_t i = 0; i < count; i++) {
+            sweep->K[sweep->KCount++] = (uint32_t) K[i];
+        }
+        free(K);
+        return 0;
+    } else if (!strcmp(param, "ucb2Alpha")) {
+        return addValues(values, &sweep->ucb2Alpha, &sweep->ucb2AlphaCount);
+    } else if (!strcmp(param, "eGreedyScale")) {
+        return addValues(values, &sweep->eGreedyScale, &sweep->eGreedyScaleCount);
+    } else if (!strcmp(param, "exp3UpperBound")) {
+        return addValues(values, &sweep->exp3UpperBound, &sweep->exp3UpperBoundCount);
+    } else if (!strcmp(param, "swUcbWindow")) {
+        double *window = nullptr;
+        uint32_t count = 0;
+        if (addValues(values, &window, &count)) {
+            free(window);
+            return 1;
+        }
+
+        sweep->swUcbWindow = realloc(sweep->swUcbWindow, (sweep->swUcbWindowCount + count) * sizeof(uint64_t));
+        for (uint32_t i = 0; i < count; i++) {
+            sweep->swUcbWindow[sweep->swUcbWindowCount++] = (uint64_t) window[i];
+        }
+        free(window);
+        return 0;
+    } else if (!strcmp(param, "dUcbDiscount")) {
+        uint32_t first = sweep->dUcbDiscountCount;
+        if (addValues(values, &sweep->dUcbDiscount, &sweep->dUcbDiscountCount)) {
+            return 1;
+        }
+
+        for (uint32_t i = first; i < sweep->dUcbDiscountCount; i++) {
+            if (sweep->dUcbDiscount[i] >= 1) {
+                printf("Error: The discount has to be less than 1\n");
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    printf("Error: Unknown sweep parameter \"%s\"\n", param);
+    return 1;
+}
+
+void freeSweep(Sweep *sweep) {
+    free(sweep->K);
+    free(sweep->ucb2Alpha);
+    free(sweep->eGreedyScale);
+    free(sweep->exp3UpperBound);
+    free(sweep->swUcbWindow);
+    free(sweep->dUcbDiscount);
+}
+
+static int compareCost(const void *a, const void *b) {
+    const SweepPoint *pointA = *(SweepPoint *const *) a;
+    const SweepPoint *pointB = *(SweepPoint *const *) b;
+
+    // most expensive first
+    return (pointA->cost < pointB->cost) - (pointA->cost > pointB->cost);
+}
+
+static void runSweepPoint(void *arg, uint32_t i) {
+    SweepTask *task = arg;
+    SweepPoint *point = task->order[i];
+    Bandit b = point->b;
+
+    FILE *out = open_memstream(&point->report, &point->reportSize);
+    Reporter reporter = {writeToStream, out};
+
+    // best hand depends on the thresholds, so it can't be shared between points
+    double *totalOpt = task->totalOpt;
+    double *optAvgLowThres = nullptr;
+    double *optAvgHighThres = nullptr;
+    double *optAvgTrades = nullptr;
+    if (!totalOpt) {
+        totalOpt = malloc(b.T * sizeof(double));
+        optAvgLowThres = malloc(b.T * sizeof(double));
+        optAvgHighThres = malloc(b.T * sizeof(double));
+        optAvgTrades = malloc(b.T * sizeof(double));
+        bestHand(task->data, totalOpt, optAvgLowThres, optAvgHighThres, optAvgTrades, b, &reporter);
+    }
+
+    // the OPT may be shared with other points, so only the algorithms have columns
+    ResultStore store = {0};
+    if (createRunStore(&store, task->filepath, b, task->decimation, 0)) {
+        reportf(&reporter, "Error: Couldn't create the result store, the results won't be saved\n");
+    }
+
+    AlgResults results[ALG_COUNT] = {0};
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (b.algs[id]) {
+            char *name = algorithms[id]->name;
+            results[id].totalGain = allocResult(&store, name, "totalGain", b.T);
+            results[id].avgLowThreshold = allocResult(&store, name, "avgLowThreshold", b.T);
+            results[id].avgHighThreshold = allocResult(&store, name, "avgHighThreshold", b.T);
+            results[id].avgTrades = allocResult(&store, name, "avgTrades", b.T);
+        }
+    }
+
+    runAlgorithms(task->data, totalOpt, results, b, &reporter, nullptr);
+    fclose(out);
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        if (!b.algs[id])
+            continue;
+
+        // the metrics are only calculated for the last round and the saved rounds
+        MetricSource source = {results[id].totalGain, totalOpt, results[id].avgTrades};
+        point->finalRegret[id] = getMetric(&source, METRIC_REGRET, b.T - 1);
+        point->finalCompRatio[id] = getMetric(&source, METRIC_COMP_RATIO, b.T - 1);
+
+        char *name = algorithms[id]->name;
+        saveMetrics(&store, name, &source);
+        releaseResult(&store, name, "totalGain", results[id].totalGain);
+        releaseResult(&store, name, "avgLowThreshold", results[id].avgLowThreshold);
+        releaseResult(&store, name, "avgHighThreshold", results[id].avgHighThreshold);
+        releaseResult(&store, name, "avgTrades", results[id].avgTrades);
+    }
+    closeResultStore(&store);
+
+    if (totalOpt != task->totalOpt) {
+        free(totalOpt);
+        free(optAvgLowThres);
+        free(optAvgHighThres);
+        free(optAvgTrades);
+    }
+}
+
+void runSweep(double *data, char *filepath, Bandit b, Sweep *sweep, uint32_t threads, uint64_t decimation) {
+    // a parameter that isn't swept has the single value of the command line
+    uint32_t KCount = sweep->KCount ? sweep->KCount : 1;
+    uint32_t alphaCount = sweep->ucb2AlphaCount ? sweep->ucb2AlphaCount : 1;
+    uint32_t scaleCount = sweep->eGreedyScaleCount ? sweep->eGreedyScaleCount : 1;
+    uint32_t boundCount = sweep->exp3UpperBoundCount ? sweep->exp3UpperBoundCount : 1;
+    uint32_t windowCount = sweep->swUcbWindowCount ? sweep->swUcbWindowCount : 1;
+    uint32_t discountCount = sweep->dUcbDiscountCount ? sweep->dUcbDiscountCount : 1;
+    uint32_t pointCount = KCount * alphaCount * scaleCount * boundCount * windowCount * discountCount;
+
+    // work that doesn't depend on K is done once, before the points are run, unless the caller has done it
+    double dataMedian;
+    double *sortedFirstRound = nullptr;
+    if (b.dynamicThres && !b.sortedFirstRound) {
+        sortedFirstRound = malloc(b.N * sizeof(double));
+        sortFirstRound(b, data, sortedFirstRound);
+        b.sortedFirstRound = sortedFirstRound;
+    }
+    if ((b.algs[ALG_MEDIAN] || b.medianOpt) && !b.dataMedian) {
+        dataMedian = getDataMedian(b, data);
+        b.dataMedian = &dataMedian;
+    }
+
+    Reporter printer = {writeToStream, stdout};
+    printf("Calculating optimal result...\n");
+    double *totalOpt = nullptr;
+    if (!b.bestHandOpt) {
+        totalOpt = malloc(b.T * sizeof(double));
+        double *optAvgLowThres = malloc(b.T * sizeof(double));
+        double *optAvgHighThres = malloc(b.T * sizeof(double));
+        double *optAvgTrades = malloc(b.T * sizeof(double));
+
+        if (!b.medianOpt) {
+            findOpt(data, totalOpt, optAvgTrades, b, &printer);
+        } else {
+            // the median algorithm is run on its own, and its results become OPT
+            Bandit medianBandit = b;
+            for (uint32_t id = 0; id < ALG_COUNT; id++) {
+                medianBandit.algs[id] = id == ALG_MEDIAN;
+            }
+            AlgResults medianResults[ALG_COUNT] = {0};
+            medianResults[ALG_MEDIAN] = (AlgResults) {totalOpt, optAvgLowThres, optAvgHighThres, optAvgTrades};
+            runAlgorithms(data, totalOpt, medianResults, medianBandit, &printer, nullptr);
+        }
+
+        free(optAvgLowThres);
+        free(optAvgHighThres);
+        free(optAvgTrades);
+    }
+
+    SweepPoint *points = calloc(pointCount, sizeof(SweepPoint));
+    SweepPoint **order = malloc(pointCount * sizeof(SweepPoint *));
+    uint32_t runCount = 0;
+
+    for (uint32_t i = 0; i < pointCount; i++) {
+        SweepPoint *point = &points[i];
+        point->b = b;
+
+        // the last parameter changes fastest
+        uint32_t index = i;
+        uint32_t discount = index % discountCount;
+        index /= discountCount;
+        uint32_t window = index % windowCount;
+        index /= windowCount;
+        uint32_t bound = index % boundCount;
+        index /= boundCount;
+        uint32_t scale = index % scaleCount;
+        index /= scaleCount;
+        uint32_t alpha = index % alphaCount;
+        index /= alphaCount;
+
+        point->thresholds = sweep->KCount ? sweep->K[index] : b.thresholds;
+        if (sweep->ucb2AlphaCount)
+            point->b.ucb2Alpha = sweep->ucb2Alpha[alpha];
+        if (sweep->eGreedyScaleCount)
+            point->b.eGreedyScale = sweep->eGreedyScale[scale];
+        if (sweep->exp3UpperBoundCount)
+            point->b.exp3UpperBound = sweep->exp3UpperBound[bound];
+        if (sweep->swUcbWindowCount)
+            point->b.swUcbWindow = sweep->swUcbWindow[window];
+        if (sweep->dUcbDiscountCount)
+            point->b.dUcbDiscount = sweep->dUcbDiscount[discount];
+
+        point->b.thresholds = point->thresholds;
+        point->b.K = b.dualThres ? point->thresholds * (point->thresholds + 1) / 2 : point->thresholds;
+        if (point->b.N < point->b.thresholds) {
+            point->b.dynamicThres = 0;
+        }
+
+        // an algorithm is only run again for the values of the hyperparameters it uses
+        uint32_t algCount = 0;
+        for (uint32_t id = 0; id < ALG_COUNT; id++) {
+            point->b.algs[id] = b.algs[id] && (alpha == 0 || id == ALG_UCB2) && (scale == 0 || id == ALG_EGREEDY) &&
+                                (bound == 0 || id == ALG_EXP3) && (window == 0 || id == ALG_SWUCB) &&
+                                (discount == 0 || id == ALG_DUCB);
+            algCount += point->b.algs[id];
+        }
+
+        if ((point->b.dualThres && point->b.K <= 2) || point->b.K < 1) {
+            point->error = "Too few thresholds";
+        } else if (point->b.K > point->b.T) {
+            point->error = "Too many thresholds";
+        } else if (algCount) {
+            // every round costs about N for the trades and K for picking a threshold, for each algorithm
+            point->cost = (uint64_t) algCount * (point->b.N + point->b.K);
+            order[runCount++] = point;
+        }
+    }
+
+    // cost grows with K, so the largest points are started first and the small ones fill in the gaps at the end
+    qsort(order, runCount, sizeof(SweepPoint *), compareCost);
+
+    printf("Running %u sweep points...\n", runCount);
+    SweepTask task = {data, totalOpt, filepath, decimation, order};
+    runTasks(runCount, threads, runSweepPoint, &task);
+
+    for (uint32_t i = 0; i < pointCount; i++) {
+        SweepPoint *point = &points[i];
+        printf("\n");
+        printf("K = %u, ucb2Alpha = %g, eGreedyScale = %g, exp3UpperBound = %g, swUcbWindow = %lu, dUcbDiscount = %g\n",
+               point->thresholds, point->b.ucb2Alpha, point->b.eGreedyScale,
+               point->b.exp3UpperBound ? point->b.exp3UpperBound : (double) point->b.T, getSwUcbWindow(point->b),
+               getDUcbDiscount(point->b));
+        if (point->error) {
+            printf("Skipped: %s\n", point->error);
+        } else if (point->report) {
+            fwrite(point->report, 1, point->reportSize, stdout);
+            free(point->report);
+        }
+    }
+
+    printf("\n");
+    printf("---------------------------------------------------------SWEEP--------------------"
+           "---------------------------------------------------------\n");
+    printf("K\tucb2Alpha\teGreedyScale\texp3UpperBound\tswUcbWindow\tdUcbDiscount\t%-22s\tAverage Regret\t"
+           "Competitive Ratio\n",
+           "Algorithm");
+    for (uint32_t i = 0; i < pointCount; i++) {
+        SweepPoint *point = &points[i];
+        if (point->error) {
+            continue;
+        }
+
+        for (uint32_t id = 0; id < ALG_COUNT; id++) {
+            if (point->b.algs[id]) {
+                printf("%-4u\t%-9g\t%-12g\t%-14g\t%-11lu\t%-12g\t%-22s\t%-.6lf\t%-.6lf\n", point->thresholds,
+                       point->b.ucb2Alpha, point->b.eGreedyScale,
+                       point->b.exp3UpperBound ? point->b.exp3UpperBound : (double) point->b.T,
+                       getSwUcbWindow(point->b), getDUcbDiscount(point->b), algorithms[id]->title,
+                       point->finalRegret[id], point->finalCompRatio[id]);
+            }
+        }
+    }
+    printf("----------------------------------------------------------------------------------"
+           "---------------------------------------------------------\n\n");
+
+    free(points);
+    free(order);
+    free(totalOpt);
+    free(sortedFirstRound);
+}
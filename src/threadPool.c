@@ -0,0 +1,53 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <threadPool.h>
+
+typedef struct taskQueueStruct {
+    void (*task)(void *arg, uint32_t i);
+    void *arg;
+    uint32_t taskCount;
+    atomic_uint_fast32_t next;
+} TaskQueue;
+
+static void *worker(void *queuePtr) {
+    TaskQueue *queue = queuePtr;
+
+    uint32_t i;
+    while ((i = atomic_fetch_add(&queue->next, 1)) < queue->taskCount) {
+        queue->task(queue->arg, i);
+    }
+
+    return nullptr;
+}
+
+void runTasks(uint32_t taskCount, uint32_t threads, void (*task)(void *arg, uint32_t i), void *arg) {
+    if (threads == 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > taskCount) {
+        threads = taskCount;
+    }
+
+    TaskQueue queue = {task, arg, taskCount, 0};
+
+    // the calling thread is one of the workers
+    pthread_t *workers = malloc(threads * sizeof(pthread_t));
+    uint32_t spawned = 0;
+    for (uint32_t w = 1; w < threads; w++) {
+        if (pthread_create(&workers[spawned], nullptr, worker, &queue) == 0) {
+            spawned++;
+        }
+    }
+
+    worker(&queue);
+
+    for (uint32_t w = 0; w < spawned; w++) {
+        pthread_join(workers[w], nullptr);
+    }
+
+    free(workers);
+}
@@ -0,0 +1,283 @@
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <banditAlgs.h>
+#include <reporter.h>
+#include <timing.h>
+#include <util.h>
+
+uint64_t monotonicNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+const char *counterNames[COUNTER_COUNT] = {
+        [COUNTER_CYCLES] = "cycles",
+        [COUNTER_INSTRUCTIONS] = "instructions",
+        [COUNTER_BRANCH_MISSES] = "branchMisses",
+        [COUNTER_LLC_MISSES] = "llcMisses",
+};
+
+static const uint64_t counterConfigs[COUNTER_COUNT] = {
+        [COUNTER_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+        [COUNTER_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+        [COUNTER_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+        // the generic cache misses event is the misses of the last level cache
+        [COUNTER_LLC_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+};
+
+uint8_t openCounters(Counters *counters, uint8_t inherit) {
+    counters->leader = -1;
+    uint8_t opened = 0;
+
+    for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = counterConfigs[c];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = inherit;
+        // a counter may share the cpu's counters with others, its count is scaled to the whole time it was enabled
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        if (!inherit)
+            attr.read_format |= PERF_FORMAT_GROUP;
+
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, counters->leader, PERF_FLAG_FD_CLOEXEC);
+        counters->fds[c] = fd;
+        if (fd < 0)
+            continue;
+
+        opened = 1;
+        if (!inherit && counters->leader < 0)
+            counters->leader = fd;
+    }
+
+    return !opened;
+}
+
+static uint64_t scaleCount(uint64_t count, uint64_t enabled, uint64_t running) {
+    if (!running)
+        return 0;
+    return enabled == running ? count : (uint64_t) ((double) count * (double) enabled / (double) running);
+}
+
+void readCounters(Counters *counters, uint64_t *counts) {
+    memset(counts, 0, COUNTER_COUNT * sizeof(uint64_t));
+
+    if (counters->leader >= 0) {
+        // the number of counters, the times enabled and running, then the counts in the order they were opened
+        uint64_t values[3 + COUNTER_COUNT];
+        if (read(counters->leader, values, sizeof(values)) < (ssize_t) (3 * sizeof(uint64_t)))
+            return;
+        uint64_t next = 0;
+        for (uint32_t c = 0; c < COUNTER_COUNT && next < values[0]; c++) {
+            if (counters->fds[c] >= 0)
+                counts[c] = scaleCount(values[3 + next++], values[1], values[2]);
+        }
+        return;
+    }
+
+    for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+        uint64_t values[3];
+        if (counters->fds[c] >= 0 && read(counters->fds[c], values, sizeof(values)) == sizeof(values))
+            counts[c] = scaleCount(values[0], values[1], values[2]);
+    }
+}
+
+void closeCounters(Counters *counters) {
+    for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+        if (counters->fds[c] >= 0)
+            close(counters->fds[c]);
+        counters->fds[c] = -1;
+    }
+    counters->leader = -1;
+}
+
+void markPhase(Counters *counters, PhaseMark *mark) {
+    // the counters are read first, so the clock read isn't counted
+    if (counters)
+        readCounters(counters, mark->counts);
+    mark->ns = monotonicNs();
+}
+
+void chargePhase(PhaseTime *phase, Counters *counters, PhaseMark *mark) {
+    uint64_t now = monotonicNs();
+    phase->ns += now - mark->ns;
+    mark->ns = now;
+
+    if (counters) {
+        uint64_t counts[COUNTER_COUNT];
+        readCounters(counters, counts);
+        for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+            phase->counts[c] += counts[c] - mark->counts[c];
+            mark->counts[c] = counts[c];
+        }
+    }
+}
+
+uint8_t startProfiling(Timings *timings, Reporter *reporter) {
+    if (openCounters(&timings->counters, 1)) {
+        reportf(reporter, "Hardware counters are unavailable (%s), only the time is taken\n", strerror(errno));
+        return 1;
+    }
+
+    for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+        if (timings->counters.fds[c] < 0)
+            reportf(reporter, "The %s counter is unavailable\n", counterNames[c]);
+    }
+
+    timings->profiling = 1;
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        timings->algs[id].profile = 1;
+    }
+    return 0;
+}
+
+void stopProfiling(Timings *timings) {
+    if (timings->profiling)
+        closeCounters(&timings->counters);
+    timings->profiling = 0;
+}
+
+static Counters *runCounters(Timings *timings) {
+    return timings->profiling ? &timings->counters : nullptr;
+}
+
+PhaseMark startPhase(Timings *timings) {
+    PhaseMark mark = {0};
+    if (timings)
+        markPhase(runCounters(timings), &mark);
+    return mark;
+}
+
+static PhaseTime *findPhase(Timings *timings, const char *name) {
+    for (uint32_t i = 0; i < timings->phaseCount; i++) {
+        if (!strcmp(timings->phases[i].name, name))
+            return &timings->phases[i];
+    }
+    if (timings->phaseCount == TIMING_PHASES)
+        return nullptr;
+
+    PhaseTime *phase = &timings->phases[timings->phaseCount++];
+    *phase = (PhaseTime) {.name = name};
+    return phase;
+}
+
+void endPhase(Timings *timings, const char *name, PhaseMark start, uint64_t rounds, uint64_t prices, uint64_t bytes) {
+    if (!timings)
+        return;
+
+    PhaseTime *phase = findPhase(timings, name);
+    if (!phase)
+        return;
+    chargePhase(phase, runCounters(timings), &start);
+    phase->rounds += rounds;
+    phase->prices += prices;
+    phase->bytes += bytes;
+}
+
+void chargeTiming(Timings *timings, PhaseTime *phase, PhaseMark *mark) {
+    if (timings)
+        chargePhase(phase, runCounters(timings), mark);
+}
+
+void switchPhase(Timings *timings, const char *name, PhaseMark *start) {
+    if (!timings)
+        return;
+
+    PhaseTime *phase = findPhase(timings, name);
+    if (phase) {
+        chargePhase(phase, runCounters(timings), start);
+    } else {
+        markPhase(runCounters(timings), start);
+    }
+}
+
+static void reportPhase(Reporter *reporter, const char *name, PhaseTime *phase) {
+    double seconds = (double) phase->ns / 1e9;
+    reportf(reporter, "%-24s%12.3lf", name, (double) phase->ns / 1e6);
+    if (phase->rounds && phase->ns)
+        reportf(reporter, "%14.0lf", (double) phase->rounds / seconds);
+    else
+        reportf(reporter, "%14s", "-");
+    if (phase->prices)
+        reportf(reporter, "%12.2lf", (double) phase->ns / (double) phase->prices);
+    else
+        reportf(reporter, "%12s", "-");
+    if (phase->bytes && phase->ns)
+        reportf(reporter, "%12.1lf\n", (double) phase->bytes / seconds / 1e6);
+    else
+        reportf(reporter, "%12s\n", "-");
+}
+
+static void reportCounts(Reporter *reporter, const char *name, PhaseTime *phase, Counters *counters) {
+    reportf(reporter, "%-24s", name);
+    for (uint32_t c = 0; c < COUNTER_COUNT; c++) {
+        if (counters->fds[c] >= 0)
+            reportf(reporter, "%16lu", phase->counts[c]);
+        else
+            reportf(reporter, "%16s", "-");
+    }
+
+    // instructions per cycle, and the cycles spent on each price
+    uint64_t cycles = phase->counts[COUNTER_CYCLES];
+    if (cycles && counters->fds[COUNTER_INSTRUCTIONS] >= 0)
+        reportf(reporter, "%8.2lf", (double) phase->counts[COUNTER_INSTRUCTIONS] / (double) cycles);
+    else
+        reportf(reporter, "%8s", "-");
+    if (cycles && phase->prices)
+        reportf(reporter, "%14.2lf\n", (double) cycles / (double) phase->prices);
+    else
+        reportf(reporter, "%14s\n", "-");
+}
+
+void reportTimings(Timings *timings, Reporter *reporter) {
+    if (!timings)
+        return;
+
+    reportf(reporter, "%-24s%12s%14s%12s%12s\n", "Phase", "Time (ms)", "Rounds/s", "ns/price", "MB/s");
+    for (uint32_t i = 0; i < timings->phaseCount; i++) {
+        reportPhase(reporter, timings->phases[i].name, &timings->phases[i]);
+    }
+
+    char name[64];
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        AlgTiming *alg = &timings->algs[id];
+        if (!alg->run.rounds)
+            continue;
+
+        snprintf(name, sizeof(name), "%s", algorithms[id]->title);
+        reportPhase(reporter, name, &alg->run);
+        snprintf(name, sizeof(name), "%s metrics", algorithms[id]->title);
+        reportPhase(reporter, name, &alg->derive);
+    }
+
+    if (!timings->profiling)
+        return;
+
+    reportf(reporter, "\n%-24s%16s%16s%16s%16s%8s%14s\n", "Phase", "Cycles", "Instructions", "Branch misses",
+            "LLC misses", "IPC", "Cycles/price");
+    for (uint32_t i = 0; i < timings->phaseCount; i++) {
+        reportCounts(reporter, timings->phases[i].name, &timings->phases[i], &timings->counters);
+    }
+
+    for (uint32_t id = 0; id < ALG_COUNT; id++) {
+        AlgTiming *alg = &timings->algs[id];
+        if (!alg->run.rounds)
+            continue;
+
+        snprintf(name, sizeof(name), "%s", algorithms[id]->title);
+        reportCounts(reporter, name, &alg->run, &timings->counters);
+        snprintf(name, sizeof(name), "%s metrics", algorithms[id]->title);
+        reportCounts(reporter, name, &alg->derive, &timings->counters);
+    }
+}
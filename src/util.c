@@ -1,40 +1,42 @@
-#include <libgen.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
+#include <banditAlgs.h>
 #include <gsl/gsl_sort.h>
 #include <util.h>
 
 #include <gsl/gsl_statistics_double.h>
 
-void initThreshold(Threshold *thres, Bandit b, double *data) {
-    double *threshold = malloc(b.thresholds * sizeof(double));
-
+void initThresholdValues(double *threshold, Bandit b, double *data) {
     if (!b.dynamicThres) {
         for (uint32_t th = 0; th < b.thresholds; th++) {
             threshold[th] = (th + 1.0) / (b.thresholds + 1.0);
         }
     } else {
-        double *firstData = malloc(b.N * sizeof(double));
-        memcpy(firstData, data, b.N * sizeof(double));
-        gsl_sort(firstData, 1, b.N);
+        double *firstData = b.sortedFirstRound;
+        if (!firstData) {
+            firstData = malloc(b.N * sizeof(double));
+            sortFirstRound(b, data, firstData);
+        }
         for (uint32_t th = 0; th < b.thresholds; th++) {
             double quantile = (th + 1.0) / (b.thresholds + 1.0);
             threshold[th] = gsl_stats_quantile_from_sorted_data(firstData, 1, b.N, quantile);
         }
-        free(firstData);
+        if (firstData != b.sortedFirstRound) {
+            free(firstData);
+        }
     }
+}
 
+void seedThresholds(Threshold *thres, Bandit b, double *threshold) {
     if (!b.dualThres) {
         for (uint32_t th = 0; th < b.K; th++) {
             thres[th].low = threshold[th];
             thres[th].high = threshold[th];
-            thres[th].rewardSum = 0;
-            thres[th].timesChosen = 0;
-            thres[th].avgReward = 0;
         }
     } else {
         uint32_t th = 0;
@@ -43,22 +45,47 @@ void initThreshold(Threshold *thres, Bandit b, double *data) {
             for (uint32_t h = l; h < b.thresholds; h++) {
                 thres[th].low = threshold[l];
                 thres[th].high = threshold[h];
-                thres[th].rewardSum = 0;
-                thres[th].timesChosen = 0;
-                thres[th].avgReward = 0;
                 th++;
             }
         }
     }
+}
+
+void initThreshold(Threshold *thres, Bandit b, double *data) {
+    double *threshold = malloc(b.thresholds * sizeof(double));
+    initThresholdValues(threshold, b, data);
+
+    seedThresholds(thres, b, threshold);
+    for (uint32_t th = 0; th < b.K; th++) {
+        thres[th].rewardSum = 0;
+        thres[th].timesChosen = 0;
+        thres[th].avgReward = 0;
+    }
 
     free(threshold);
 }
 
-double runRound(Threshold *thres, const uint32_t th, Bandit b, double *data, double *avgLowThreshold,
-                double *avgHighThreshold, double *avgTrades, double *totalGain, const uint64_t round,
-                uint8_t *heldItems, double *heldItemValue) {
-    double low = thres[th].low;
-    double high = thres[th].high;
+void sortFirstRound(Bandit b, double *data, double *sorted) {
+    memcpy(sorted, data, b.N * sizeof(double));
+    gsl_sort(sorted, 1, b.N);
+}
+
+double getDataMedian(Bandit b, double *data) {
+    double *dataCopy = malloc(b.T * b.N * sizeof(double));
+    // GSL rearranges the array, so we need a copy
+    memcpy(dataCopy, data, b.T * b.N * sizeof(double));
+    // GSL my beloved <3
+    double median = gsl_stats_median(dataCopy, 1, b.T * b.N);
+    free(dataCopy);
+
+    return median;
+}
+
+double runRound(Threshold *arm, Bandit b, double *data, double *avgLowThreshold, double *avgHighThreshold,
+                double *avgTrades, double *totalGain, const uint64_t round, uint8_t *heldItems,
+                double *heldItemValue) {
+    double low = arm->low;
+    double high = arm->high;
     uint32_t trades = 0;
 
     if (!b.keepItems) { // extra check
@@ -67,31 +94,30 @@ double runRound(Threshold *thres, const uint32_t th, Bandit b, double *data, dou
     }
 
     double gain = runThreshold(low, high, b, data, &trades, round, heldItems, heldItemValue);
+    recordRound(arm, avgLowThreshold, avgHighThreshold, avgTrades, totalGain, round, gain, trades);
+
+    return gain;
+}
 
+void recordRound(Threshold *arm, double *avgLowThreshold, double *avgHighThreshold, double *avgTrades,
+                 double *totalGain, const uint64_t round, double gain, uint32_t trades) {
     if (round > 0) {
         avgTrades[round] = (avgTrades[round - 1] * (double) round + trades) / ((double) round + 1);
-        avgLowThreshold[round] = (avgLowThreshold[round - 1] * (double) round + thres[th].low) / ((double) round + 1);
-        avgHighThreshold[round] =
-                (avgHighThreshold[round - 1] * (double) round + thres[th].high) / ((double) round + 1);
+        avgLowThreshold[round] = (avgLowThreshold[round - 1] * (double) round + arm->low) / ((double) round + 1);
+        avgHighThreshold[round] = (avgHighThreshold[round - 1] * (double) round + arm->high) / ((double) round + 1);
     } else {
         avgTrades[round] = trades;
-        avgLowThreshold[round] = thres[th].low;
-        avgHighThreshold[round] = thres[th].high;
+        avgLowThreshold[round] = arm->low;
+        avgHighThreshold[round] = arm->high;
     }
 
-    thres[th].rewardSum += gain;
-    thres[th].timesChosen++;
-    if (thres[th].timesChosen != 0) {
-        thres[th].avgReward = thres[th].rewardSum / (double) thres[th].timesChosen;
-    }
+    addReward(arm, gain);
 
     if (round == 0) {
         totalGain[0] = gain;
     } else {
         totalGain[round] = totalGain[round - 1] + gain;
     }
-
-    return gain;
 }
 
 double runThreshold(double low, double high, Bandit b, double *data, uint32_t *trades, const uint64_t round,
@@ -100,456 +126,92 @@ double runThreshold(double low, double high, Bandit b, double *data, uint32_t *t
     *trades = 0;
     for (uint64_t i = round * b.N; i < (round + 1) * b.N; i++) {
         uint8_t lastPrice = (b.keepItems && i == (b.T * b.N - 1)) || (!b.keepItems && ((i + 1) % b.N) == 0);
-        if ((lastPrice || data[i] > high) && *heldItems == 1) {
-            gain += data[i] - *heldItemValue;
-            *heldItems = 0;
-            (*trades)++;
-        } else if (!lastPrice && data[i] <= low && *heldItems == 0) {
-            *heldItemValue = data[i];
-            *heldItems = 1;
-        }
+        *trades += tradePrice(data[i], low, high, lastPrice, heldItems, heldItemValue, &gain) == TRADE_SELL;
     }
 
     return gain;
 }
 
+void addReward(Threshold *arm, double gain) {
+    arm->rewardSum += gain;
+    arm->timesChosen++;
+    if (arm->timesChosen != 0) {
+        arm->avgReward = arm->rewardSum / (double) arm->timesChosen;
+    }
+}
+
 void normalizePrices(double min, double max, double *data, uint64_t size) {
     for (uint64_t t = 0; t < size; t++) {
         data[t] = (data[t] - min) / (max - min);
     }
 }
 
-void getAvgGain(uint64_t size, double *avgGain, double *totalGain) {
-    for (uint64_t i = 0; i < size; i++) {
-        avgGain[i] = totalGain[i] / (double) (i + 1);
+uint8_t loadPrices(char *filepath, double **data, uint64_t *totalRounds, uint64_t *pricesPerRound,
+                   const MemoryPolicy *policy, uint32_t threads) {
+    FILE *file = fopen(filepath, "rb");
+    if (!file) {
+        return 1;
     }
-}
 
-void getAvgRegret(uint64_t totalRounds, double *algAvgRegret, double *totalOpt, double *algGain) {
-    for (uint64_t t = 0; t < totalRounds; t++) {
-        algAvgRegret[t] = (totalOpt[t] - algGain[t]) / (double) (t + 1);
+    // first 2 values are 64bit integers
+    if (!fread(totalRounds, sizeof(uint64_t), 1, file) || !fread(pricesPerRound, sizeof(uint64_t), 1, file) ||
+        !*totalRounds || !*pricesPerRound) {
+        fclose(file);
+        return 1;
     }
-}
 
-void getCompRatio(uint64_t totalRounds, double *algCompRatio, double *totalOpt, double *algGain) {
-    for (uint64_t t = 0; t < totalRounds; t++) {
-        algCompRatio[t] = algGain[t] / totalOpt[t];
+    uint64_t size = *totalRounds * *pricesPerRound;
+    *data = allocMemory(policy, size * sizeof(double), threads);
+    if (!*data || fread(*data, sizeof(double), size, file) != size) {
+        freeMemory(*data);
+        *data = nullptr;
+        fclose(file);
+        return 1;
     }
-}
 
-void getAvgTradeGain(uint64_t totalRounds, double *algGain, double *algAvgTrades, double *algAvgTradeGain) {
-    for (uint64_t t = 0; t < totalRounds; t++) {
-        if (algAvgTrades[t] != 0) {
-            algAvgTradeGain[t] = algGain[t] / (algAvgTrades[t] * (double) (t + 1));
-        } else {
-            algAvgTradeGain[t] = 0;
-        }
-    }
+    fclose(file);
+    return 0;
 }
 
-void plotData(double *data, uint64_t size) {
-    uint32_t step = 1;
-    // bigger step if the dataset is bigger, makes plot way faster
-    if (size > 10000) {
-        step = size / 10000;
-    }
-
-    FILE *gnuplot = popen("gnuplot -persistent", "w");
-    if (!gnuplot) {
-        exit(1);
-    }
-
-    fprintf(gnuplot, "set ylabel 'Price'\n");
-    fprintf(gnuplot, "set grid\n");
-    fprintf(gnuplot, "set yrange [0:1]\n");
-    fprintf(gnuplot, "plot '-' using 1:2 with lines lc rgb 'black' lw 0.5 title 'Price'\n");
-
-    for (int i = 0; i < size; i += step) {
-        fprintf(gnuplot, "%d %lf\n", i, data[i]);
-    }
-    fprintf(gnuplot, "e\n");
-    fflush(gnuplot);
-    pclose(gnuplot);
+void getPriceRange(double *data, uint64_t size, double *min, double *max) {
+    gsl_stats_minmax(min, max, data, 1, size);
+    *min = fmin(*min, 0);
+    *max = fmax(*max, 1);
 }
 
-void plotAlgorithms(char *ylabel, Bandit b, double *opt, double *median, double *greedy, double *eGreedy,
-                    double *succElim, double *ucb1, double *ucb2, double *exp3, uint8_t bounded) {
-    uint32_t step = 1;
-    // bigger step if the dataset is bigger, makes plot way faster
-    if (b.T > 10000) {
-        step = b.T / 10000;
-    }
-
-    FILE *gnuplot = popen("gnuplot -persistent", "w");
-    if (!gnuplot) {
-        exit(1);
-    }
-    fprintf(gnuplot, "set zeroaxis\n");
-    fprintf(gnuplot, "set xlabel 'Rounds'\n");
-    fprintf(gnuplot, "set ylabel '");
-    fprintf(gnuplot, "%s", ylabel);
-    fprintf(gnuplot, "'\n");
-    if (bounded) {
-        fprintf(gnuplot, "set yrange [0 : 1<*]\n");
-        fprintf(gnuplot, "set arrow from graph 0, first 1 to graph 1, first 1 nohead dt 3 lw 1 lc rgb 'black'\n");
-    }
-
-    fprintf(gnuplot, "set grid\n");
-    fprintf(gnuplot, "set key outside\n");
-
-    fprintf(gnuplot, "unset key\n");
-
-    fprintf(gnuplot, "plot ");
-
-    if (opt != NULL) {
-        char *optTitle = "Best Threshold";
-        if (!b.medianOpt && !b.bestHandOpt)
-            optTitle = "OPT";
-        else if (b.medianOpt)
-            optTitle = "Median";
-
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 title '%s', ", optTitle);
-    }
-
-    if (b.median) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'black' pt 8 ps 1 pn 20 lw 1.5 title 'Median', ");
-    }
-
-    if (b.greedy) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'orange' pt 1 ps 1 pn 20 lw 1.5 title 'Greedy', ");
-    }
-
-    if (b.eGreedy) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'red' pt 2 ps 1 pn 20 lw 1.5 title 'eGreedy', ");
-    }
-
-    if (b.succElim) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'cyan' pt 3 ps 1 pn 20 lw 1.5 title "
-                         "'Successive Elimination', ");
-    }
-
-    if (b.ucb1) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'blue' pt 4 ps 1 pn 20 lw 1.5 title 'UCB1', ");
-    }
-
-    if (b.ucb2) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'purple' pt 5 ps 1 pn 20 lw 1.5 title 'UCB2', ");
-    }
-
-    if (b.exp3) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'green' pt 6 ps 1 pn 20 lw 1.5 title 'EXP3', ");
-    }
-
-    fprintf(gnuplot, "\n");
-
-    if (opt != NULL) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, opt[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.median) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, median[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.greedy) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, greedy[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.eGreedy) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, eGreedy[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.succElim) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, succElim[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.ucb1) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, ucb1[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.ucb2) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, ucb2[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.exp3) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, exp3[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    fflush(gnuplot);
-    pclose(gnuplot);
+void initRunningStats(RunningStats *stats, uint64_t size) {
+    stats->count = 0;
+    stats->mean = calloc(size, sizeof(double));
+    stats->m2 = calloc(size, sizeof(double));
 }
 
-void plotThresholds(Bandit b, double *optLow, double *optHigh, double *median, double *greedyLow, double *greedyHigh,
-                    double *eGreedyLow, double *eGreedyHigh, double *succElimLow, double *succElimHigh, double *ucb1Low,
-                    double *ucb1High, double *ucb2Low, double *ucb2High, double *exp3Low, double *exp3High) {
-    uint32_t step = 1;
-    // bigger step if the dataset is bigger, makes plot way faster
-    if (b.T > 10000) {
-        step = b.T / 10000;
-    }
-
-    FILE *gnuplot = popen("gnuplot -persistent", "w");
-    if (!gnuplot) {
-        exit(1);
-    }
-    fprintf(gnuplot, "set xlabel 'Rounds'\n");
-    fprintf(gnuplot, "set ylabel 'Average Threshold'\n");
-    fprintf(gnuplot, "set yrange [0:1]\n");
-    fprintf(gnuplot, "set grid\n");
-    fprintf(gnuplot, "set key outside\n");
-
-    fprintf(gnuplot, "plot ");
-
-    if (b.medianOpt || b.bestHandOpt) {
-        char *optTitle = "Best Threshold";
-        if (b.medianOpt)
-            optTitle = "Median";
-
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 title '%s', ", optTitle);
-        if (b.dualThres && !b.medianOpt)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'black' pt 7 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    if (b.median && !b.medianOpt) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'black' pt 8 ps 1 pn 20 lw 1.5 title 'Median', ");
-    }
-
-    if (b.greedy) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'orange' pt 1 ps 1 pn 20 lw 1.5 title 'Greedy', ");
-        if (b.dualThres)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'orange' pt 1 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    if (b.eGreedy) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'red' pt 2 ps 1 pn 20 lw 1.5 title 'eGreedy', ");
-        if (b.dualThres)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'red' pt 2 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    if (b.succElim) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'cyan' pt 3 ps 1 pn 20 lw 1.5 title "
-                         "'Successive Elimination', ");
-        if (b.dualThres)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'cyan' pt 3 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    if (b.ucb1) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'blue' pt 4 ps 1 pn 20 lw 1.5 title 'UCB1', ");
-        if (b.dualThres)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'blue' pt 4 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    if (b.ucb2) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'purple' pt 5 ps 1 pn 20 lw 1.5 title 'UCB2', ");
-        if (b.dualThres)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'purple' pt 5 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    if (b.exp3) {
-        fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'green' pt 6 ps 1 pn 20 lw 1.5 title 'EXP3', ");
-        if (b.dualThres)
-            fprintf(gnuplot, "'-' using 1:2 with linespoints lc rgb 'green' pt 6 ps 1 pn 20 lw 1.5 notitle, ");
-    }
-
-    fprintf(gnuplot, "\n");
-
-    if (b.medianOpt || b.bestHandOpt) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, optLow[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres && !b.medianOpt) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, optHigh[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    if (b.median && !b.medianOpt) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, median[t]);
-        }
-        fprintf(gnuplot, "e\n");
-    }
-
-    if (b.greedy) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, greedyLow[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, greedyHigh[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    if (b.eGreedy) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, eGreedyLow[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, eGreedyHigh[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    if (b.succElim) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, succElimLow[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, succElimHigh[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    if (b.ucb1) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, ucb1Low[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, ucb1High[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    if (b.ucb2) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, ucb2Low[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, ucb2High[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    if (b.exp3) {
-        for (uint64_t t = 0; t < b.T; t += step) {
-            fprintf(gnuplot, "%lu %lf\n", t, exp3Low[t]);
-        }
-        fprintf(gnuplot, "e\n");
-        if (b.dualThres) {
-            for (uint64_t t = 0; t < b.T; t += step) {
-                fprintf(gnuplot, "%lu %lf\n", t, exp3High[t]);
-            }
-            fprintf(gnuplot, "e\n");
-        }
-    }
-
-    fflush(gnuplot);
-    pclose(gnuplot);
+void freeRunningStats(RunningStats *stats) {
+    free(stats->mean);
+    free(stats->m2);
 }
 
-void saveResults(char *filepath, Bandit b, char *resultType, double *median, double *greedy, double *eGreedy,
-                 double *succElim, double *ucb1, double *ucb2, double *exp3) {
-
-    char resultPath[256] = "prophetResults/";
-    char temp[256];
-    strcpy(temp, filepath);
-    char *dataName = basename(temp);
-    char *dot = strrchr(dataName, '.');
-    if (dot)
-        *dot = '\0';
-
-    char params[256];
-    snprintf(params, sizeof(params), "K%u", b.thresholds);
-    if (b.dualThres)
-        strcat(params, "d");
-    if (b.dynamicThres)
-        strcat(params, "D");
-    if (b.medianOpt)
-        strcat(params, "o");
-    if (b.bestHandOpt)
-        strcat(params, "O");
-    if (b.keepItems)
-        strcat(params, "k");
-
-    strcat(resultPath, dataName);
-    strcat(resultPath, "/");
-    strcat(resultPath, params);
-    strcat(resultPath, "/");
-
-    if (b.median)
-        saveAlgResults(resultPath, b, "median", resultType, median);
-
-    if (b.greedy)
-        saveAlgResults(resultPath, b, "greedy", resultType, greedy);
-
-    if (b.eGreedy)
-        saveAlgResults(resultPath, b, "eGreedy", resultType, eGreedy);
-
-    if (b.succElim)
-        saveAlgResults(resultPath, b, "succElim", resultType, succElim);
-
-    if (b.ucb1)
-        saveAlgResults(resultPath, b, "ucb1", resultType, ucb1);
-
-    if (b.ucb2)
-        saveAlgResults(resultPath, b, "ucb2", resultType, ucb2);
-
-    if (b.exp3)
-        saveAlgResults(resultPath, b, "exp3", resultType, exp3);
+double getVariance(RunningStats *stats, uint64_t i) {
+    if (stats->count < 2) {
+        return 0;
+    }
+    return stats->m2[i] / (double) (stats->count - 1);
 }
 
-void saveAlgResults(char *resultPath, Bandit b, char *algName, char *resultType, double *result) {
-    char algResultPath[256];
-    strcpy(algResultPath, resultPath);
-    strcat(algResultPath, algName);
-
-    mkdir_p(algResultPath);
-
-    strcat(algResultPath, "/");
-    strcat(algResultPath, resultType);
-    strcat(algResultPath, ".txt");
-
-    FILE *file = fopen(algResultPath, "w");
-    if (!file) {
-        printf("Error opening file");
+void mergeRunningStats(RunningStats *stats, RunningStats *other, uint64_t size) {
+    if (!other->count) {
         return;
     }
 
-    for (uint64_t t = 0; t < b.T; t++) {
-        fprintf(file, "%lu %lf\n", t, result[t]);
+    // the pairwise update of Chan et al., which gives the stats of both sets of runs as if they were added one by one
+    uint64_t count = stats->count + other->count;
+    double weight = (double) other->count / (double) count;
+    double product = (double) stats->count * (double) other->count / (double) count;
+    for (uint64_t i = 0; i < size; i++) {
+        double delta = other->mean[i] - stats->mean[i];
+        stats->mean[i] += delta * weight;
+        stats->m2[i] += other->m2[i] + delta * delta * product;
     }
-    fclose(file);
+    stats->count = count;
 }
 
 void mkdir_p(char *path) {